@@ -0,0 +1,204 @@
+/*
+ * check_skytrack.c - check skytrack_angles() against published reference
+ * values for single-axis trackers.
+ *
+ * The flat ground cases are those of the pvlib-python test suite
+ * (pvlib/tests/test_tracking.py). The sloping ground case is the validation
+ * data set of K. Anderson and M. Mikofski, "Slope-Aware Backtracking for
+ * Single-Axis Trackers", NREL/TP-5K00-76626 (2020), also used by pvlib. There
+ * is no published table for a steeply tilted axis, so for that case the
+ * expected angles are worked out here from published formulae instead (see
+ * checkSteepAxis()). The program prints each case, and exits with status 1 if
+ * any result differs from its expected value by more than the tolerance.
+ *
+ * Build (from the src directory) with, for example:
+ *   cc -O2 -I. ../examples/check_skytrack.c skytrack.c sky-site.c
+ *      sky-time.c vectors3d.c -lm
+ */
+#include <math.h>
+#include <stdio.h>
+
+#include "astron.h"
+#include "sky.h"
+#include "skytrack.h"
+#include "vectors3d.h"
+
+#define ANGLE_TOL_deg   0.01
+#define FRACTION_TOL    1e-4
+
+static int failCount = 0;
+
+
+
+static void check(const char *what, double value, double expected, double tol)
+/*! Print a result and its reference value, and count it if they differ by
+ *  more than \a tol
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    bool ok = fabs(value - expected) <= tol;
+
+    printf("  %-34s %10.4f  expected %10.4f  %s\n",
+           what, value, expected, ok ? "ok" : "FAIL");
+    if (!ok) {
+        failCount++;
+    }
+}
+
+
+
+static void angles(double elevation_deg, double azimuth_deg,
+                   const SkyTrack_Row *row,
+                   double *ideal_deg, double *rotation_deg, double *shaded)
+/*! Call skytrack_angles() for the Sun at the given elevation and azimuth, and
+ *  convert its angles to degrees
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    V3D_Vector sunV;
+    double     ideal_rad, rotation_rad;
+
+    v3d_polarToRect(&sunV, degToRad(azimuth_deg), degToRad(elevation_deg));
+    skytrack_angles(&sunV, row, &ideal_rad, &rotation_rad, shaded);
+    *ideal_deg = radToDeg(ideal_rad);
+    *rotation_deg = radToDeg(rotation_rad);
+}
+
+
+
+static void checkFlatGround(void)
+/*! Horizontal axis on flat ground, GCR 2/7 (pvlib test_tracking.py)
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    SkyTrack_Row row;
+    double       ideal, rotation, shaded;
+
+    printf("Flat ground, horizontal axis\n");
+
+    /* test_solar_noon: zenith 10°, azimuth 180°, axis azimuth 0° */
+    skytrack_setupRow(0.0, 0.0, 2.0 / 7.0, 0.0, 0.0, 90.0, true, &row);
+    angles(80.0, 180.0, &row, &ideal, &rotation, &shaded);
+    check("solar noon: rotation", rotation, 0.0, ANGLE_TOL_deg);
+
+    /* test_azimuth_north_south: zenith 60°, azimuth 90°. The sign of the
+       rotation depends on which way the axis azimuth is given */
+    skytrack_setupRow(180.0, 0.0, 2.0 / 7.0, 0.0, 0.0, 90.0, true, &row);
+    angles(30.0, 90.0, &row, &ideal, &rotation, &shaded);
+    check("axis azimuth 180°: rotation", rotation, -60.0, ANGLE_TOL_deg);
+    check("axis azimuth 180°: shaded", shaded, 0.0, FRACTION_TOL);
+    skytrack_setupRow(0.0, 0.0, 2.0 / 7.0, 0.0, 0.0, 90.0, true, &row);
+    angles(30.0, 90.0, &row, &ideal, &rotation, &shaded);
+    check("axis azimuth 0°: rotation", rotation, 60.0, ANGLE_TOL_deg);
+
+    /* test_max_angle: the same Sun, with a 45° limit */
+    skytrack_setupRow(0.0, 0.0, 2.0 / 7.0, 0.0, 0.0, 45.0, true, &row);
+    angles(30.0, 90.0, &row, &ideal, &rotation, &shaded);
+    check("45° limit: ideal", ideal, 60.0, ANGLE_TOL_deg);
+    check("45° limit: rotation", rotation, 45.0, ANGLE_TOL_deg);
+
+    /* test_backtrack: zenith 80°, azimuth 90°, without and with
+       backtracking. Without, the adjacent row's shadow covers
+       1 - cos(80°) / GCR of the collectors */
+    skytrack_setupRow(0.0, 0.0, 2.0 / 7.0, 0.0, 0.0, 90.0, false, &row);
+    angles(10.0, 90.0, &row, &ideal, &rotation, &shaded);
+    check("true tracking: rotation", rotation, 80.0, ANGLE_TOL_deg);
+    check("true tracking: shaded", shaded,
+          1.0 - 3.5 * cos(degToRad(80.0)), FRACTION_TOL);
+    skytrack_setupRow(0.0, 0.0, 2.0 / 7.0, 0.0, 0.0, 90.0, true, &row);
+    angles(10.0, 90.0, &row, &ideal, &rotation, &shaded);
+    check("backtracking: rotation", rotation, 27.42833, ANGLE_TOL_deg);
+    check("backtracking: shaded", shaded, 0.0, FRACTION_TOL);
+}
+
+
+
+static void checkSlopingGround(void)
+/*! Tilted axis on ground sloping 10° to the south, GCR 0.5
+ *  (NREL/TP-5K00-76626, and pvlib test_slope_aware_backtracking). Times are
+ *  hourly from 08:00 to 17:00 on 2019 January 1, but only the Sun's position
+ *  matters here.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    static const struct {
+        double elevation_deg;
+        double azimuth_deg;
+        double trueTracking_deg;
+        double backtracking_deg;
+    } ref[] = {
+        {  2.404287, 122.791770, -84.440, -10.899 },
+        { 11.263058, 133.288729, -72.604, -25.747 },
+        { 18.733558, 145.285552, -59.861, -59.861 },
+        { 24.109076, 158.939435, -45.578, -45.578 },
+        { 26.810735, 173.931802, -28.764, -28.764 },
+        { 26.482495, 189.371536,  -8.475,  -8.475 },
+        { 23.170447, 204.136810,  15.120,  15.120 },
+        { 17.296785, 217.446538,  39.562,  39.562 },
+        {  9.461862, 229.102218,  61.587,  32.339 },
+        {  0.524817, 239.330401,  79.530,   5.490 }
+    };
+    SkyTrack_Row trueRow, backRow;
+    double       ideal, rotation, shaded;
+    char         label[40];
+    int          i;
+
+    printf("Sloping ground, tilted axis\n");
+    skytrack_setupRow(195.0, 9.666, 0.5, 180.0, 10.0, 90.0, false, &trueRow);
+    skytrack_setupRow(195.0, 9.666, 0.5, 180.0, 10.0, 90.0, true, &backRow);
+    check("cross-axis slope", radToDeg(backRow.crossSlope_rad), -2.576,
+          ANGLE_TOL_deg);
+
+    for (i = 0; i < (int)(sizeof(ref) / sizeof(ref[0])); i++) {
+        angles(ref[i].elevation_deg, ref[i].azimuth_deg, &trueRow,
+               &ideal, &rotation, &shaded);
+        sprintf(label, "%02d:00 true tracking", i + 8);
+        check(label, rotation, ref[i].trueTracking_deg, ANGLE_TOL_deg);
+        angles(ref[i].elevation_deg, ref[i].azimuth_deg, &backRow,
+               &ideal, &rotation, &shaded);
+        sprintf(label, "%02d:00 backtracking", i + 8);
+        check(label, rotation, ref[i].backtracking_deg, ANGLE_TOL_deg);
+    }
+}
+
+
+
+static void checkSteepAxis(void)
+/*! An axis tilted 60° to the south, GCR 0.4, with the Sun low in the
+ *  east-north-east, so that the ideal angle is more than 90° from the plane of
+ *  the ground. There is no published value for this case. Instead the
+ *  expected ideal angle comes from the true-tracking formula of W. Marion and
+ *  A. Dobos, "Rotation Angle for the Optimum Tracking of One-Axis Trackers",
+ *  NREL/TP-6A20-58891 (2013), and the expected backtracking angle from the
+ *  correction acos(|cos θT| / GCR) of Anderson and Mikofski (with no
+ *  cross-axis slope). The row must be turned back towards the plane of the
+ *  ground by that much, never past the Sun.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    const double tilt_rad = degToRad(60.0);
+    const double zenith_rad = degToRad(80.0);
+    const double relAz_rad = degToRad(70.0 - 180.0);  // Sun az - axis az
+    SkyTrack_Row row;
+    double       ideal, rotation, shaded;
+    double       expected;
+
+    printf("Steeply tilted axis, Sun behind\n");
+    skytrack_setupRow(180.0, 60.0, 0.4, 0.0, 0.0, 180.0, true, &row);
+    angles(10.0, 70.0, &row, &ideal, &rotation, &shaded);
+    expected = radToDeg(atan2(sin(zenith_rad) * sin(relAz_rad),
+                              sin(zenith_rad) * cos(relAz_rad) * sin(tilt_rad)
+                              + cos(zenith_rad) * cos(tilt_rad)));
+    check("ideal", ideal, expected, ANGLE_TOL_deg);
+    /* The ideal angle is negative, so the row is turned back the other way */
+    expected += radToDeg(acos(fabs(cos(degToRad(expected))) / 0.4));
+    check("backtracking: rotation", rotation, expected, ANGLE_TOL_deg);
+    check("backtracking: shaded", shaded, 0.0, FRACTION_TOL);
+}
+
+
+
+int main(void)
+{
+    checkFlatGround();
+    checkSlopingGround();
+    checkSteepAxis();
+
+    printf("%d failures\n", failCount);
+    return (failCount == 0) ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+/*
+ * stress_skyfast_threads.c - stress test of the handover of precalculated
+ * positions between the two threads of a Skyfast_Context (POSIX_THREADS).
+ *
+ * A tracking thread calls skyfast_ctxGetApprox() at 10 kHz, while a background
+ * thread calls skyfast_ctxBackgroundUpdate() as fast as it can. The simulated
+ * time runs much faster than real time, the background calculations are made
+ * artificially slow, and the context holds only the minimum of four positions,
+ * so the tracking thread keeps catching up with the position being written.
+ * (So many of the positions are fully calculated by the tracking thread, as
+ * reported at the end.) Every interpolated position is checked for signs of a
+ * torn read (a position made partly of one node and partly of another). The
+ * program exits with status 1 if any is found.
+ *
+ * Build (from the src directory) with, for example:
+ *   cc -O2 -DPOSIX_THREADS -I. ../examples/stress_skyfast_threads.c
+ *      skyfast.c sky-time.c vectors3d.c -lpthread -lm
+ * and run with an optional duration in seconds (default 10).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "astron.h"
+#include "sky.h"
+#include "skyfast.h"
+
+#ifndef POSIX_THREADS
+#error "Compile this program with POSIX_THREADS defined"
+#endif
+
+#define READ_PERIOD_ns      100000L     /* 10 kHz */
+#define RECALC_mins         1           /* Time between nodes (simulated) */
+#define SIM_STEP_d          (3.0 / 86400.0) /* Simulated time per read */
+#define NODE_ANGLE_rad      0.1         /* Motion of object between nodes */
+#define SPIN_COUNT          100000      /* Delay between field writes */
+
+static atomic_bool  stopWriter;
+static _Thread_local bool isWriter;     /* True in the background thread only */
+static const double nodeInterval_cy = RECALC_mins / (1440.0 * JUL_CENT);
+
+
+
+static void spin(void)
+/*! Waste a little time in the background thread, so that writing a node takes
+ *  about as long as the tracking thread takes to use one up. The tracking
+ *  thread then often catches up with the node being written, which is where a
+ *  torn read would show up. (In the tracking thread, which only calculates a
+ *  node when the background thread has fallen behind, don't waste any time.)
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    volatile int i;
+
+    if (!isWriter) {
+        return;
+    }
+    for (i = 0; i < SPIN_COUNT; i++) {
+        ;
+    }
+}
+
+
+
+static void syntheticObject(double j2kTT_cy, Sky_TrueEquatorial *pos)
+/*! A made-up object that moves NODE_ANGLE_rad around the equator between one
+ *  node and the next. The time is also stored in the distance and equation of
+ *  the equinoxes fields, so that an interpolated position can be checked
+ *  against the time it was requested for. The fields are written slowly, one
+ *  at a time.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double angle_rad = j2kTT_cy / nodeInterval_cy * NODE_ANGLE_rad;
+
+    pos->timestamp_cy = j2kTT_cy;
+    spin();
+    pos->appCirsV.a[0] = cos(angle_rad);
+    spin();
+    pos->appCirsV.a[1] = sin(angle_rad);
+    spin();
+    pos->appCirsV.a[2] = 0.0;
+    spin();
+    pos->distance_au = j2kTT_cy;
+    spin();
+    pos->eqEq_rad = j2kTT_cy;
+}
+
+
+
+static void *writer(void *arg)
+/*! The background thread
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    Skyfast_Context *ctx = arg;
+
+    isWriter = true;
+    while (!atomic_load(&stopWriter)) {
+        skyfast_ctxBackgroundUpdate(ctx);
+    }
+    return NULL;
+}
+
+
+
+static bool isTorn(double t_cy, const Sky_TrueEquatorial *approx)
+/*! Check an interpolated position for consistency with the time requested.
+ *  Linear interpolation of the synthetic object's fields reproduces the time
+ *  exactly (apart from rounding) in the distance and eqEq fields, and gives a
+ *  vector whose magnitude is between cos(NODE_ANGLE_rad / 2) and 1, pointing
+ *  in very nearly the expected direction. A node that was read while it was
+ *  being written, or a mixture of two nodes, fails at least one of these.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    const double timeTol_cy = 1e-6 * nodeInterval_cy;
+    double mag;
+    double angle_rad;
+    double expected_rad;
+
+    mag = sqrt(approx->appCirsV.a[0] * approx->appCirsV.a[0]
+               + approx->appCirsV.a[1] * approx->appCirsV.a[1]
+               + approx->appCirsV.a[2] * approx->appCirsV.a[2]);
+    angle_rad = atan2(approx->appCirsV.a[1], approx->appCirsV.a[0]);
+    expected_rad = t_cy / nodeInterval_cy * NODE_ANGLE_rad;
+
+    return (fabs(approx->distance_au - t_cy) > timeTol_cy)
+           || (fabs(approx->eqEq_rad - t_cy) > timeTol_cy)
+           || (mag > 1.0 + 1e-9)
+           || (mag < cos(0.5 * NODE_ANGLE_rad) - 1e-9)
+           || (fabs(remainder(angle_rad - expected_rad, TWOPI)) > 1e-3)
+           || (fabs(approx->appCirsV.a[2]) > 0.0);
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    static Skyfast_Context ctx;
+    Sky_DeltaTs         deltaTs;
+    Sky_TrueEquatorial  approx;
+    Sky_Times           atime;
+    pthread_t           thread;
+    struct timespec     next;
+    double              j2kUtc_d;
+    long                reads;
+    long                readCount;
+    long                tornCount = 0;
+
+    readCount = (argc > 1) ? atol(argv[1]) * (1000000000L / READ_PERIOD_ns)
+                           : 10 * (1000000000L / READ_PERIOD_ns);
+
+    sky_initTime(37, 0.0, &deltaTs);
+    j2kUtc_d = 9000.0;
+    skyfast_ctxInit(&ctx, j2kUtc_d, RECALC_mins, SKYFAST_LINEAR,
+                    SKYFAST_DEFAULT_NODES, &deltaTs, &syntheticObject);
+
+    atomic_store(&stopWriter, false);
+    if (pthread_create(&thread, NULL, writer, &ctx) != 0) {
+        fprintf(stderr, "Cannot create background thread\n");
+        return 2;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (reads = 0; reads < readCount; reads++) {
+        sky_updateTimes(j2kUtc_d, &deltaTs, &atime);
+        skyfast_ctxGetApprox(&ctx, atime.j2kTT_cy, &approx);
+        if (isTorn(atime.j2kTT_cy, &approx)) {
+            tornCount++;
+            fprintf(stderr, "Torn read %ld at t = %.12f cy: vector (%.9f %.9f "
+                    "%.9f), distance %.12f, eqEq %.12f\n", reads,
+                    atime.j2kTT_cy, approx.appCirsV.a[0], approx.appCirsV.a[1],
+                    approx.appCirsV.a[2], approx.distance_au, approx.eqEq_rad);
+        }
+        j2kUtc_d += SIM_STEP_d;
+
+        /* Wait for the next 10 kHz tick */
+        next.tv_nsec += READ_PERIOD_ns;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+
+    atomic_store(&stopWriter, true);
+    pthread_join(thread, NULL);
+
+    printf("%ld reads, %ld torn, %ld full calculations by the tracking "
+           "thread\n", reads, tornCount, skyfast_ctxFallbackCount(&ctx));
+    return (tornCount == 0) ? 0 : 1;
+}
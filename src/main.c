@@ -282,5 +282,13 @@ void demo2(void)
  *                      Repeated calculation of the Sun's position for three
  *                      European sites simultaneously. This demo also shows the
  *                      use of the sky_initTimeDetailed() function.
+ *  \example stress_skyfast_threads.c
+ *                      Stress test of the handover of positions between the
+ *                      tracking thread and the background thread of a
+ *                      Skyfast_Context (POSIX_THREADS). A standalone program.
+ *  \example check_skytrack.c
+ *                      Check of skytrack_angles() against published reference
+ *                      values for single-axis trackers, on flat and sloping
+ *                      ground. A standalone program.
  */
  
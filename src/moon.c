@@ -56,6 +56,16 @@
  */
 DEFINE_THIS_FILE;                       /* For use by REQUIRE() - assertions. */
 
+/*      Unrefracted elevation of the Moon's centre at rise and set: -50′, from a
+        refraction of 34′ at the horizon and a semi-diameter of 16′ */
+#define MOON_RISESET_EL_RAD     (-50.0 / 60.0 * DEG2RAD)
+#define MOON_SEMIDIAMETER_RAD   (16.0 / 60.0 * DEG2RAD)
+
+/*      Limits on the iterations of moon_riseSetMask() after the first
+        estimates */
+#define MASK_ITERATIONS         10
+#define MASK_TOLERANCE_d        (0.1 / 86400.0)
+
 typedef struct {
     double lp_rad;  // L' - Mean Longitude of the Moon (radian)
     double d_rad;   // D  - Mean Elongation of the Moon from the Sun (radian)
@@ -116,7 +126,9 @@ LOCAL double riseSetApprox(double             risesetGuess_d,
                            bool               getMoonrise,
                            const Sky_DeltaTs  *deltas,
                            const Sky_SiteProp *site,
-                           Sky_SiteHorizon    *topo);
+                           const Sky_HorizonMask *mask,
+                           Sky_SiteHorizon    *topo,
+                           bool               *found);
 
 /*
  * Global variables accessible by other modules
@@ -376,7 +388,8 @@ GLOBAL double moon_riseSet(int                   year,
 
     /* Iterate to settle on a time. */
     for (i = 0; i < 3; i++) {
-        estimate_d = riseSetApprox(estimate_d, getMoonrise, deltas,&st, &topo1);
+        estimate_d = riseSetApprox(estimate_d, getMoonrise, deltas, &st,
+                                   NULL, &topo1, NULL);
         if (estimate_d == 0.0) {
             /* Error in calculations on the requested day.
                Don't try another iteration. */
@@ -390,6 +403,108 @@ GLOBAL double moon_riseSet(int                   year,
     return estimate_d;
 }
 
+
+
+GLOBAL double moon_riseSetMask(int                   year,
+                               int                   month,
+                               int                   day,
+                               bool                  getMoonrise,
+                               const Sky_DeltaTs     *deltas,
+                               const Sky_SiteProp    *site,
+                               const Sky_HorizonMask *mask,
+                               Sky_SiteHorizon       *topo)
+/*! Routine to calculate the time at which the Moon's upper limb appears above
+    (or disappears below) the local horizon - terrain, buildings etc. - on the
+    day specified by \a year, \a month and \a day. This is the same as
+    moon_riseSet(), except that the horizon is described by a horizon mask,
+    rather than being flat.
+ \returns                Moonrise (or moonset) time, as for moon_riseSet(), or
+                         0.0 if the calculation fails (e.g. the Moon does not
+                         clear the local horizon)
+ \param[in]  year, month, day
+                         Date for which moonrise or moonset time is desired
+ \param[in]  getMoonrise If true, get moonrise time. If false, get moonset time
+ \param[in]  deltas      Delta T values, as for moon_riseSet()
+ \param[in]  site        Properties of the observing site, as for
+                         moon_riseSet()
+ \param[in]  mask        Horizon mask for the site, as set up by
+                         sky_setHorizonMask() or skysites_loadHorizon(), or
+                         NULL for a flat horizon
+ \param[out] topo        \b Optional. Topocentric position of the Moon at rise
+                         or set, as for moon_riseSet(). May be NULL.
+
+    Each iteration looks up the elevation of the horizon at the Moon's latest
+    azimuth, and finds when the Moon reaches that elevation, allowing for
+    refraction as described in sky_horizonRiseSetEl_rad(). It starts from the
+    flat-horizon estimate of moon_riseSet(), and speeds up the later iterations
+    with the secant method, as the azimuth must settle as well as the time.
+
+ \note
+    As for sun_riseSetMask(), if the local horizon has peaks and gaps, this
+    finds the crossing near where the Moon would rise (or set) over a flat
+    horizon.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    Sky_SiteHorizon topo1;      // Moon apparent position
+    Sky_SiteProp    st;         // copy of site details, without refraction
+    double          t0_d, t1_d; // Two latest estimates of the time
+    double          r0_d, r1_d; // Correction riseSetApprox() gives to each
+    double          next_d;     // Improved estimate from riseSetApprox()
+    bool            found;      // Moon rises (or sets) at all
+    int             i;
+
+    REQUIRE_NOT_NULL(deltas);
+    REQUIRE_NOT_NULL(site);
+
+    /* Unrefracted positions, as for moon_riseSet() */
+    st = *site;
+    st.refracPT = 0.0;
+
+    t1_d = sky_calTimeToJ2kd(year, month, day,
+                             12, 0, 0.0, site->timeZone_d * 24.0);
+    /* First estimates, over a flat horizon, as the Moon's azimuth at civil noon
+       says little about its azimuth at rise or set */
+    found = true;
+    for (i = 0; (i < 3) && found; i++) {
+        t1_d = riseSetApprox(t1_d, getMoonrise, deltas, &st, NULL, &topo1,
+                             &found);
+    }
+    if (!found || (mask == NULL)) {
+        /* No rise (or set), or flat horizon: we already have the answer */
+        if (topo != NULL) {
+            *topo = topo1;
+        }
+        return t1_d;
+    }
+
+    /* Then refine, with the horizon at the Moon's azimuth, using the secant
+       method to find where the correction riseSetApprox() gives is zero */
+    t0_d = t1_d;
+    r0_d = 0.0;
+    for (i = 0; i < MASK_ITERATIONS; i++) {
+        next_d = riseSetApprox(t1_d, getMoonrise, deltas, &st, mask, &topo1,
+                               &found);
+        if (!found) {
+            t1_d = 0.0;                 // Moon does not clear the horizon
+            break;
+        }
+        r1_d = next_d - t1_d;
+        if (fabs(r1_d) < MASK_TOLERANCE_d) {
+            t1_d = next_d;
+            break;
+        }
+        next_d = sky_horizonRiseSetStep_d(t0_d, r0_d, t1_d, r1_d);
+        t0_d = t1_d;
+        r0_d = r1_d;
+        t1_d = next_d;
+    }
+
+    if (topo != NULL) {
+        *topo = topo1;
+    }
+    return t1_d;
+}
+
 /*
  *------------------------------------------------------------------------------
  *
@@ -660,7 +775,9 @@ LOCAL double riseSetApprox(double             risesetGuess_d,
                            bool               getMoonrise,
                            const Sky_DeltaTs  *deltas,
                            const Sky_SiteProp *site,
-                           Sky_SiteHorizon    *topo)
+                           const Sky_HorizonMask *mask,
+                           Sky_SiteHorizon    *topo,
+                           bool               *found)
 /* Routine to calculate the time of Moon rise or set for the day specified by
    MJDrisesetGuess. The result returned is an approximate value, whose accuracy
    depends upon how close MJDrisesetGuess is to true Moon rise or set time.
@@ -679,8 +796,12 @@ LOCAL double riseSetApprox(double             risesetGuess_d,
                       site->refracPT will be set to 0.0 before calling this
                       routine, in order to calculate an unrefracted position of
                       the Moon (as per note below).
+    mask            - horizon mask, or NULL for the usual flat horizon (with
+                      the Moon's centre at -50 arcminutes, unrefracted)
  Output
     topo            - Topocentric position of Moon at approx. rise or set time
+    found           - If not NULL, set to false if the moon does not rise (or
+                      set) on this date, or to true if it does
 
    Moonrise and set calculations assume a standard refraction at the horizon of
    34 arcminutes, and a moon semi-diameter of 16 arcminutes. So the calculation
@@ -692,19 +813,30 @@ LOCAL double riseSetApprox(double             risesetGuess_d,
     double     ha2_rad;        // Hour angle of Moon at horizon (radian)
     double     cosHa2;         // Cos(Hour Angle) at horizon
     double     riseSetApprox_d;// Improved estimate of rise or set time
+    double     targetEl_rad;   // Unrefracted elevation at rise or set (rad)
 
     moon_nrelTopocentric(risesetGuess_d, deltas, site, topo);
     sky_siteAzElToHaDec(&topo->rectV, site, &ha1_rad, &dec_rad);
+    if (mask == NULL) {
+        targetEl_rad = MOON_RISESET_EL_RAD;
+    } else {
+        targetEl_rad = sky_horizonRiseSetEl_rad(mask, topo->azimuth_rad,
+                                                MOON_SEMIDIAMETER_RAD);
+    }
 
     /* Assuming the Moon's declination remains constant over the period, find
-     * out where dec circle intersects the Elevation = -50 arcminutes circle.
+     * out where dec circle intersects the Elevation = targetEl_rad (usually
+     * -50 arcminutes) circle.
      * Of course the declination does not remain constant, so this estimate of
      * Hour Angle is approximate, but it will be a better estimate than
      * ha1_rad.  */
-    cosHa2 = (sin(degToRad(-50.0/60.0)) - sin(site->astLat_rad) * sin(dec_rad))
+    cosHa2 = (sin(targetEl_rad) - sin(site->astLat_rad) * sin(dec_rad))
              / (cos(site->astLat_rad) * cos(dec_rad));
     /* If there is no intersection, the Moon either doesn't rise or doesn't set
        on this day at this latitude. (In practice, does this ever happen?) */
+    if (found != NULL) {
+        *found = !(fabs(cosHa2) > 1.0);
+    }
     if (fabs(cosHa2) > 1.0) {
         riseSetApprox_d = 0.0;
     } else {
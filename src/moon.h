@@ -76,6 +76,14 @@ double moon_riseSet(int                year,
                     const Sky_DeltaTs  *deltas,
                     const Sky_SiteProp *site,
                     Sky_SiteHorizon *topo);
+double moon_riseSetMask(int                   year,
+                        int                   month,
+                        int                   day,
+                        bool                  getMoonrise,
+                        const Sky_DeltaTs     *deltas,
+                        const Sky_SiteProp    *site,
+                        const Sky_HorizonMask *mask,
+                        Sky_SiteHorizon       *topo);
 
 /*
  * Global variables accessible by other modules
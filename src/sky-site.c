@@ -59,10 +59,50 @@ DEFINE_THIS_FILE;                       /* For use by REQUIRE() - assertions */
         this correction). */
 /*--- #define SPA_COMPARISONS ---*/
 
+/*      Refraction tables. These are evenly spaced in tan(ζ/2), where ζ is the
+        zenith distance, from the zenith to -2° elevation (ζ = 92°). This
+        quantity is easily found from a unit vector (x, y, z) as
+        sqrt(x² + y²) / (1 + z), and it is nearly proportional to ζ. No
+        refraction is applied below -2° */
+#define REFRAC_TABLE_STEPS  1024
+#define REFRAC_TABLE_MAX    1.0355303137905696      /* tan(46°) */
+
+/*      Refraction at the horizon assumed by the rise and set calculations */
+#define HORIZON_REFRACTION_RAD  (34.0 / 60.0 * DEG2RAD)
+
+/*      Smallest difference between successive estimates (or their corrections)
+        of a rise or set time for which sky_horizonRiseSetStep_d() trusts the
+        secant method: one thousandth of the tolerance of the iterations in
+        sun_riseSetMask() and moon_riseSetMask() */
+#define SECANT_MIN_d        (1e-4 / 86400.0)
+
+/*      Limits for removing refraction by iteration (see unrefractVector()) */
+#define UNREFRAC_MAX_ITER   30
+#define UNREFRAC_TOL_RAD    1e-12
+
 /*
  * Prototypes for local functions (not called from other modules).
  */
 LOCAL void createAzElBaseM(Sky_SiteProp *site);
+LOCAL void applyRefraction(Sky_RefractionModel model,
+                           double              refracPT,
+                           Sky_SiteHorizon     *topo);
+LOCAL void refractVector(Sky_RefractionModel model,
+                         double              refracPT,
+                         V3D_Vector          *topoV);
+LOCAL void unrefractVector(Sky_RefractionModel model,
+                           double              refracPT,
+                           V3D_Vector          *topoV);
+LOCAL double tableRefraction_rad(Sky_RefractionModel model,
+                                 double              refracPT,
+                                 double              w,
+                                 double              sinEl);
+LOCAL void tiltUnitVector(double dEl_rad, double w, V3D_Vector *topoV);
+LOCAL void removeParallax(double             dist_au,
+                          const Sky_SiteProp *site,
+                          V3D_Vector         *topoV);
+LOCAL void buildRefracTable(Sky_RefractionModel model);
+LOCAL double refraction_rad(Sky_RefractionModel model, double el_rad);
 
 /*
  * Global variables accessible by other modules
@@ -72,6 +112,9 @@ LOCAL void createAzElBaseM(Sky_SiteProp *site);
 /*
  * Local variables (not accessed by other modules)
  */
+LOCAL double refracTable[SKY_REFRAC_MODEL_COUNT][REFRAC_TABLE_STEPS + 1];
+LOCAL bool   refracTableBuilt[SKY_REFRAC_MODEL_COUNT];
+
 #ifndef SPA_COMPARISONS
 /*      Constants found in the 2007 Astronomical Almanac, pages K6 & K7 */
 LOCAL const double c_kmps = 299792.458;      // speed of light (km/s)
@@ -251,6 +294,8 @@ GLOBAL void sky_setSiteLoc2(double astLat_deg,
     /* 6. Other initialisations, in case sky_setSiteTempPressure() or
        sky_setSiteTimeZone() don't get called. */
     site->refracPT = 1.0;               // Default to 10 °C and 1010 hPa
+    site->refracModel = SKY_REFRAC_TWO_FORMULA;
+    buildRefracTable(site->refracModel);
     site->timeZone_d = 0.0;             // Default to UTC.
 
     site->azElM = &site->azElBaseM;     // Assume no polar motion correction
@@ -286,6 +331,49 @@ GLOBAL void sky_setSiteTempPress(double temperature_degC,
     t = 283.0 / (273.0 + temperature_degC);
     p = pressure_hPa / 1010.0;
     site->refracPT = p * t;
+    buildRefracTable(site->refracModel);
+}
+
+
+
+GLOBAL void sky_setSiteRefraction(Sky_RefractionModel model,
+                                  Sky_SiteProp        *site)
+/*! Select the atmospheric refraction model used for this site.
+ \param[in]  model  One of
+                      - SKY_REFRAC_TWO_FORMULA: two simple formulae, one
+                        above 15° elevation and one below. This is the default.
+                      - SKY_REFRAC_SPA: the formula used by the NREL Solar
+                        Position Algorithm (Sæmundsson's formula)
+                      - SKY_REFRAC_BENNETT: Bennett's formula, which gives
+                        the refraction as a function of apparent elevation,
+                        inverted numerically
+                      .
+                      All of these are scaled for the temperature and pressure
+                      set by sky_setSiteTempPress(), and none applies any
+                      refraction below -2° elevation.
+ \param[out] site   field \a refracModel
+
+    Each model's refraction is calculated once, at standard temperature and
+    pressure, into a table of 1025 values (about 0.1° apart), shared by all
+    sites using that model. sky_siteTirsToTopo() and the other
+    topocentric conversion functions interpolate in this table, scale the
+    result by the site's \a refracPT, and apply it to the position vector
+    directly. The interpolation adds less than 0.03 arcseconds of error above
+    15° elevation, and less than 0.1 arcseconds down to the horizon (see
+    \ref page-refraction).
+
+ \par When to call this function
+    At program initialisation time, after calling sky_setSiteLocation() (or
+    sky_setSiteLoc2()), if you want a model other than the default. As the
+    table is built on first use, call it before starting any other threads
+    that use site functions.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    REQUIRE_NOT_NULL(site);
+    REQUIRE((model >= 0) && (model < SKY_REFRAC_MODEL_COUNT));
+
+    site->refracModel = model;
+    buildRefracTable(model);
 }
 
 
@@ -409,21 +497,65 @@ GLOBAL void sky_siteTirsToTopo(const V3D_Vector   *terInterV,
     If you wish to calculate the position of the object as seen from multiple
     sites simultaneously, you need to call this function once for each of those
     sites, passing the relevant \a site data block to each call.
+ \par
+    If you only need the direction vector, and not the azimuth and elevation
+    angles, call sky_siteTirsToTopoV() instead.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 {
-    double dEl_rad;         // Change in elevation from refraction (radian)
-    double w;
-    double tanZd;           // Tangent of zenith distance
+    REQUIRE_NOT_NULL(topo);
+
+    sky_siteTirsToTopoV(terInterV, dist_au, site, &topo->rectV);
+    v3d_rectToPolar(&topo->azimuth_rad, &topo->elevation_rad, &topo->rectV);
+}
+
+
+
+GLOBAL void sky_siteTirsToTopoV(const V3D_Vector   *terInterV,
+                                double             dist_au,
+                                const Sky_SiteProp *site,
+                                V3D_Vector         *topoV)
+/*! Transform a coordinate vector from the Terrestrial Intermediate Reference
+    System to a topocentric vector in horizon coordinates, for the observing
+    site whose properties are described in parameter "site". This is the same
+    as sky_siteTirsToTopo(), except that it does not calculate the azimuth and
+    elevation angles.
+ \param[in]  terInterV  Position vector in Terrestrial Intermediate Reference
+                        System, as for sky_siteTirsToTopo()
+ \param[in]  dist_au    Geocentric Distance to object (astronomical units), or
+                        0.0 for objects outside the solar system
+ \param[in]  site       Block of data describing the observing site, as
+                        initialised by one of the functions
+                        sky_setSiteLocation() or sky_setSiteLoc2().
+ \param[out] topoV      Topocentric unit vector in horizon coordinates
+                        (North, East, Zenith), corrected for diurnal
+                        aberration, parallax and refraction. This is the same
+                        as field \a rectV of the result of sky_siteTirsToTopo().
+
+    Aberration, parallax and refraction are all applied to the vector
+    directly, so this function calls no trigonometric functions at all. This
+    saves an arctangent and an arcsine for each call compared with
+    sky_siteTirsToTopo().
 
+ \par When to call this function
+    Each time around your main loop, in place of sky_siteTirsToTopo(), if all
+    you need is the direction vector - for example to pass to
+    sky_siteIncidence_rad() or sky_siteAzElToHaDec(), or to drive a two-axis
+    mirror. If you then find that you also need the azimuth and elevation
+    (only occasionally, say, for display), get them from the vector by calling
+\code
+        v3d_rectToPolar(&azimuth_rad, &elevation_rad, &topoV);
+\endcode
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
     REQUIRE_NOT_NULL(terInterV);
     REQUIRE_NOT_NULL(site);
-    REQUIRE_NOT_NULL(topo);
+    REQUIRE_NOT_NULL(topoV);
 
     /* Rotate from the equatorial system to the horizon coordinate system. The
        resultant position vector, referred to North, East and Zenith, is in a
        left-handed system, like the Azimuth & Elevation angle system to which it
        will eventually be converted. */
-    v3d_multMxV(&topo->rectV, site->azElM, terInterV);
+    v3d_multMxV(topoV, site->azElM, terInterV);
     /* Note, at this point topoV is not actually topocentric yet - it is still
        a geocentric point-of-view, even though the coordinate system is now
        specific to our particular site. */
@@ -438,72 +570,363 @@ GLOBAL void sky_siteTirsToTopo(const V3D_Vector   *terInterV,
        the same coordinate system] is minuscule, since the "deflection of the
        vertical" is so small - almost certainly < 20 arcseconds.) */
 #ifndef SPA_COMPARISONS
-    topo->rectV.a[1] += site->diurnalAberr;
+    topoV->a[1] += site->diurnalAberr;
 #else
 #warning "Correction for diurnal aberration is not being applied"
 #endif
     if (dist_au > 0.0) {
-        topo->rectV.a[0] += site->rhoSin_au / dist_au;
-        topo->rectV.a[2] += site->rhoCos_au / dist_au;
+        topoV->a[0] += site->rhoSin_au / dist_au;
+        topoV->a[2] += site->rhoCos_au / dist_au;
     }
     // else
     //      We treat 0.0 (or -ve values) as meaning "infinitely far away".
     //      Objects that far away have no parallax, so we need do nothing here
 
-    v3d_rectToPolar(&topo->azimuth_rad, &topo->elevation_rad, &topo->rectV);
+    refractVector(site->refracModel, site->refracPT, topoV);
+}
 
-#if 0
-    /* Correct for atmospheric refraction. Use the simpler NREL SPA calculation
-       instead of the more detailed atmospheric model used by Stromlo.
-       Unfortunately, this formula is expressed in degrees, so we have to
-       convert back and forth. */
-    {
-        double e0_deg;      // Elevation (not corrected for refraction, degrees)
-
-        e0_deg = radToDeg(topo->elevation_rad);
-        if (e0_deg > -2.0) {
-            dEl_rad = degToRad(1.02 / (60.0 * tan(degToRad(e0_deg + 10.3
-                                                           / (e0_deg + 5.11)))))
-                      * site->refracPT;
-        } else {
-            dEl_rad = 0.0;
+
+
+GLOBAL void sky_setSiteBatchStorage(int           count,
+                                    double        storage[],
+                                    Sky_SiteBatch *batch)
+/*! Set up a Sky_SiteBatch to hold the properties of \a count sites in the
+    array \a storage, which you supply.
+ \param[in]  count    Number of sites
+ \param[in]  storage  Array of at least \a count x SKY_SITEBATCH_DOUBLES
+                      elements. It must remain in existence for as long as
+                      \a batch is in use.
+ \param[out] batch    Structure of arrays, pointing into \a storage
+
+ \par When to call this function
+    At program initialisation time, before calling sky_setSiteBatchEntry()
+    for each of the sites.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    int     r, c;
+    double  *next;
+
+    REQUIRE_NOT_NULL(storage);
+    REQUIRE_NOT_NULL(batch);
+    REQUIRE(count > 0);
+
+    /* Each property gets a contiguous array of count elements */
+    next = storage;
+    batch->count = count;
+    for (r = 0; r < 3; r++) {
+        for (c = 0; c < 3; c++) {
+            batch->azElM[r][c] = next;
+            next += count;
         }
     }
-#elif 0
-    /* Correct for atmospheric refraction using a radian version of the above */
-    if (topo->elevation_rad > (-2.0 * DEG2RAD) {
-        dEl_rad = 0.000296706 / tan(topo->elevation_rad + 0.00313756
-                                           / (topo->elevation_rad + 0.0891863))
-                  * site->refracPT;
-    } else {
-        dEl_rad = 0.0;
+    batch->diurnalAberr = next;
+    next += count;
+    batch->rhoSin_au = next;
+    next += count;
+    batch->rhoCos_au = next;
+    next += count;
+    batch->refracPT = next;
+    /* Not yet known. The first call to sky_setSiteBatchEntry() sets it */
+    batch->refracModel = SKY_REFRAC_MODEL_COUNT;
+}
+
+
+
+GLOBAL void sky_setSiteBatchEntry(int                index,
+                                  const Sky_SiteProp *site,
+                                  Sky_SiteBatch      *batch)
+/*! Copy the properties of one site into a Sky_SiteBatch.
+ \param[in]     index  Number of the site within the batch (0 to count - 1)
+ \param[in]     site   Properties of the site, as set up by
+                       sky_setSiteLocation() (or sky_setSiteLoc2()) and
+                       sky_setSiteTempPress(). Its refraction model (see
+                       sky_setSiteRefraction()) must be the same as that of
+                       every other site in the batch.
+ \param[in,out] batch  Structure of arrays, as set up by
+                       sky_setSiteBatchStorage()
+
+ \par When to call this function
+    At program initialisation time, for each site. Call it again for any site
+    whose properties you have changed (e.g. by calling sky_setSiteTempPress()
+    or sky_adjustSiteForPolarMotion()). To change the refraction model, call
+    sky_setSiteBatchStorage() again and then this function for every site.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    int     r, c;
+
+    REQUIRE_NOT_NULL(site);
+    REQUIRE_NOT_NULL(batch);
+    REQUIRE((index >= 0) && (index < batch->count));
+
+    for (r = 0; r < 3; r++) {
+        for (c = 0; c < 3; c++) {
+            batch->azElM[r][c][index] = site->azElM->a[r][c];
+        }
     }
-#else
-    /* Correct for atmospheric refraction using two simpler formulae */
-    w = sqrt(topo->rectV.a[0] * topo->rectV.a[0]
-             + topo->rectV.a[1] * topo->rectV.a[1]);
-    if (topo->rectV.a[2] >= 0.268 * w) {
-        /* Elevation is greater than 15° */
-        tanZd = w / topo->rectV.a[2];
-        dEl_rad = (2.8253e-4 * tanZd - 3.9948e-7 * tanZd * tanZd * tanZd)
-                  * site->refracPT;
-
-    } else if (topo->elevation_rad > (-2.0 * DEG2RAD)) {
-        /* Low elevation, use this approx formula instead */
-        dEl_rad =  (8.3323e-3 + 3.1786e-2 * topo->elevation_rad
-                    + 2.0746e-2 * topo->elevation_rad * topo->elevation_rad)
-                 / (1 + 20.995 * topo->elevation_rad
-                    + 160.31 * topo->elevation_rad * topo->elevation_rad)
-                 * site->refracPT;
+    batch->diurnalAberr[index] = site->diurnalAberr;
+    batch->rhoSin_au[index] = site->rhoSin_au;
+    batch->rhoCos_au[index] = site->rhoCos_au;
+    batch->refracPT[index] = site->refracPT;
+    /* The first site sets the model for the whole batch */
+    if (batch->refracModel == SKY_REFRAC_MODEL_COUNT) {
+        batch->refracModel = site->refracModel;
+    }
+    REQUIRE(site->refracModel == batch->refracModel);
+}
 
-    } else {
-        dEl_rad = 0.0;
+
+
+GLOBAL void sky_siteTirsToTopoBatch(const V3D_Vector    *terInterV,
+                                    double              dist_au,
+                                    const Sky_SiteBatch *batch,
+                                    Sky_SiteHorizon     topo[])
+/*! Transform one coordinate vector from the Terrestrial Intermediate Reference
+    System to topocentric Az/El coordinates for every site in \a batch. The
+    results are the same as calling sky_siteTirsToTopo() once for each site,
+    but the rotation, diurnal aberration and parallax corrections are done for
+    all sites in a single loop over contiguous arrays, which a compiler can
+    vectorise, and without the per-call overhead.
+ \param[in]  terInterV  Position vector in Terrestrial Intermediate Reference
+                        System, as for sky_siteTirsToTopo()
+ \param[in]  dist_au    Geocentric Distance to object (astronomical units), or
+                        0.0 for objects outside the solar system
+ \param[in]  batch      Properties of the sites, as set up by
+                        sky_setSiteBatchStorage() and sky_setSiteBatchEntry()
+ \param[out] topo       Array of batch->count elements, to receive the
+                        topocentric position for each site
+
+ \par When to call this function
+    Each time around your main loop, in place of calling sky_siteTirsToTopo()
+    for each site, when many sites are looking at the same object.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  x, y, z;
+    double  invDist;
+    int     i;
+
+    REQUIRE_NOT_NULL(terInterV);
+    REQUIRE_NOT_NULL(batch);
+    REQUIRE_NOT_NULL(topo);
+    REQUIRE(batch->refracModel != SKY_REFRAC_MODEL_COUNT);  // Entries not set
+
+    x = terInterV->a[0];
+    y = terInterV->a[1];
+    z = terInterV->a[2];
+    /* As in sky_siteTirsToTopo(), zero (or -ve) distance means "infinitely
+       far away", i.e. no parallax. */
+    invDist = (dist_au > 0.0) ? 1.0 / dist_au : 0.0;
+
+    /* Rotate to each site's horizon system, and correct for diurnal
+       aberration and geocentric parallax (see sky_siteTirsToTopo() for
+       details) */
+    for (i = 0; i < batch->count; i++) {
+        topo[i].rectV.a[0] = batch->azElM[0][0][i] * x
+                             + batch->azElM[0][1][i] * y
+                             + batch->azElM[0][2][i] * z
+                             + batch->rhoSin_au[i] * invDist;
+        topo[i].rectV.a[1] = batch->azElM[1][0][i] * x
+                             + batch->azElM[1][1][i] * y
+                             + batch->azElM[1][2][i] * z
+#ifndef SPA_COMPARISONS
+                             + batch->diurnalAberr[i]
+#endif
+                             ;
+        topo[i].rectV.a[2] = batch->azElM[2][0][i] * x
+                             + batch->azElM[2][1][i] * y
+                             + batch->azElM[2][2][i] * z
+                             + batch->rhoCos_au[i] * invDist;
     }
+
+    /* Then convert to azimuth & elevation, and correct for refraction */
+    for (i = 0; i < batch->count; i++) {
+        applyRefraction(batch->refracModel, batch->refracPT[i], &topo[i]);
+    }
+}
+
+
+
+GLOBAL void sky_setSiteCompact(const Sky_SiteProp *site,
+                               Sky_SiteCompact    *compact)
+/*! Make a compact, single precision copy of a site's properties, for use by
+    sky_siteTirsToTopoCompact().
+ \param[in]  site     Properties of the site, as set up by
+                      sky_setSiteLocation() (or sky_setSiteLoc2()) and
+                      sky_setSiteTempPress()
+ \param[out] compact  Compact copy of the properties
+
+ \par When to call this function
+    At program initialisation time, for each site, after setting up \a site.
+    Call it again for any site whose properties you have changed. Once the
+    compact copy has been made, \a site itself is no longer needed.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    int     r, c;
+
+    REQUIRE_NOT_NULL(site);
+    REQUIRE_NOT_NULL(compact);
+
+    for (r = 0; r < 3; r++) {
+        for (c = 0; c < 3; c++) {
+            compact->azElM[r][c] = (float)site->azElM->a[r][c];
+        }
+    }
+    compact->rhoSin_au = (float)site->rhoSin_au;
+    compact->rhoCos_au = (float)site->rhoCos_au;
+    compact->diurnalAberr = (float)site->diurnalAberr;
+    compact->refracPT = (float)site->refracPT;
+    compact->refracModel = site->refracModel;
+}
+
+
+
+GLOBAL void sky_siteTirsToTopoCompact(const V3D_Vector      *terInterV,
+                                      double                dist_au,
+                                      const Sky_SiteCompact *compact,
+                                      Sky_SiteHorizon       *topo)
+/*! Transform a coordinate vector from the Terrestrial Intermediate Reference
+    System to topocentric Az/El coordinates for a site described by a
+    Sky_SiteCompact. This is the same as sky_siteTirsToTopo(), except for the
+    form of the site data, and it is slightly less accurate. See
+    \ref page-compact-site.
+ \param[in]  terInterV  Position vector in Terrestrial Intermediate Reference
+                        System, as for sky_siteTirsToTopo()
+ \param[in]  dist_au    Geocentric Distance to object (astronomical units), or
+                        0.0 for objects outside the solar system
+ \param[in]  compact    Compact site properties, as set up by
+                        sky_setSiteCompact()
+ \param[out] topo       Topocentric position, both as a vector in horizon
+                        coordinates, and as azimuth (radian) and elevation
+                        (radian).
+
+ \par When to call this function
+    Each time around your main loop, in place of sky_siteTirsToTopo(), when
+    you are keeping compact site data.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    int     r;
+
+    REQUIRE_NOT_NULL(terInterV);
+    REQUIRE_NOT_NULL(compact);
+    REQUIRE_NOT_NULL(topo);
+
+    /* Only the stored values are single precision. The arithmetic is done in
+       double precision, so that it adds no further error. */
+    for (r = 0; r < 3; r++) {
+        topo->rectV.a[r] = (double)compact->azElM[r][0] * terInterV->a[0]
+                           + (double)compact->azElM[r][1] * terInterV->a[1]
+                           + (double)compact->azElM[r][2] * terInterV->a[2];
+    }
+#ifndef SPA_COMPARISONS
+    topo->rectV.a[1] += (double)compact->diurnalAberr;
 #endif
-    topo->elevation_rad += dEl_rad;
+    if (dist_au > 0.0) {
+        topo->rectV.a[0] += (double)compact->rhoSin_au / dist_au;
+        topo->rectV.a[2] += (double)compact->rhoCos_au / dist_au;
+    }
 
-    /* Convert back to rectangular coords */
-    v3d_polarToRect(&topo->rectV, topo->azimuth_rad, topo->elevation_rad);
+    applyRefraction(compact->refracModel, (double)compact->refracPT, topo);
+}
+
+
+
+GLOBAL void sky_siteTopoToTirs(const V3D_Vector   *topoV,
+                               double             dist_au,
+                               const Sky_SiteProp *site,
+                               V3D_Vector         *terInterV)
+/*! Transform an observed topocentric direction back to a geocentric vector in
+    the Terrestrial Intermediate Reference System. This is the inverse of
+    sky_siteTirsToTopoV() (and of sky_siteTirsToTopo()).
+ \param[in]  topoV      Observed direction, as a vector in horizon coordinates
+                        (North, East, Zenith), of any magnitude. For example,
+                        from azimuth and elevation encoder readings, call
+                        v3d_polarToRect(&topoV, azimuth_rad, elevation_rad).
+ \param[in]  dist_au    Geocentric distance to the object (astronomical
+                        units), or 0.0 for objects outside the solar system.
+                        Note that this is needed to remove the parallax.
+ \param[in]  site       Block of data describing the observing site, as
+                        initialised by one of the functions
+                        sky_setSiteLocation() or sky_setSiteLoc2().
+ \param[out] terInterV  Unit vector in the Terrestrial Intermediate Reference
+                        System. Pass this to sky0_tirsToApp() or
+                        sky1_tirsToApp() to get the apparent position.
+
+    The corrections are removed in the reverse order to that in which
+    sky_siteTirsToTopoV() applies them:
+    1. Refraction is removed by iteration, as it depends on the unrefracted
+       elevation, which is what we are trying to find. This converges to
+       better than 1e-12 radian in a few iterations, except close to -2°
+       elevation, where the refraction models stop abruptly.
+    2. Diurnal aberration and parallax are removed together. These were applied
+       by adding a small fixed vector to the unit vector and normalising, which
+       can be undone exactly by solving a quadratic equation, so no iteration
+       is needed.
+    3. The vector is rotated from horizon coordinates back to terrestrial
+       coordinates, using the transpose of the site's rotation matrix.
+
+ \par When to call this function
+    When you have the direction that a telescope or tracker was actually
+    pointing at (e.g. from its encoders) and you want to find the position in
+    the sky that this corresponds to - for pointing error analysis, for
+    example. If you have many readings from the same site, call
+    sky_siteTopoToTirsBatch() instead.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    V3D_Vector  geoV;       // Unit vector, geocentric point of view
+
+    REQUIRE_NOT_NULL(topoV);
+    REQUIRE_NOT_NULL(site);
+    REQUIRE_NOT_NULL(terInterV);
+
+    geoV = *topoV;
+    unrefractVector(site->refracModel, site->refracPT, &geoV);
+    removeParallax(dist_au, site, &geoV);
+    v3d_multMtransxV(terInterV, site->azElM, &geoV);
+}
+
+
+
+GLOBAL void sky_siteTopoToTirsBatch(int                count,
+                                    const V3D_Vector   topoV[],
+                                    double             dist_au,
+                                    const Sky_SiteProp *site,
+                                    V3D_Vector         terInterV[])
+/*! Transform a series of observed topocentric directions, all from the same
+    site, back to geocentric vectors in the Terrestrial Intermediate Reference
+    System. The results are the same as calling sky_siteTopoToTirs() once for
+    each direction.
+ \param[in]  count      Number of directions
+ \param[in]  topoV      Array of \a count observed directions, as vectors in
+                        horizon coordinates, as for sky_siteTopoToTirs()
+ \param[in]  dist_au    Geocentric distance to the object (astronomical
+                        units), or 0.0 for objects outside the solar system.
+                        (This changes so slowly that one value will usually do
+                        for all the directions.)
+ \param[in]  site       Block of data describing the observing site
+ \param[out] terInterV  Array of \a count unit vectors in the Terrestrial
+                        Intermediate Reference System. May be the same array as
+                        \a topoV.
+
+ \par When to call this function
+    When you have logged a stream of encoder readings from one site, to
+    reconstruct where the mount was actually pointing. Follow it with a call
+    to sky0_tirsToAppBatch() or sky1_tirsToAppBatch() to get the apparent
+    positions.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    V3D_Vector  geoV;       // Unit vector, geocentric point of view
+    int         i;
+
+    REQUIRE(count >= 0);
+    REQUIRE_NOT_NULL(topoV);
+    REQUIRE_NOT_NULL(site);
+    REQUIRE_NOT_NULL(terInterV);
+
+    for (i = 0; i < count; i++) {
+        geoV = topoV[i];
+        unrefractVector(site->refracModel, site->refracPT, &geoV);
+        removeParallax(dist_au, site, &geoV);
+        v3d_multMtransxV(&terInterV[i], site->azElM, &geoV);
+    }
 }
 
 
@@ -572,6 +995,185 @@ GLOBAL double sky_siteIncidence_rad(const V3D_Vector *topoV,
     return acos(v3d_dotProductV(topoV, surfaceV));
 }
 
+
+
+GLOBAL void sky_setHorizonMask(int             count,
+                               const double    elevation_deg[],
+                               Sky_HorizonMask *mask)
+/*! Set up a horizon mask from the elevation of the local horizon at a number
+    of equally spaced azimuths.
+ \param[in]  count          Number of points, from 1 to SKY_HORIZON_MAX_POINTS.
+                            (1 gives a horizon at the same elevation in every
+                            direction.)
+ \param[in]  elevation_deg  Array of \a count elevations of the horizon
+                            (degrees). Element i is the elevation at azimuth
+                            i * 360° / \a count, so the first is at North.
+ \param[out] mask           All fields set
+
+ \par When to call this function
+    At program initialisation time, for each site with an obstructed horizon.
+    To read the horizon from a file, call skysites_loadHorizon() instead.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    int     i;
+
+    REQUIRE((count >= 1) && (count <= SKY_HORIZON_MAX_POINTS));
+    REQUIRE_NOT_NULL(elevation_deg);
+    REQUIRE_NOT_NULL(mask);
+
+    mask->count = count;
+    mask->pointsPerRad = count / TWOPI;
+    for (i = 0; i < count; i++) {
+        mask->elevation_rad[i] = degToRad(elevation_deg[i]);
+    }
+    mask->elevation_rad[count] = mask->elevation_rad[0];
+}
+
+
+
+GLOBAL double sky_horizonElevation_rad(const Sky_HorizonMask *mask,
+                                       double                azimuth_rad)
+/*! Look up the elevation of the local horizon in a particular direction, by
+    linear interpolation between the points of the mask.
+ \returns    Elevation of the horizon (radian)
+ \param[in]  mask         Horizon mask, as set up by sky_setHorizonMask()
+ \param[in]  azimuth_rad  Azimuth (radian). Any value; it need not be reduced
+                          to the range [0, 2π).
+
+    This takes the same (short) time whatever the number of points in the mask.
+
+ \par When to call this function
+    Whenever you need the elevation of the horizon. It is called for you by
+    sky_siteIsVisible(), sun_riseSetMask() and moon_riseSetMask().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  pos;            // Position in mask, in units of the point spacing
+    int     i;
+
+    REQUIRE_NOT_NULL(mask);
+    REQUIRE(mask->count >= 1);
+
+    pos = azimuth_rad * mask->pointsPerRad;
+    pos -= mask->count * floor(pos / mask->count);
+    i = (int)pos;
+    if (i >= mask->count) {
+        i = mask->count - 1;            // (only possible through rounding)
+    }
+    return mask->elevation_rad[i]
+           + (pos - i) * (mask->elevation_rad[i + 1] - mask->elevation_rad[i]);
+}
+
+
+
+GLOBAL bool sky_siteIsVisible(const Sky_SiteHorizon *topo,
+                              const Sky_HorizonMask *mask)
+/*! Find out whether an object is above the local horizon.
+ \returns    true if the centre of the object is above the horizon mask
+ \param[in]  topo  Topocentric position of the object, as returned by
+                   sky_siteTirsToTopo() (i.e. including refraction)
+ \param[in]  mask  Horizon mask for the site, as set up by
+                   sky_setHorizonMask(), or NULL for a flat horizon at 0°
+                   elevation
+
+ \par When to call this function
+    Each time around your main loop, after calling sky_siteTirsToTopo(), if
+    you need to know whether the object (e.g. the Sun) can actually be seen
+    from the site.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    REQUIRE_NOT_NULL(topo);
+
+    if (mask == NULL) {
+        return topo->elevation_rad > 0.0;
+    }
+    return topo->elevation_rad
+           > sky_horizonElevation_rad(mask, topo->azimuth_rad);
+}
+
+
+
+GLOBAL double sky_horizonRiseSetEl_rad(const Sky_HorizonMask *mask,
+                                       double                azimuth_rad,
+                                       double                semiDiameter_rad)
+/*! Calculate the unrefracted elevation that the centre of an object has at the
+    moment that its upper limb appears above (or disappears below) the local
+    horizon in a particular direction.
+ \returns    Unrefracted elevation of the object's centre (radian)
+ \param[in]  mask             Horizon mask, or NULL for a flat horizon at 0°
+ \param[in]  azimuth_rad      Azimuth of the object (radian)
+ \param[in]  semiDiameter_rad Apparent semi-diameter of the object (radian)
+
+    As in sun_riseSet() and moon_riseSet(), the refraction is taken to be 34
+    arcminutes at 0° elevation. For a horizon above or below that, it is scaled
+    according to Bennett's formula. So for a flat horizon, and a semi-diameter
+    of 16 arcminutes, this gives the usual -50 arcminutes.
+
+ \par When to call this function
+    You don't need to call this function. It is called by sun_riseSetMask() and
+    moon_riseSetMask().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  h0_deg;         // Apparent elevation of horizon (degrees)
+
+    if (mask == NULL) {
+        h0_deg = 0.0;
+    } else {
+        h0_deg = radToDeg(sky_horizonElevation_rad(mask, azimuth_rad));
+    }
+    if (h0_deg < -2.0) {
+        h0_deg = -2.0;              // (Bennett's formula fails below -4°)
+    }
+    /* Bennett's formula, scaled to give HORIZON_REFRACTION_RAD at 0° */
+    return degToRad(h0_deg) - semiDiameter_rad
+           - HORIZON_REFRACTION_RAD * tan(degToRad(7.31 / 4.4))
+             / tan(degToRad(h0_deg + 7.31 / (h0_deg + 4.4)));
+}
+
+
+
+GLOBAL double sky_horizonRiseSetStep_d(double t0_d,
+                                       double r0_d,
+                                       double t1_d,
+                                       double r1_d)
+/*! Calculate the next estimate of a rise or set time over a horizon mask, by
+    the secant method.
+ \returns    The next estimate of the time (days, same timescale as \a t1_d)
+ \param[in]  t0_d  The previous estimate of the time (days). On the first
+                   iteration, when there is no previous estimate, pass the same
+                   value as \a t1_d.
+ \param[in]  r0_d  The correction to \a t0_d given by one pass of the flat
+                   horizon rise/set calculation (days), or 0.0 on the first
+                   iteration
+ \param[in]  t1_d  The latest estimate of the time (days)
+ \param[in]  r1_d  The correction to \a t1_d (days)
+
+    Each pass of the rise/set calculation maps an estimate t onto a better one
+    g(t). Because the elevation of the horizon changes with the object's
+    azimuth, simply repeating this converges slowly. So this function finds
+    where the line through the two latest corrections g(t) - t crosses zero. If
+    the two estimates (or their corrections) are too close together for the
+    line to be trusted, or if the secant step is more than four times the
+    latest correction, it just applies the latest correction instead.
+
+ \par When to call this function
+    Don't. This is an internal routine, not for use by applications. It is
+    called by sun_riseSetMask() and moon_riseSetMask(), and may change without
+    notice.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  next_d;
+
+    if ((fabs(t1_d - t0_d) < SECANT_MIN_d)
+        || (fabs(r1_d - r0_d) < SECANT_MIN_d)) {
+        return t1_d + r1_d;
+    }
+    next_d = t1_d - r1_d * (t1_d - t0_d) / (r1_d - r0_d);
+    if (fabs(next_d - t1_d) > 4.0 * fabs(r1_d)) {
+        next_d = t1_d + r1_d;           // Secant step is wild. Be cautious
+    }
+    return next_d;
+}
+
 /*
  *------------------------------------------------------------------------------
  *
@@ -639,6 +1241,305 @@ LOCAL void createAzElBaseM(Sky_SiteProp *site)
     site->azElBaseM.a[2][2] = sinLat;
 }
 
+
+
+LOCAL void applyRefraction(Sky_RefractionModel model,
+                           double              refracPT,
+                           Sky_SiteHorizon     *topo)
+/* Correct a topocentric vector for atmospheric refraction, and convert it to
+   azimuth and elevation.
+ Inputs
+    model    - refraction model
+    refracPT - refraction correction for pressure & temperature, as set by
+               sky_setSiteTempPress()
+ In/Out
+    topo     - field rectV on input; all fields on output
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    refractVector(model, refracPT, &topo->rectV);
+    v3d_rectToPolar(&topo->azimuth_rad, &topo->elevation_rad, &topo->rectV);
+}
+
+
+
+LOCAL void refractVector(Sky_RefractionModel model,
+                         double              refracPT,
+                         V3D_Vector          *topoV)
+/* Correct a topocentric vector for atmospheric refraction, without
+   converting it to polar form. The refraction for the vector's elevation is
+   interpolated from the model's table, and the vector is then rotated
+   upwards by that amount.
+ Inputs
+    model    - refraction model. Its table must have been built.
+    refracPT - refraction correction for pressure & temperature
+ In/Out
+    topoV    - topocentric vector in horizon coordinates (any magnitude) on
+               input; unit vector, corrected for refraction, on output
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  invR;           // 1 / magnitude of topoV
+    double  w;              // Horizontal component of the unit vector (=cos El)
+
+    invR = 1.0 / v3d_magV(topoV);
+    topoV->a[0] *= invR;
+    topoV->a[1] *= invR;
+    topoV->a[2] *= invR;
+    w = sqrt(topoV->a[0] * topoV->a[0] + topoV->a[1] * topoV->a[1]);
+
+    tiltUnitVector(tableRefraction_rad(model, refracPT, w, topoV->a[2]),
+                   w,
+                   topoV);
+}
+
+
+
+LOCAL void unrefractVector(Sky_RefractionModel model,
+                           double              refracPT,
+                           V3D_Vector          *topoV)
+/* Remove atmospheric refraction from a topocentric vector - the reverse of
+   refractVector(). The refraction depends on the unrefracted elevation, which
+   is not known, so this iterates: starting with the refraction at the
+   observed elevation, find the unrefracted elevation, and then the refraction
+   at that elevation, until it stops changing.
+ Inputs
+    model    - refraction model. Its table must have been built.
+    refracPT - refraction correction for pressure & temperature
+ In/Out
+    topoV    - observed topocentric vector in horizon coordinates (any
+               magnitude) on input; unit vector, without refraction, on output
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  invR;           // 1 / magnitude of topoV
+    double  w;              // Horizontal component of the unit vector (=cos El)
+    double  sinEl;          // Sine of observed elevation
+    double  dEl_rad;        // Refraction (radian)
+    double  prevDel_rad;
+    double  sinD, cosD;
+    int     i;
+
+    invR = 1.0 / v3d_magV(topoV);
+    topoV->a[0] *= invR;
+    topoV->a[1] *= invR;
+    topoV->a[2] *= invR;
+    w = sqrt(topoV->a[0] * topoV->a[0] + topoV->a[1] * topoV->a[1]);
+    sinEl = topoV->a[2];
+
+    dEl_rad = tableRefraction_rad(model, refracPT, w, sinEl);
+    for (i = 0; i < UNREFRAC_MAX_ITER; i++) {
+        /* Lower the observed elevation by the current estimate of the
+           refraction, and look up the refraction at that elevation */
+        sinD = dEl_rad * (1.0 - dEl_rad * dEl_rad / 6.0);
+        cosD = 1.0 - 0.5 * dEl_rad * dEl_rad;
+        prevDel_rad = dEl_rad;
+        dEl_rad = tableRefraction_rad(model,
+                                      refracPT,
+                                      w * cosD + sinEl * sinD,
+                                      sinEl * cosD - w * sinD);
+        if (fabs(dEl_rad - prevDel_rad) < UNREFRAC_TOL_RAD) {
+            break;
+        }
+    }
+    // else
+    //      Just above -2° elevation, where the refraction suddenly stops, some
+    //      observed elevations have no unrefracted elevation. We give up
+    //      after UNREFRAC_MAX_ITER iterations and use the last estimate.
+
+    tiltUnitVector(-dEl_rad, w, topoV);
+}
+
+
+
+LOCAL double tableRefraction_rad(Sky_RefractionModel model,
+                                 double              refracPT,
+                                 double              w,
+                                 double              sinEl)
+/* Look up the refraction for a direction, by linear interpolation in the
+   model's table.
+ Returns
+    Increase in elevation due to refraction (radian). Zero below -2°
+ Inputs
+    model    - refraction model. Its table must have been built.
+    refracPT - refraction correction for pressure & temperature
+    w        - horizontal component of the unit vector (= cos(elevation))
+    sinEl    - vertical component of the unit vector (= sin(elevation))
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    const double *table;
+    double  tanHalfZd;      // tan(zenith distance / 2)
+    double  pos;
+    int     j;
+
+    tanHalfZd = w / (1.0 + sinEl);
+    if ((tanHalfZd >= REFRAC_TABLE_MAX) || (refracPT <= 0.0)) {
+        return 0.0;
+    }
+
+    table = refracTable[model];
+    pos = tanHalfZd * (REFRAC_TABLE_STEPS / REFRAC_TABLE_MAX);
+    j = (int)pos;
+    if (j >= REFRAC_TABLE_STEPS) {
+        j = REFRAC_TABLE_STEPS - 1;
+    }
+    return (table[j] + (pos - j) * (table[j + 1] - table[j])) * refracPT;
+}
+
+
+
+LOCAL void tiltUnitVector(double dEl_rad, double w, V3D_Vector *topoV)
+/* Rotate a unit vector upwards (towards the zenith) by a small angle, keeping
+   its azimuth unchanged. The sine and cosine of the angle are taken from
+   their series, so there are no trigonometric function calls.
+ Inputs
+    dEl_rad - angle to raise the vector by (radian). Negative to lower it.
+              Must be less than about 0.02 rad, so that the series below are
+              accurate to better than 1e-9 rad.
+    w       - horizontal component of the vector (= cos(elevation))
+ In/Out
+    topoV   - unit vector in horizon coordinates
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  sinDel, cosDel;
+    double  sinEl, cosEl;
+    double  k;
+
+    sinDel = dEl_rad * (1.0 - dEl_rad * dEl_rad / 6.0);
+    cosDel = 1.0 - 0.5 * dEl_rad * dEl_rad;
+    sinEl = topoV->a[2];
+    cosEl = w * cosDel - sinEl * sinDel;
+    if (w > 0.0) {
+        k = cosEl / w;
+        topoV->a[0] *= k;
+        topoV->a[1] *= k;
+    }
+    topoV->a[2] = sinEl * cosDel + w * sinDel;
+}
+
+
+
+LOCAL void removeParallax(double             dist_au,
+                          const Sky_SiteProp *site,
+                          V3D_Vector         *topoV)
+/* Remove the corrections for diurnal aberration and geocentric parallax from
+   a unit vector - the reverse of what sky_siteTirsToTopoV() does. That
+   function adds a correction vector a to the geocentric unit vector u, and
+   normalises the result to get the topocentric unit vector n. So u = s*n - a
+   for some positive scale factor s, and as u is a unit vector,
+        s² - 2s(n·a) + a·a - 1 = 0
+   whose positive root is s = n·a + sqrt((n·a)² - a·a + 1).
+ Inputs
+    dist_au - geocentric distance to the object (AU), 0.0 for infinity
+    site    - fields diurnalAberr, rhoSin_au and rhoCos_au
+ In/Out
+    topoV   - topocentric unit vector on input, geocentric unit vector on
+              output (both in horizon coordinates)
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    V3D_Vector  corrV;      // Correction vector added by sky_siteTirsToTopoV()
+    double      nDotA;
+    double      scale;
+
+    corrV.a[0] = 0.0;
+    corrV.a[2] = 0.0;
+#ifndef SPA_COMPARISONS
+    corrV.a[1] = site->diurnalAberr;
+#else
+    corrV.a[1] = 0.0;
+#endif
+    if (dist_au > 0.0) {
+        corrV.a[0] = site->rhoSin_au / dist_au;
+        corrV.a[2] = site->rhoCos_au / dist_au;
+    }
+
+    nDotA = v3d_dotProductV(topoV, &corrV);
+    scale = nDotA + sqrt(nDotA * nDotA - v3d_magVSq(&corrV) + 1.0);
+    topoV->a[0] = scale * topoV->a[0] - corrV.a[0];
+    topoV->a[1] = scale * topoV->a[1] - corrV.a[1];
+    topoV->a[2] = scale * topoV->a[2] - corrV.a[2];
+}
+
+
+
+LOCAL void buildRefracTable(Sky_RefractionModel model)
+/* Fill in the refraction table for a model (for standard temperature and
+   pressure), if this has not already been done.
+ Inputs
+    model - refraction model
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  el_rad;
+    int     j;
+
+    if (refracTableBuilt[model]) {
+        return;
+    }
+    for (j = 0; j <= REFRAC_TABLE_STEPS; j++) {
+        el_rad = HALFPI - 2.0 * atan(j * (REFRAC_TABLE_MAX
+                                          / REFRAC_TABLE_STEPS));
+        refracTable[model][j] = refraction_rad(model, el_rad);
+    }
+    refracTableBuilt[model] = true;
+}
+
+
+
+LOCAL double refraction_rad(Sky_RefractionModel model, double el_rad)
+/* Calculate the atmospheric refraction at standard temperature and pressure
+   (10 °C and 1010 hPa) using the formula of the selected model. (The cutoff
+   at -2° elevation is applied by the caller.)
+ Returns
+    Increase in elevation due to refraction (radian)
+ Inputs
+    model  - refraction model
+    el_rad - unrefracted elevation (radian)
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double dEl_rad;         // Change in elevation from refraction (radian)
+    double e0_deg;          // Elevation (not corrected for refraction, degrees)
+    double h0_deg;          // Elevation corrected for refraction (degrees)
+    double tanZd;           // Tangent of zenith distance
+    int    i;
+
+    switch (model) {
+    case SKY_REFRAC_SPA:
+        /* The simpler NREL SPA calculation (Sæmundsson's formula). This
+           formula is expressed in degrees, so we have to convert back and
+           forth. */
+        e0_deg = radToDeg(el_rad);
+        dEl_rad = degToRad(1.02 / (60.0 * tan(degToRad(e0_deg + 10.3
+                                                       / (e0_deg + 5.11)))));
+        break;
+
+    case SKY_REFRAC_BENNETT:
+        /* Bennett's formula gives the refraction as a function of the
+           refracted (apparent) elevation h0, so iterate to find the h0 that
+           corresponds to el_rad */
+        e0_deg = radToDeg(el_rad);
+        h0_deg = e0_deg;
+        for (i = 0; i < 20; i++) {
+            h0_deg = e0_deg + 1.0 / (60.0 * tan(degToRad(h0_deg + 7.31
+                                                         / (h0_deg + 4.4))));
+        }
+        dEl_rad = degToRad(h0_deg - e0_deg);
+        break;
+
+    case SKY_REFRAC_TWO_FORMULA:
+    case SKY_REFRAC_MODEL_COUNT:        // (not a valid model)
+    default:
+        /* Two simpler formulae */
+        if (el_rad >= 15.0 * DEG2RAD) {
+            tanZd = 1.0 / tan(el_rad);
+            dEl_rad = 2.8253e-4 * tanZd - 3.9948e-7 * tanZd * tanZd * tanZd;
+        } else {
+            /* Low elevation, use this approx formula instead */
+            dEl_rad =  (8.3323e-3 + 3.1786e-2 * el_rad
+                        + 2.0746e-2 * el_rad * el_rad)
+                     / (1 + 20.995 * el_rad + 160.31 * el_rad * el_rad);
+        }
+        break;
+    }
+    return dEl_rad;
+}
+
 /*- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 /*! \page page-about About this code, and how to use it
  *
@@ -697,6 +1598,13 @@ LOCAL void createAzElBaseM(Sky_SiteProp *site)
 /*! \page page-misc Miscellaneous
  *      - \subpage page-vernal-equinox
  *      - \subpage page-why-struct-array
+ *      - \subpage page-compact-site
+ *      - \subpage page-refraction
+ *      - \subpage page-pointing-model
+ *      - \subpage page-site-csv
+ *      - \subpage page-single-axis
+ *      - \subpage page-heliostat
+ *      - \subpage page-iers-finals
  *  */
 
 /*! \page page-design-choices Design choices
@@ -734,6 +1642,12 @@ LOCAL void createAzElBaseM(Sky_SiteProp *site)
  *      - For solar position calculations: the "all applications" set above,
  *        plus sky0.h & sky0.c, and sun.h & sun.c
  *      - For Sun tracking: the above, plus skyfast.h & skyfast.c
+ *      - For fast random-access lookups of the Sun's position over long
+ *        periods: the above, plus skycheb.h & skycheb.c
+ *      - For precalculated ephemeris files (see \ref page-ephemeris-file): the
+ *        above, plus skyeph.h & skyeph.c (and moon.h & moon.c, sky1.h &
+ *        sky1.c, and planet.h & planet.c, which are used when the file does not
+ *        cover the object or time requested)
  *      - For Moon position calculations: the "all applications" set above, plus
  *        sky0.h & sky0.c, and moon.h & moon.c
  *      - For Moon tracking: the above, plus skyfast.h & skyfast.c
@@ -1110,3 +2024,72 @@ LOCAL void createAzElBaseM(Sky_SiteProp *site)
  *  March.
  */
 
+/*! \page page-compact-site Compact site data
+ *  Sky_SiteProp holds three 3x3 matrices, a pointer, eight other doubles
+ *  and the refraction model - 296 bytes. For a fleet of a million trackers,
+ *  that is more memory than most processor caches hold. Sky_SiteCompact keeps
+ *  only what sky_siteTirsToTopoCompact() needs, in single precision: one 3x3
+ *  matrix, four scalars and the refraction model, 56 bytes in all. Make one
+ *  from a Sky_SiteProp with sky_setSiteCompact().
+ *
+ *  The matrix is kept in full, rather than as a quaternion, because the
+ *  conversion to horizon coordinates goes from a right-handed to a left-handed
+ *  set, which a quaternion cannot represent. Only the stored values are
+ *  single precision; sky_siteTirsToTopoCompact() does its arithmetic in double
+ *  precision.
+ *
+ *  The difference in direction between the results of
+ *  sky_siteTirsToTopoCompact() and sky_siteTirsToTopo(), over a million
+ *  random directions above the horizon, at random sites (latitudes ±89°,
+ *  heights to 3000 m, temperatures -20 to 30 °C, pressures 600 to 1050 hPa),
+ *  was at most
+ *      - 0.011 arcseconds for an object at the Sun's distance
+ *      - 0.011 arcseconds for an object at the Moon's distance
+ *      .
+ *  This is almost all due to rounding the matrix elements to single
+ *  precision, and is well below the error of the refraction correction
+ *  itself.
+ */
+
+/*! \page page-refraction Refraction models
+ *  The refraction model is chosen for each site at run time, with
+ *  sky_setSiteRefraction(). The models are
+ *  | Model              | Source                                          |
+ *  |--------------------|-------------------------------------------------|
+ *  | SKY_REFRAC_TWO_FORMULA | A series in tan ζ above 15°, and an empirical rational formula below (the default) |
+ *  | SKY_REFRAC_SPA     | Sæmundsson's formula, as used by the NREL Solar Position Algorithm |
+ *  | SKY_REFRAC_BENNETT | Bennett's formula, inverted numerically         |
+ *
+ *  None of them applies any refraction below -2° elevation. At the horizon,
+ *  at 0 °C and 1030 hPa, they give 30.3, 30.6 and 30.6 arcminutes
+ *  respectively.
+ *
+ *  \par Why a table
+ *  The formulas need a tangent or two, an arcsine to get the elevation from
+ *  the position vector, and then a sine and a cosine to put the refracted
+ *  elevation back into the vector. Instead, each model is evaluated once at
+ *  standard temperature and pressure, at 1025 points evenly spaced in
+ *  tan(ζ/2), where ζ is the zenith distance. This quantity is found from the
+ *  unit vector (x, y, z) as sqrt(x² + y²) / (1 + z), with no trigonometric
+ *  function, and it is close to proportional to ζ, so the points are about
+ *  0.1° apart everywhere. (Spacing the points evenly in sin(elevation)
+ *  instead puts them more than 2° apart near the zenith, where linear
+ *  interpolation then errs by 0.7 arcseconds.) The interpolated value is
+ *  scaled for the site's temperature and pressure, and the vector is rotated
+ *  up by that angle using the first terms of the sine and cosine series,
+ *  which are exact to double precision for angles this small.
+ *
+ *  \par Accuracy
+ *  The largest differences between the table method and the formula
+ *  evaluated directly, over a sweep of elevations from -2° to 90°, were
+ *  | Model              | Above 15° | 0° to 15° | -2° to 0° |
+ *  |--------------------|-----------|-----------|-----------|
+ *  | SKY_REFRAC_TWO_FORMULA | 0.024″ | 0.090″   | 0.11″     |
+ *  | SKY_REFRAC_SPA     | 0.001″    | 0.078″    | 0.56″     |
+ *  | SKY_REFRAC_BENNETT | 0.001″    | 0.083″    | 0.14″     |
+ *
+ *  The larger error for the default model above 15° is at the join of its two
+ *  formulas, which is not smooth. All of these are far smaller than the
+ *  uncertainty of the refraction itself at low elevations, which can be
+ *  several arcminutes depending on the temperature profile of the air.
+ */
@@ -62,8 +62,17 @@ DEFINE_THIS_FILE;                       // For use by REQUIRE() - assertions.
 #endif
 
 #define START_GREGORIAN 2299160.0   /* Start Gregorian calendar 15-Oct-1582 */
+#define MJD_1JAN1972    41317       /* Start of leap seconds (& Sky_LeapSeconds)*/
 #define TIME_T_J2000    946728000   /* J2000.0 in Unix/C time_t format (s) */
 
+/*      Earth Rotation Angle ERA = 2π(ERA_J2000_TURNS + ERA_RATE Du), where Du
+        is UT1 days since J2000.0 (IERS Conventions 2010, eq. 5.15). The
+        two-part routines use the excess of the rate over one revolution per
+        day */
+#define ERA_J2000_TURNS 0.7790572732640
+#define ERA_RATE_EXCESS 0.00273781191135448
+#define ERA_RATE        (1.0 + ERA_RATE_EXCESS)
+
 /*
  * Prototypes for local functions (not called from other modules).
  */
@@ -72,6 +81,7 @@ LOCAL double getDeltaUT1_s(double mjdUtc,
                            double usnoCoeffC11,
                            double usnoCoeffC12);
 LOCAL double calendarToJ2kd(int year, int month, int day);
+LOCAL int leapBucket(double mjdUtc);
 
 /*
  * Global variables accessible by other modules
@@ -81,6 +91,42 @@ LOCAL double calendarToJ2kd(int year, int month, int day);
 /*
  * Local variables (not accessed by other modules)
  */
+/*      The leap seconds announced up to the time of writing: the MJD from which
+        each new value of TAI - UTC applies, and that value (from IERS Bulletin
+        C). Update this when a new leap second is announced. */
+LOCAL const struct {
+    int     mjd;
+    int     deltaAT_s;
+} leapTable[] = {
+    { 41317, 10 },      /* 1972 Jan 1 */
+    { 41499, 11 },      /* 1972 Jul 1 */
+    { 41683, 12 },      /* 1973 Jan 1 */
+    { 42048, 13 },      /* 1974 Jan 1 */
+    { 42413, 14 },      /* 1975 Jan 1 */
+    { 42778, 15 },      /* 1976 Jan 1 */
+    { 43144, 16 },      /* 1977 Jan 1 */
+    { 43509, 17 },      /* 1978 Jan 1 */
+    { 43874, 18 },      /* 1979 Jan 1 */
+    { 44239, 19 },      /* 1980 Jan 1 */
+    { 44786, 20 },      /* 1981 Jul 1 */
+    { 45151, 21 },      /* 1982 Jul 1 */
+    { 45516, 22 },      /* 1983 Jul 1 */
+    { 46247, 23 },      /* 1985 Jul 1 */
+    { 47161, 24 },      /* 1988 Jan 1 */
+    { 47892, 25 },      /* 1990 Jan 1 */
+    { 48257, 26 },      /* 1991 Jan 1 */
+    { 48804, 27 },      /* 1992 Jul 1 */
+    { 49169, 28 },      /* 1993 Jul 1 */
+    { 49534, 29 },      /* 1994 Jul 1 */
+    { 50083, 30 },      /* 1996 Jan 1 */
+    { 50630, 31 },      /* 1997 Jul 1 */
+    { 51179, 32 },      /* 1999 Jan 1 */
+    { 53736, 33 },      /* 2006 Jan 1 */
+    { 54832, 34 },      /* 2009 Jan 1 */
+    { 56109, 35 },      /* 2012 Jul 1 */
+    { 57204, 36 },      /* 2015 Jul 1 */
+    { 57754, 37 }       /* 2017 Jan 1 */
+};
 
 /*
  *==============================================================================
@@ -233,7 +279,433 @@ GLOBAL void sky_updateTimes(double            j2kUtc_d,
     t->j2kUT1_d = j2kUtc_d + d->deltaUT_d;
     t->j2kTT_d  = j2kUtc_d + d->deltaTT_d;
     t->j2kTT_cy = t->j2kTT_d / JUL_CENT;
-    t->era_rad = (0.7790572732640 + 1.00273781191135488 * t->j2kUT1_d) * TWOPI;
+    t->era_rad = (ERA_J2000_TURNS + ERA_RATE * t->j2kUT1_d) * TWOPI;
+    t->j2kUT1Day_d = floor(t->j2kUT1_d);
+    t->j2kUT1Frac_d = t->j2kUT1_d - t->j2kUT1Day_d;
+}
+
+
+
+GLOBAL void sky_updateTimes2(double            j2kUtcDay_d,
+                             double            j2kUtcFrac_d,
+                             const Sky_DeltaTs *d,
+                             Sky_Times         *t)
+/*! Convert the given time in the UTC timescale, in two parts, to the other
+    timescales, as for sky_updateTimes(), but keeping the full resolution of the
+    fraction of a day for UT1 and the Earth Rotation Angle.
+ \param[in]  j2kUtcDay_d   Whole number of days since 2000 Jan 1.5, UTC
+                           timescale
+ \param[in]  j2kUtcFrac_d  Fraction of a day to be added to \a j2kUtcDay_d.
+                           The time is the sum of the two parts, as returned by
+                           sky_unixTimespecToJ2kd2(). (The split need not be
+                           exact, but the resolution is best if this part is
+                           in the range [0, 1).)
+ \param[in]  d             The various delta T values as set by one of
+                           sky_initTime(), sky_initTimeDetailed() or
+                           sky_initTimeSimple()
+ \param[out] t             All fields are updated. Fields \a j2kUT1Day_d and
+                           \a j2kUT1Frac_d hold UT1 to full resolution, and
+                           \a era_rad is calculated from them and reduced to
+                           the range [0, 2π).
+
+ A single double holding days since J2000.0 resolves about 0.2 microseconds at
+ the present epoch, which is ample for most purposes, and the other fields of
+ \a t (used for precession, nutation and the positions of the Sun, Moon and
+ planets) are no more precise than that. But the fraction of a day on its own
+ resolves times to about 10 picoseconds, so if your clock gives the time in two
+ parts (as \c clock_gettime() does), this function and sky0_appToTirs2() or
+ sky1_appToTirs2() carry that through to the Earth's rotation angle.
+
+ \par When to call this function
+    In place of sky_updateTimes(), if you need the rotation of the Earth to be
+    computed to better than a microsecond of time.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  day;                // whole days of UT1
+    double  frac;               // fraction of a day of UT1
+    double  k;
+    double  turns;              // Earth Rotation Angle (revolutions)
+
+    REQUIRE_NOT_NULL(d);
+    REQUIRE_NOT_NULL(t);
+
+    /* Move any whole days of the UT1 fraction into the day part */
+    day = floor(j2kUtcDay_d);
+    frac = (j2kUtcDay_d - day) + j2kUtcFrac_d + d->deltaUT_d;
+    k = floor(frac);
+    t->j2kUT1Day_d = day + k;
+    t->j2kUT1Frac_d = frac - k;
+
+    t->mjdUtc = (j2kUtcDay_d + MJD_J2000) + j2kUtcFrac_d;
+    t->j2kUT1_d = t->j2kUT1Day_d + t->j2kUT1Frac_d;
+    t->j2kTT_d  = j2kUtcDay_d + (j2kUtcFrac_d + d->deltaTT_d);
+    t->j2kTT_cy = t->j2kTT_d / JUL_CENT;
+
+    /* ERA = 2π(ERA_J2000_TURNS + ERA_RATE Du). The whole days of Du
+       contribute whole revolutions, which are dropped before they can swamp the
+       fraction (as in the IERS Conventions and SOFA iauEra00()) */
+    turns = t->j2kUT1Frac_d + ERA_J2000_TURNS
+            + ERA_RATE_EXCESS * (t->j2kUT1Day_d + t->j2kUT1Frac_d);
+    t->era_rad = (turns - floor(turns)) * TWOPI;
+}
+
+
+
+GLOBAL void sky_updateTimesBatch(double            startUtc_d,
+                                 double            step_d,
+                                 int               count,
+                                 const Sky_DeltaTs *d,
+                                 Sky_Times         t[])
+/*! Convert a series of equally spaced times in the UTC timescale to the other
+    timescales, exactly as sky_updateTimes() would for each one.
+ \param[in]  startUtc_d  First time, in "J2KD" form (days since 2000 Jan 1.5,
+                         UTC timescale), as for sky_updateTimes()
+ \param[in]  step_d      Interval between times (days). May be negative.
+ \param[in]  count       Number of times (elements of \a t)
+ \param[in]  d           The various delta T values as set by one of
+                         sky_initTime(), sky_initTimeDetailed() or
+                         sky_initTimeSimple()
+ \param[out] t           Array of \a count elements. Element i is set for time
+                         \a startUtc_d + i × \a step_d
+
+ Each time is calculated directly from the start time (rather than by adding
+ the step to the previous one), so rounding errors do not accumulate along the
+ series.
+
+ \par When to call this function
+    When you need the times for a whole block of regularly spaced samples at
+    once - for example, to pass to a batch routine such as
+    sun_nrelApparentBatch(). If that routine takes separate arrays of times,
+    call sky_updateTimesColumns() instead.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    int     i;
+    double  j2kUtc_d;
+
+    REQUIRE_NOT_NULL(d);
+    REQUIRE(count >= 0);
+    REQUIRE((count == 0) || (t != NULL));
+
+    for (i = 0; i < count; i++) {
+        j2kUtc_d = startUtc_d + i * step_d;
+        t[i].mjdUtc = j2kUtc_d + MJD_J2000;
+        t[i].j2kUT1_d = j2kUtc_d + d->deltaUT_d;
+        t[i].j2kTT_d  = j2kUtc_d + d->deltaTT_d;
+        t[i].j2kTT_cy = t[i].j2kTT_d / JUL_CENT;
+        t[i].era_rad = (ERA_J2000_TURNS + ERA_RATE * t[i].j2kUT1_d) * TWOPI;
+        t[i].j2kUT1Day_d = floor(t[i].j2kUT1_d);
+        t[i].j2kUT1Frac_d = t[i].j2kUT1_d - t[i].j2kUT1Day_d;
+    }
+}
+
+
+
+GLOBAL void sky_updateTimesColumns(double            startUtc_d,
+                                   double            step_d,
+                                   int               count,
+                                   const Sky_DeltaTs *d,
+                                   double            j2kUT1_d[],
+                                   double            j2kTT_cy[],
+                                   double            era_rad[])
+/*! Fill separate arrays (a "structure of arrays") with the UT1 time, TT time
+    and Earth Rotation Angle for a series of equally spaced UTC times. The
+    values are the same as the corresponding fields that sky_updateTimes()
+    would set.
+ \param[in]  startUtc_d  First time, in "J2KD" form, as for sky_updateTimes()
+ \param[in]  step_d      Interval between times (days). May be negative.
+ \param[in]  count       Number of times (elements of each array)
+ \param[in]  d           The various delta T values as set by one of
+                         sky_initTime(), sky_initTimeDetailed() or
+                         sky_initTimeSimple()
+ \param[out] j2kUT1_d    Days since J2000.0, UT1 timescale, for time
+                         \a startUtc_d + i × \a step_d in element i. May be
+                         NULL if not required.
+ \param[out] j2kTT_cy    Julian centuries since J2000.0, TT timescale. May be
+                         NULL if not required.
+ \param[out] era_rad     Earth Rotation Angle (radian). May be NULL if not
+                         required.
+
+ Each array is filled by its own simple loop, which a compiler can vectorise.
+
+ \par When to call this function
+    When a batch routine takes its times as plain arrays - for example
+    sun_nrelApparentBatch() (which takes \a j2kTT_cy) or sky0_tirsToAppBatch()
+    (which takes \a j2kUT1_d).
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    int     i;
+    double  startUT1_d;         // first time, UT1 timescale (days)
+    double  startTT_d;          // first time, TT timescale (days)
+
+    REQUIRE_NOT_NULL(d);
+    REQUIRE(count >= 0);
+
+    startUT1_d = startUtc_d + d->deltaUT_d;
+    startTT_d  = startUtc_d + d->deltaTT_d;
+
+    if (j2kUT1_d != NULL) {
+        for (i = 0; i < count; i++) {
+            j2kUT1_d[i] = startUT1_d + i * step_d;
+        }
+    }
+    if (j2kTT_cy != NULL) {
+        for (i = 0; i < count; i++) {
+            j2kTT_cy[i] = (startTT_d + i * step_d) / JUL_CENT;
+        }
+    }
+    if (era_rad != NULL) {
+        for (i = 0; i < count; i++) {
+            era_rad[i] = (ERA_J2000_TURNS
+                          + ERA_RATE * (startUT1_d + i * step_d)) * TWOPI;
+        }
+    }
+}
+
+
+
+GLOBAL void sky_initTimeStep(double            step_d,
+                             const Sky_DeltaTs *d,
+                             const Sky_Times   *start,
+                             Sky_TimeStep      *step)
+/*! Set up a regular sequence of times, starting at \a start, for
+    sky_advanceTimes() to step through.
+ \param[in]  step_d  Interval between successive times (days). May be
+                     negative.
+ \param[in]  d       The various delta T values as set by one of
+                     sky_initTime(), sky_initTimeDetailed() or
+                     sky_initTimeSimple()
+ \param[in]  start   The first time of the sequence, as set by
+                     sky_updateTimes2() (or sky_updateTimes(), with less
+                     precision)
+ \param[out] step    Sequence, to be passed to sky_advanceTimes()
+
+ \par When to call this function
+    Once, before a loop that calls sky_advanceTimes(), and again whenever
+    \a d is changed (for example by skyiers_refresh()), passing the latest
+    times as \a start.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    REQUIRE_NOT_NULL(d);
+    REQUIRE_NOT_NULL(start);
+    REQUIRE_NOT_NULL(step);
+
+    step->startDay_d = start->j2kUT1Day_d;
+    step->startFrac_d = start->j2kUT1Frac_d;
+    step->step_d = step_d;
+    step->deltaUT_d = d->deltaUT_d;
+    step->deltaT_d = d->deltaT_d;
+    step->count = 0;
+}
+
+
+
+GLOBAL void sky_advanceTimes(Sky_TimeStep *step, Sky_Times *t)
+/*! Calculate the next time of the sequence set up by sky_initTimeStep(),
+    without recalculating it from a UTC time.
+ \param[in,out] step  Sequence, as set up by sky_initTimeStep(). Its count
+                      of steps taken is incremented.
+ \param[out]    t     Times, for \a start + \a n × \a step_d, where \a n is
+                      the number of calls since sky_initTimeStep(). All
+                      fields are set. Field \a era_rad is reduced to the range
+                      [0, 2π).
+
+ Each time is calculated afresh from the start time and the number of steps
+ taken, not by adding the step to the previous time, so rounding errors do not
+ accumulate. The offset from the start time is split into whole days and a
+ fraction before it is added to the start time's UT1 fraction of a day, so
+ that fraction keeps its full resolution of about 10 picoseconds.
+
+ \par When to call this function
+    Once per sample, in place of sky_updateTimes(), in a loop that processes
+    regularly spaced times one at a time - for example, a high-rate control
+    loop or an ephemeris generator. For a whole block of times at once, call
+    sky_updateTimesBatch() instead.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  offset_d;           // Time since the start of the sequence (days)
+    double  days;               // Whole days of offset_d
+    double  frac;               // UT1 fraction of a day, before carry
+    double  k;                  // Whole days carried from frac
+    double  turns;              // Earth Rotation Angle (revolutions)
+
+    REQUIRE_NOT_NULL(step);
+    REQUIRE_NOT_NULL(t);
+
+    step->count++;
+    offset_d = (double)step->count * step->step_d;
+    days = floor(offset_d);
+    frac = step->startFrac_d + (offset_d - days);
+    k = floor(frac);
+    t->j2kUT1Day_d = step->startDay_d + days + k;
+    t->j2kUT1Frac_d = frac - k;
+
+    t->j2kUT1_d = t->j2kUT1Day_d + t->j2kUT1Frac_d;
+    t->mjdUtc = (t->j2kUT1Day_d + MJD_J2000)
+                + (t->j2kUT1Frac_d - step->deltaUT_d);
+    t->j2kTT_d = t->j2kUT1Day_d + (t->j2kUT1Frac_d + step->deltaT_d);
+    t->j2kTT_cy = t->j2kTT_d / JUL_CENT;
+
+    /* As in sky_updateTimes2(), drop the whole revolutions of the day part */
+    turns = t->j2kUT1Frac_d + ERA_J2000_TURNS
+            + ERA_RATE_EXCESS * (t->j2kUT1Day_d + t->j2kUT1Frac_d);
+    t->era_rad = (turns - floor(turns)) * TWOPI;
+}
+
+
+
+#ifdef POSIX_SYSTEM
+GLOBAL void sky_unixTimespecToJ2kd2(struct timespec uTs,
+                                    double          *j2kUtcDay_d,
+                                    double          *j2kUtcFrac_d)
+/*! Convert a time in Unix timespec format to days since 2000 Jan 1, noon UTC,
+    as a whole number of days and a fraction of a day, for
+    sky_updateTimes2().
+ \param[in]  uTs           time in "timespec" format, as for
+                           sky_unixTimespecToJ2kd()
+ \param[out] j2kUtcDay_d   Whole number of days since Julian Date 2 451 545.0,
+                           UTC timescale
+ \param[out] j2kUtcFrac_d  Fraction of a day, in the range [0, 1)
+ \note
+    The macro POSIX_SYSTEM must be defined at compile time to use this function.
+ \par When to call this routine
+    Call this before each call to sky_updateTimes2().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    long    days;
+    long    secs;               // seconds since start of the day
+
+    REQUIRE_NOT_NULL(j2kUtcDay_d);
+    REQUIRE_NOT_NULL(j2kUtcFrac_d);
+
+    /* Integer arithmetic is exact. (% may give a negative remainder) */
+    days = (long)((uTs.tv_sec - TIME_T_J2000) / 86400);
+    secs = (long)((uTs.tv_sec - TIME_T_J2000) % 86400);
+    if (secs < 0) {
+        secs += 86400;
+        days--;
+    }
+    *j2kUtcDay_d = (double)days;
+    *j2kUtcFrac_d = ((double)secs + (double)uTs.tv_nsec / 1e9) / 86400.0;
+}
+#endif
+
+
+
+GLOBAL void sky_initLeapSeconds(Sky_LeapSeconds *leap)
+/*! Set up a table of leap seconds from the list built into this module.
+ \param[out] leap   Table giving TAI - UTC for each half year from 1972 to 2099
+
+ The last leap second in the built-in list is that at the end of 2016. Any
+ later ones can be added with sky_setLeapSecond(), or the whole table can be
+ replaced from a file with skyiers_loadLeapSeconds().
+
+ \par When to call this function
+    At program initialisation time, if you will be calling
+    sky_updateTimesLeap() or sky_leapSeconds_s().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    int     i;
+
+    REQUIRE_NOT_NULL(leap);
+
+    for (i = 0; i < ARRAY_SIZE(leapTable); i++) {
+        sky_setLeapSecond(leapTable[i].mjd, leapTable[i].deltaAT_s, leap);
+    }
+}
+
+
+
+GLOBAL void sky_setLeapSecond(int mjdUtc, int deltaAT_s, Sky_LeapSeconds *leap)
+/*! Set the value of TAI - UTC from a given date onwards. This adds a leap
+    second to the table (or corrects one).
+ \param[in]     mjdUtc     Modified Julian Date of the first day on which the
+                           new value applies. This will be 1 January or 1 July.
+ \param[in]     deltaAT_s  (= TAI - UTC). The new cumulative number of leap
+                           seconds (seconds)
+ \param[in,out] leap       Table of leap seconds. The value is set for the half
+                           year containing \a mjdUtc and every later one.
+
+ \par When to call this function
+    After sky_initLeapSeconds(), when a new leap second is announced. If you
+    call it for several dates, call it in date order.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    int     i;
+
+    REQUIRE_NOT_NULL(leap);
+    REQUIRE((deltaAT_s >= 0) && (deltaAT_s <= 127));
+
+    for (i = leapBucket(mjdUtc); i < SKY_LEAP_BUCKETS; i++) {
+        leap->deltaAT_s[i] = (signed char)deltaAT_s;
+    }
+}
+
+
+
+GLOBAL int sky_leapSeconds_s(const Sky_LeapSeconds *leap, double mjdUtc)
+/*! Return the value of TAI - UTC at a given time.
+ \returns               TAI - UTC (seconds)
+ \param[in]  leap       Table of leap seconds, as set up by
+                        sky_initLeapSeconds()
+ \param[in]  mjdUtc     Modified Julian Date (= JD - 2 400 000.5), UTC
+                        timescale
+
+ Before 1972, UTC was not an integral number of seconds from TAI, and the value
+ for 1972 January 1 (10 s) is returned. After 2099, the value for the second
+ half of 2099 is returned.
+
+ \par When to call this function
+    Whenever you need the number of leap seconds - for example, to pass to
+    sky_initTime(). sky_updateTimesLeap() calls it for you.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    REQUIRE_NOT_NULL(leap);
+
+    return leap->deltaAT_s[leapBucket(mjdUtc)];
+}
+
+
+
+GLOBAL void sky_updateTimesLeap(double                j2kUtc_d,
+                                const Sky_DeltaTs     *d,
+                                const Sky_LeapSeconds *leap,
+                                Sky_Times             *t)
+/*! Convert the given "J2KD" in the UTC timescale to the other timescales, as
+    for sky_updateTimes(), but with TT - UTC found from a table of leap seconds
+    for this particular time, rather than taken from \a d.
+ \param[in]  j2kUtc_d  Date in "J2KD" form, as for sky_updateTimes()
+ \param[in]  d         The various delta T values as set by one of
+                       sky_initTime(), sky_initTimeDetailed(),
+                       sky_initTimeSimple() or skyiers_refresh(). Only field
+                       \a deltaUT_d (UT1 - UTC) is used.
+ \param[in]  leap      Table of leap seconds, as set up by
+                       sky_initLeapSeconds()
+ \param[out] t         All fields are updated
+
+ Over a long span of time, UT1 - UTC also changes, by up to 0.9 s either side
+ of each leap second. If that matters to you, update \a d from time to time,
+ for example with skyiers_refresh().
+
+ \par When to call this function
+    In place of sky_updateTimes(), when processing times that span one or more
+    leap seconds - for example, years of logged data in a single pass.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  deltaTT_d;          // TT - UTC at this time (days)
+
+    REQUIRE_NOT_NULL(d);
+    REQUIRE_NOT_NULL(leap);
+    REQUIRE_NOT_NULL(t);
+
+    t->mjdUtc = j2kUtc_d + MJD_J2000;
+    deltaTT_d = (sky_leapSeconds_s(leap, t->mjdUtc) + 32.184) / 86400.0;
+
+    t->j2kUT1_d = j2kUtc_d + d->deltaUT_d;
+    t->j2kTT_d  = j2kUtc_d + deltaTT_d;
+    t->j2kTT_cy = t->j2kTT_d / JUL_CENT;
+    t->era_rad = (ERA_J2000_TURNS + ERA_RATE * t->j2kUT1_d) * TWOPI;
+    t->j2kUT1Day_d = floor(t->j2kUT1_d);
+    t->j2kUT1Frac_d = t->j2kUT1_d - t->j2kUT1Day_d;
 }
 
 
@@ -499,7 +971,9 @@ GLOBAL void sky_updateTimesFromMjd(double mjdUtc,
     t->j2kUT1_d = mjdUT1 - MJD_J2000;
     t->j2kTT_d  = mjdTT - MJD_J2000;
     t->j2kTT_cy = t->j2kTT_d / JUL_CENT;
-    t->era_rad = (0.7790572732640 + 1.00273781191135488 * t->j2kUT1_d) * TWOPI;
+    t->era_rad = (ERA_J2000_TURNS + ERA_RATE * t->j2kUT1_d) * TWOPI;
+    t->j2kUT1Day_d = floor(t->j2kUT1_d);
+    t->j2kUT1Frac_d = t->j2kUT1_d - t->j2kUT1Day_d;
 }
 
 
@@ -719,6 +1193,48 @@ LOCAL double calendarToJ2kd(int year, int month, int day)
 }
 
 
+
+LOCAL int leapBucket(double mjdUtc)
+/* Find the half year containing a given date, as an index into a
+   Sky_LeapSeconds table. Every fourth year from 1972 to 2096 is a leap year, so
+   the calendar repeats every 1461 days, and no searching is needed.
+ Returns
+    Index of the half year (0 = first half of 1972), limited to the range of
+    the table
+ Inputs
+    mjdUtc - Modified Julian Date, UTC timescale
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  dayNum;
+    long    days;               // Days since 1972 January 1
+    long    cycle;              // Number of complete 4-year cycles
+    long    dayOfCycle;
+    long    year;               // Years since 1972
+    long    dayOfYear;
+    long    julyFirst;          // Day of year of 1 July
+    long    bucket;
+
+    dayNum = floor(mjdUtc);
+    if (dayNum < MJD_1JAN1972) {
+        return 0;
+    }
+    days = (long)dayNum - MJD_1JAN1972;
+    cycle = days / 1461;
+    dayOfCycle = days % 1461;
+    if (dayOfCycle < 366) {
+        year = 4 * cycle;               // The leap year of the cycle
+        dayOfYear = dayOfCycle;
+        julyFirst = 182;
+    } else {
+        year = 4 * cycle + 1 + (dayOfCycle - 366) / 365;
+        dayOfYear = (dayOfCycle - 366) % 365;
+        julyFirst = 181;
+    }
+    bucket = 2 * year + ((dayOfYear >= julyFirst) ? 1 : 0);
+    return (bucket < SKY_LEAP_BUCKETS) ? (int)bucket : SKY_LEAP_BUCKETS - 1;
+}
+
+
 /*- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 /*! \page page-timescales   Timescales, and converting between them
@@ -799,6 +1315,14 @@ LOCAL double calendarToJ2kd(int year, int month, int day)
     time in the UTC timescale to various times in the other timescales, ready
     for use.
 
+    ΔAT changes by one second at each leap second. If the times you are
+    processing span one or more leap seconds (for example, years of logged
+    data), set up a table of leap seconds with sky_initLeapSeconds() (or
+    skyiers_loadLeapSeconds()), and call sky_updateTimesLeap() instead of
+    sky_updateTimes(). It finds ΔAT, and hence ΔTT, for each time separately.
+    (For option D, the skyiers module reads the daily values from the IERS
+    finals files.)
+
     Pursuit of really accurate UT1 (as outlined in 3C and 3D above) really only
     makes sense if your system clock is accurately synchronised to UTC.
 
@@ -169,6 +169,24 @@ typedef struct {
     double   deltaTT_d;     //!< TT - UTC, scaled to days
 } Sky_DeltaTs;
 
+/*      First year covered by a Sky_LeapSeconds table, and the number of
+        half-years it covers (1972 to 2099) */
+#define SKY_LEAP_FIRST_YEAR     1972
+#define SKY_LEAP_BUCKETS        256
+
+/*!     TAI - UTC (the number of leap seconds) for every half year from 1972,
+        set up by sky_initLeapSeconds(), and perhaps updated by
+        sky_setLeapSecond() or skyiers_loadLeapSeconds(). Leap seconds are
+        only ever inserted at the end of June or December, so one value per
+        half year is enough for the value at any time to be looked up without
+        searching. Do not modify the field directly. */
+typedef struct {
+    signed char deltaAT_s[SKY_LEAP_BUCKETS]; /*!< TAI - UTC from 1 January
+                                                  (even elements) or 1 July
+                                                  (odd elements) of each year
+                                                  (seconds) */
+} Sky_LeapSeconds;
+
 /*!     This structure contains the continuously varying time (and earth
         rotation) data, in various forms that we will find useful. 
 
@@ -187,8 +205,23 @@ typedef struct {
     double     j2kTT_d;   //!< days since J2000.0, TT timescale             [D]
     double     j2kTT_cy;  //!< Julian centuries since J2000.0, TT timescale [T]
     double     era_rad;   //!< Earth Rotation Angle (radian)                [θ]
+    double     j2kUT1Day_d; /*!< j2kUT1_d split into a whole number of days...*/
+    double     j2kUT1Frac_d;/*!< ... and the fraction of a day, [0, 1), kept to
+                                 full precision by sky_updateTimes2() */
 } Sky_Times;
 
+/*!     A regular sequence of times, for sky_advanceTimes() to step through,
+        with the delta T values it needs, pre-scaled to days. Set it up with
+        sky_initTimeStep(), and do not modify the fields directly. */
+typedef struct {
+    double     startDay_d;  //!< first time, UT1: whole days since J2000.0
+    double     startFrac_d; //!< first time, UT1: fraction of a day
+    double     step_d;      //!< interval between successive times (days)
+    double     deltaUT_d;   //!< UT1 - UTC, scaled to days
+    double     deltaT_d;    //!< TT - UT1, scaled to days
+    long       count;       //!< number of steps taken since the first time
+} Sky_TimeStep;
+
 /*!     This structure contains polar motion parameters and a rotation
         matrix. Do not modify any of these fields directly - use the
         sky_setPolarMotion() function to do that. In general, you won't
@@ -239,13 +272,57 @@ void sky_updateTimes(double            j2kUtc_d,
                      const Sky_DeltaTs *d,
                      Sky_Times *t);
 
+/*      3a. Or, if you need time resolution finer than a microsecond, keep the
+        time as days and fraction of a day, and call sky_updateTimes2(). Then
+        use sky0_appToTirs2() or sky1_appToTirs2() in step 5 below. */
+#ifdef POSIX_SYSTEM
+void sky_unixTimespecToJ2kd2(struct timespec uTs,
+                             double          *j2kUtcDay_d,
+                             double          *j2kUtcFrac_d);
+#endif
+void sky_updateTimes2(double            j2kUtcDay_d,
+                      double            j2kUtcFrac_d,
+                      const Sky_DeltaTs *d,
+                      Sky_Times         *t);
+
+/*      3b. Or, if your times span one or more leap seconds, set up a table of
+        leap seconds once, and call sky_updateTimesLeap() in place of
+        sky_updateTimes() */
+void sky_initLeapSeconds(Sky_LeapSeconds *leap);
+void sky_setLeapSecond(int mjdUtc, int deltaAT_s, Sky_LeapSeconds *leap);
+int sky_leapSeconds_s(const Sky_LeapSeconds *leap, double mjdUtc);
+void sky_updateTimesLeap(double                j2kUtc_d,
+                         const Sky_DeltaTs     *d,
+                         const Sky_LeapSeconds *leap,
+                         Sky_Times             *t);
+
 #ifdef INCLUDE_MJD_ROUTINES
-/*      3b. Update the other astronomical times */
+/*      3c. Update the other astronomical times */
 void sky_updateTimesFromMjd(double            mjdUtc,
                             const Sky_DeltaTs *d,
                             Sky_Times *t);
 #endif
 
+/*      3d. Or, for many regularly spaced times, fill a block of them at once,
+        or step through them one at a time */
+void sky_updateTimesBatch(double            startUtc_d,
+                          double            step_d,
+                          int               count,
+                          const Sky_DeltaTs *d,
+                          Sky_Times         t[]);
+void sky_updateTimesColumns(double            startUtc_d,
+                            double            step_d,
+                            int               count,
+                            const Sky_DeltaTs *d,
+                            double            j2kUT1_d[],
+                            double            j2kTT_cy[],
+                            double            era_rad[]);
+void sky_initTimeStep(double            step_d,
+                      const Sky_DeltaTs *d,
+                      const Sky_Times   *start,
+                      Sky_TimeStep      *step);
+void sky_advanceTimes(Sky_TimeStep *step, Sky_Times *t);
+
 
 /*      4. Call routines (from other modules, not this one) to obtain the
         position of your chosen star, planet or the sun in apparent coordinates
@@ -306,6 +383,15 @@ void sky_mjdToCalTime(double mjd,
 /*
  * Global #defines and typedefs
  */
+/*!     Atmospheric refraction models. Select one for each site with
+        sky_setSiteRefraction() */
+typedef enum {
+    SKY_REFRAC_TWO_FORMULA, //!< Two simple formulae, above & below 15° (default)
+    SKY_REFRAC_SPA,         //!< Formula used by NREL SPA (Sæmundsson's)
+    SKY_REFRAC_BENNETT,     //!< Bennett's formula
+    SKY_REFRAC_MODEL_COUNT  //!< (Number of models - not a model)
+} Sky_RefractionModel;
+
 /*!     Site properties. Declare one object of the following type for each site
         that you want to calculate sky positions for (typically one site). Do
         not modify any of the fields in this structure directly; use the
@@ -321,12 +407,63 @@ typedef struct {
     double     diurnalAberr;  //!< Diurnal aberration: caused by earth rotation
     double     refracPT;      //!< Refraction correction: pressure & temperature
     double     timeZone_d;    //!< time zone offset from UTC (fraction of a day)
+    Sky_RefractionModel refracModel; //!< Atmospheric refraction model
     V3D_Matrix *azElM;        //!< points to either azElPolM or azElBaseM
     V3D_Matrix azElPolM;      //!< rotation matrix from TIRS to Az/El coords
     V3D_Matrix azElBaseM;     //!< as above, but excluding polar motion correctn
     V3D_Matrix haDecM;        //!< rotation matrix from Az/El to HA/Dec coords
 } Sky_SiteProp;
 
+/*!     Number of doubles of storage needed per site by sky_setSiteBatchStorage()
+        */
+#define SKY_SITEBATCH_DOUBLES 13
+
+/*!     Properties of many sites, arranged as one array per property (a
+        "structure of arrays"), for use by sky_siteTirsToTopoBatch(). Element i
+        of each array belongs to site number i. The arrays are in storage that
+        you supply to sky_setSiteBatchStorage(), and you set up each site by
+        calling sky_setSiteBatchEntry(). As with Sky_SiteProp, do not modify the
+        fields directly. */
+typedef struct {
+    int        count;         //!< Number of sites
+    double     *azElM[3][3];  /*!< Element [r][c] of each site's rotation matrix
+                                   from TIRS to Az/El coords */
+    double     *diurnalAberr; //!< Diurnal aberration of each site
+    double     *rhoSin_au;    //!< ae*ρ*sin(ϕ - ϕ′) of each site (AU)
+    double     *rhoCos_au;    //!< -ae*ρ*cos(ϕ - ϕ′) of each site (AU)
+    double     *refracPT;     //!< Refraction correction of each site
+    Sky_RefractionModel refracModel; /*!< Atmospheric refraction model (the
+                                          same for all sites in the batch) */
+} Sky_SiteBatch;
+
+/*!     Compact, single precision copy of the site properties needed by
+        sky_siteTirsToTopoCompact(), set up by sky_setSiteCompact(). It takes
+        56 bytes, instead of the 296 bytes of Sky_SiteProp, at the cost of
+        some accuracy (see \ref page-compact-site). */
+typedef struct {
+    float      azElM[3][3];   //!< rotation matrix from TIRS to Az/El coords
+    float      rhoSin_au;     //!< ae*ρ*sin(ϕ - ϕ′) geocentre-to-site x (AU)
+    float      rhoCos_au;     //!< -ae*ρ*cos(ϕ - ϕ′) geocentre-to-site z (AU)
+    float      diurnalAberr;  //!< Diurnal aberration: caused by earth rotation
+    float      refracPT;      //!< Refraction correction: pressure & temperature
+    Sky_RefractionModel refracModel; //!< Atmospheric refraction model
+} Sky_SiteCompact;
+
+/*      Largest number of points in a horizon mask */
+#define SKY_HORIZON_MAX_POINTS  360
+
+/*!     Elevation of the local horizon (terrain, buildings etc.) as a function
+        of azimuth, for one site. Set up by sky_setHorizonMask() (or
+        skysites_loadHorizon()). The points are equally spaced in azimuth,
+        starting at North. */
+typedef struct {
+    int        count;         //!< Number of points
+    double     pointsPerRad;  //!< count / 2π
+    double     elevation_rad[SKY_HORIZON_MAX_POINTS + 1]; /*!< Elevation of the
+                                   horizon at each point (radian). The element
+                                   after the last point is a copy of the first */
+} Sky_HorizonMask;
+
 
 /*
  * Global functions available to be called by other modules
@@ -349,6 +486,8 @@ void sky_setSiteTempPress(double temperature_degC,
                           Sky_SiteProp *site);
 void sky_setSiteTimeZone(double timeZone_h,
                          Sky_SiteProp *site);
+void sky_setSiteRefraction(Sky_RefractionModel model,
+                           Sky_SiteProp        *site);
 
 /*      Call the following if you have a surface for which you want to calculate
         the incidence angle of the rays from the celestial object being tracked.
@@ -372,6 +511,10 @@ void sky_siteTirsToTopo(const V3D_Vector   *terInterV,
                         double             dist_au,
                         const Sky_SiteProp *site,
                         Sky_SiteHorizon *topo);
+void sky_siteTirsToTopoV(const V3D_Vector   *terInterV,
+                         double             dist_au,
+                         const Sky_SiteProp *site,
+                         V3D_Vector         *topoV);
 void sky_siteAzElToHaDec(const V3D_Vector   *topoV,
                          const Sky_SiteProp *site,
                          double *hourAngle_rad,
@@ -379,6 +522,64 @@ void sky_siteAzElToHaDec(const V3D_Vector   *topoV,
 double sky_siteIncidence_rad(const V3D_Vector *topoV,
                              const V3D_Vector *surfaceV);
 
+/*      To go the other way - from an observed direction (e.g. encoder readings)
+        back to terrestrial intermediate coordinates - call one of the following
+        and then sky0_tirsToApp() or sky1_tirsToApp() (or their batch versions)
+        to get apparent coordinates. */
+void sky_siteTopoToTirs(const V3D_Vector   *topoV,
+                        double             dist_au,
+                        const Sky_SiteProp *site,
+                        V3D_Vector         *terInterV);
+void sky_siteTopoToTirsBatch(int                count,
+                             const V3D_Vector   topoV[],
+                             double             dist_au,
+                             const Sky_SiteProp *site,
+                             V3D_Vector         terInterV[]);
+
+/*      For a large number of sites all looking at the same object, copy each
+        site's properties into a Sky_SiteBatch, and then convert for all of them
+        at once */
+void sky_setSiteBatchStorage(int           count,
+                             double        storage[],
+                             Sky_SiteBatch *batch);
+void sky_setSiteBatchEntry(int                index,
+                           const Sky_SiteProp *site,
+                           Sky_SiteBatch      *batch);
+void sky_siteTirsToTopoBatch(const V3D_Vector    *terInterV,
+                             double              dist_au,
+                             const Sky_SiteBatch *batch,
+                             Sky_SiteHorizon     topo[]);
+
+/*      For very large numbers of sites, where memory matters more than
+        sub-arcsecond accuracy, keep a compact copy of each site instead */
+void sky_setSiteCompact(const Sky_SiteProp *site,
+                        Sky_SiteCompact    *compact);
+void sky_siteTirsToTopoCompact(const V3D_Vector      *terInterV,
+                               double                dist_au,
+                               const Sky_SiteCompact *compact,
+                               Sky_SiteHorizon       *topo);
+
+/*      For sites whose view of the sky is blocked by terrain or buildings, set
+        up a horizon mask. Then use it to test visibility, or pass it to
+        sun_riseSetMask() or moon_riseSetMask() */
+void sky_setHorizonMask(int             count,
+                        const double    elevation_deg[],
+                        Sky_HorizonMask *mask);
+double sky_horizonElevation_rad(const Sky_HorizonMask *mask,
+                                double                azimuth_rad);
+bool sky_siteIsVisible(const Sky_SiteHorizon *topo,
+                       const Sky_HorizonMask *mask);
+double sky_horizonRiseSetEl_rad(const Sky_HorizonMask *mask,
+                                double                azimuth_rad,
+                                double                semiDiameter_rad);
+
+/*      Internal: used by sun_riseSetMask() and moon_riseSetMask() only. Not
+        part of the application interface */
+double sky_horizonRiseSetStep_d(double t0_d,
+                                double r0_d,
+                                double t1_d,
+                                double r1_d);
+
 
 /*
  * Global variables accessible by other modules
@@ -397,7 +598,8 @@ double sky_siteIncidence_rad(const V3D_Vector *topoV,
  * 
  *  Define the macro POSIX_SYSTEM if you are using a system that supports the
  *  POSIX standard (a common Unix standard) and you have a use for either of the
- *  routines sky_unixTimespecToJ2kd() or sky_unixTimespecToMjd()
+ *  routines sky_unixTimespecToJ2kd() or sky_unixTimespecToMjd(), or for the
+ *  routines skyeph_open() and skyeph_close() which memory-map an ephemeris file
  */
 
 #endif /* SKY_H */
@@ -53,6 +53,13 @@ DEFINE_THIS_FILE;                       // For use by REQUIRE() - assertions.
 /*      Convert from units of 0.1 milliarcsec to radians */
 #define MILLIARCSECx10_TO_RAD  (PI / (180.0 * 3600.0 * 10000.0))
 
+/*      Coefficients of sky0_gmSiderealTimeSpa(). B1 is the rate of change of
+        sidereal time (radian per day) */
+#define GMST_B0_RAD             (280.46061837 * DEG2RAD)
+#define SIDEREAL_RATE_RADPD     (360.98564736629 * DEG2RAD)
+#define GMST_B2_RAD             (0.000387933 * DEG2RAD)
+#define GMST_B3_RAD             ((-1.0 / 38710000.0) * DEG2RAD)
+
 /*      Nutation constants from NREL SPA algorithm */
 #define Y_COUNT 63
 enum {TERM_X0, TERM_X1, TERM_X2, TERM_X3, TERM_X4, TERM_X_COUNT};
@@ -407,10 +414,10 @@ GLOBAL double sky0_gmSiderealTimeSpa(double du)
     control loop, it will call this function for you.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 {
-    static const double B0 = 280.46061837 * DEG2RAD;        // 67310.54841 s
-    static const double B1 = 360.98564736629 * DEG2RAD;     // 86636.55536791 s
-    static const double B2 = 0.000387933 * DEG2RAD;         // 0.093104 s
-    static const double B3 = (-1.0 / 38710000.0) * DEG2RAD; // -6.2e-6 s
+    static const double B0 = GMST_B0_RAD;                   // 67310.54841 s
+    static const double B1 = SIDEREAL_RATE_RADPD;           // 86636.55536791 s
+    static const double B2 = GMST_B2_RAD;                   // 0.093104 s
+    static const double B3 = GMST_B3_RAD;                   // -6.2e-6 s
 #if 0
     static const double B0d = 4.89496121274; // 3579;
     static const double B1d = 6.300388098984957;
@@ -481,6 +488,157 @@ GLOBAL void sky0_appToTirs(const V3D_Vector *appV,
 }
 
 
+
+GLOBAL void sky0_appToTirs2(const V3D_Vector *appV,
+                            double           j2kUT1Day_d,
+                            double           j2kUT1Frac_d,
+                            double           eqEq_rad,
+                            V3D_Vector       *terInterV)
+/*! Convert a position in geocentric apparent coordinates to geocentric
+    coordinates in the Terrestrial Intermediate Reference System, as for
+    sky0_appToTirs(), but with the time in two parts so that the sidereal time
+    keeps the full resolution of the fraction of a day.
+ \param[in]  appV          Position vector of apparent place, as for
+                           sky0_appToTirs()
+ \param[in]  j2kUT1Day_d   Whole number of days since J2000.0, UT1 timescale
+                           (field \a j2kUT1Day_d of the Sky_Times structure)
+ \param[in]  j2kUT1Frac_d  Fraction of a day to add to \a j2kUT1Day_d (field
+                           \a j2kUT1Frac_d of the Sky_Times structure)
+ \param[in]  eqEq_rad      Equation of the equinoxes (radian)
+ \param[out] terInterV     Position vector in Terrestrial Intermediate
+                           Reference System
+
+ The whole revolutions of the Earth in \a j2kUT1Day_d are dropped before
+ the fraction of a day is added, so the sidereal time is not limited by the
+ rounding of the product of the rotation rate and the full time. The result
+ differs from that of sky0_appToTirs() by no more than a few microarcseconds.
+
+ \par When to call this function
+    In place of sky0_appToTirs(), after calling sky_updateTimes2(), if you need
+    the Earth's rotation to better than a microsecond of time.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double      tu;         // Julian centuries since J2000.0, UT1 timescale
+    double      gast_rad;   // Greenwich Apparent Sidereal Time (GAST)
+    V3D_Matrix  earthRotM;  // rotation matrix for current GAST
+
+    REQUIRE_NOT_NULL(appV);
+    REQUIRE_NOT_NULL(terInterV);
+
+    /* As sky0_gmSiderealTimeSpa(), but with B1 * du split into whole
+       revolutions (2π per whole day, dropped), and the remainder */
+    tu = (j2kUT1Day_d + j2kUT1Frac_d) / JUL_CENT;
+    gast_rad = GMST_B0_RAD
+               + (SIDEREAL_RATE_RADPD - TWOPI) * j2kUT1Day_d
+               + SIDEREAL_RATE_RADPD * j2kUT1Frac_d
+               + tu * tu * (GMST_B2_RAD + tu * GMST_B3_RAD)
+               + eqEq_rad;
+
+    /* Create earth rotation matrix from the current Apparent Sidereal Time */
+    v3d_createRotationMatrix(&earthRotM, Zaxis, normalize(gast_rad, TWOPI));
+
+    /* Convert apparent posn to posn in Terrestrial Intermediate Ref System */
+    v3d_multMxV(terInterV, &earthRotM, appV);
+}
+
+
+
+GLOBAL void sky0_tirsToApp(const V3D_Vector *terInterV,
+                           double           j2kUT1_d,
+                           double           eqEq_rad,
+                           V3D_Vector       *appV)
+/*! Convert a position in geocentric coordinates in the Terrestrial
+    Intermediate Reference System back to geocentric apparent coordinates. This
+    is the inverse of sky0_appToTirs().
+ \param[in] terInterV  Position vector in Terrestrial Intermediate Ref System,
+                       e.g. as returned by sky_siteTopoToTirs()
+ \param[in] j2kUT1_d   days since J2000.0, UT1 timescale, as for
+                       sky0_appToTirs()
+ \param[in] eqEq_rad   Equation of the equinoxes (radian), as for
+                       sky0_appToTirs()
+
+ \param[out] appV      Position vector of apparent place (equatorial
+                       coordinates). May be the same vector as \a terInterV.
+
+ \par When to call this function
+    After calling sky_siteTopoToTirs(), to find the apparent right ascension
+    and declination of the direction observed.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double      gast_rad;   // Greenwich Apparent Sidereal Time (GAST)
+    V3D_Matrix  earthRotM;  // rotation matrix for current GAST
+    V3D_Vector  tirsV;
+
+    REQUIRE_NOT_NULL(terInterV);
+    REQUIRE_NOT_NULL(appV);
+
+    gast_rad = sky0_gmSiderealTimeSpa(j2kUT1_d) + eqEq_rad;
+    v3d_createRotationMatrix(&earthRotM, Zaxis, gast_rad);
+
+    /* The inverse of a rotation matrix is its transpose */
+    tirsV = *terInterV;
+    v3d_multMtransxV(appV, &earthRotM, &tirsV);
+}
+
+
+
+GLOBAL void sky0_tirsToAppBatch(int              count,
+                                const V3D_Vector terInterV[],
+                                const double     j2kUT1_d[],
+                                double           eqEq_rad,
+                                V3D_Vector       appV[])
+/*! Convert a series of positions in the Terrestrial Intermediate Reference
+    System, each at its own time, back to geocentric apparent coordinates.
+ \param[in] count      Number of positions
+ \param[in] terInterV  Array of \a count position vectors in the Terrestrial
+                       Intermediate Reference System, e.g. as returned by
+                       sky_siteTopoToTirsBatch()
+ \param[in] j2kUT1_d   Array of \a count times, in days since J2000.0, UT1
+                       timescale
+ \param[in] eqEq_rad   Equation of the equinoxes (radian), as for
+                       sky0_appToTirs(). This changes by less than 0.003
+                       arcseconds per hour, so one value will do for the whole
+                       batch.
+
+ \param[out] appV      Array of \a count position vectors of apparent place.
+                       May be the same array as \a terInterV.
+
+    The sidereal time is calculated in full for the first time only. For the
+    others, it is advanced from there at a constant sidereal rate. This differs
+    from the full calculation by less than 5e-10 radian (0.0001 arcseconds)
+    for each day between the time and the first time.
+
+ \par When to call this function
+    After calling sky_siteTopoToTirsBatch(), to find the apparent right
+    ascension and declination of a stream of logged directions.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double      gast0_rad;  // Greenwich Apparent Sidereal Time at j2kUT1_d[0]
+    V3D_Matrix  earthRotM;  // rotation matrix for current GAST
+    V3D_Vector  tirsV;
+    int         i;
+
+    REQUIRE(count >= 0);
+    REQUIRE_NOT_NULL(terInterV);
+    REQUIRE_NOT_NULL(j2kUT1_d);
+    REQUIRE_NOT_NULL(appV);
+
+    if (count == 0) {
+        return;
+    }
+    gast0_rad = sky0_gmSiderealTimeSpa(j2kUT1_d[0]) + eqEq_rad;
+
+    for (i = 0; i < count; i++) {
+        v3d_createRotationMatrix(&earthRotM,
+                                 Zaxis,
+                                 gast0_rad + SIDEREAL_RATE_RADPD
+                                             * (j2kUT1_d[i] - j2kUT1_d[0]));
+        tirsV = terInterV[i];
+        v3d_multMtransxV(&appV[i], &earthRotM, &tirsV);
+    }
+}
+
+
 /*
  *------------------------------------------------------------------------------
  *
@@ -94,6 +94,20 @@ void sky0_appToTirs(const V3D_Vector *appV,
                     double           j2kUT1_d,
                     double           eqEq_rad,
                     V3D_Vector  *terInterV);
+void sky0_appToTirs2(const V3D_Vector *appV,
+                     double           j2kUT1Day_d,
+                     double           j2kUT1Frac_d,
+                     double           eqEq_rad,
+                     V3D_Vector       *terInterV);
+void sky0_tirsToApp(const V3D_Vector *terInterV,
+                    double           j2kUT1_d,
+                    double           eqEq_rad,
+                    V3D_Vector       *appV);
+void sky0_tirsToAppBatch(int              count,
+                         const V3D_Vector terInterV[],
+                         const double     j2kUT1_d[],
+                         double           eqEq_rad,
+                         V3D_Vector       appV[]);
 /*
  * Global variables accessible by other modules
  */
@@ -54,6 +54,14 @@ DEFINE_THIS_FILE;                        // For use by REQUIRE() - assertions.
 /*      Convert from units of 0.1 milliarcsec to radians */
 #define MILLIARCSECx10_TO_RAD   (PI / (180.0 * 3600.0 * 10000.0))
 
+/*      Rate of change of sidereal time (radian per day), from the
+        coefficients in sky1_gmSiderealTimeIAU1982() */
+#define SIDEREAL_RATE_RADPD     (TWOPI + secToRad(8640184.812866) / JUL_CENT)
+
+/*      Rate of change of SIDEREAL_RATE_RADPD (radian per day per day), from
+        the Tu^2 coefficient in sky1_gmSiderealTimeIAU1982() */
+#define SIDEREAL_ACCEL_RADPD2   (2.0 * secToRad(0.093104) / (JUL_CENT * JUL_CENT))
+
 #define NUM_TERMS               106
 
 /*      Coefficients of fundamental arguments */
@@ -859,6 +867,155 @@ GLOBAL void sky1_appToTirs(const V3D_Vector *appV,
 }
 
 
+
+GLOBAL void sky1_appToTirs2(const V3D_Vector *appV,
+                            double           j2kUT1Day_d,
+                            double           j2kUT1Frac_d,
+                            double           eqEq_rad,
+                            V3D_Vector       *terInterV)
+/*! Convert a position in geocentric apparent coordinates to geocentric
+    coordinates in the Terrestrial Intermediate Reference System, as for
+    sky1_appToTirs(), but with the time in two parts so that the sidereal time
+    keeps the full resolution of the fraction of a day.
+ \param[in]  appV          Position vector of apparent place, as for
+                           sky1_appToTirs()
+ \param[in]  j2kUT1Day_d   Whole number of days since J2000.0, UT1 timescale
+                           (field \a j2kUT1Day_d of the Sky_Times structure)
+ \param[in]  j2kUT1Frac_d  Fraction of a day to add to \a j2kUT1Day_d (field
+                           \a j2kUT1Frac_d of the Sky_Times structure)
+ \param[in]  eqEq_rad      Equation of the equinoxes (radian)
+ \param[out] terInterV     Position vector in Terrestrial Intermediate
+                           Reference System
+
+ The sidereal time is found for the whole day (where the full time has no
+ fraction to lose) and then advanced by the fraction of a day at the rate of
+ that moment.
+
+ \par When to call this function
+    In place of sky1_appToTirs(), after calling sky_updateTimes2(), if you need
+    the Earth's rotation to better than a microsecond of time.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double      rate_radpd; // Rate of sidereal time at start of day
+    double      gast_rad;   // Greenwich Apparent Sidereal Time (GAST)
+    V3D_Matrix  earthRotM;  // rotation matrix for current GAST
+
+    REQUIRE_NOT_NULL(appV);
+    REQUIRE_NOT_NULL(terInterV);
+
+    /* Over one day, the change in the rate (from the Tu^2 term) contributes
+       up to 20 microarcseconds, and the Tu^3 term nothing measurable */
+    rate_radpd = SIDEREAL_RATE_RADPD
+                 + SIDEREAL_ACCEL_RADPD2 * j2kUT1Day_d;
+    gast_rad = sky1_gmSiderealTimeIAU1982(j2kUT1Day_d)
+               + rate_radpd * j2kUT1Frac_d
+               + eqEq_rad;
+
+    /* Create earth rotation matrix from the current Apparent Sidereal Time */
+    v3d_createRotationMatrix(&earthRotM, Zaxis, normalize(gast_rad, TWOPI));
+
+    /* Convert apparent posn to posn in Terrestrial Intermediate Ref System */
+    v3d_multMxV(terInterV, &earthRotM, appV);
+}
+
+
+
+GLOBAL void sky1_tirsToApp(const V3D_Vector *terInterV,
+                           double           j2kUT1_d,
+                           double           eqEq_rad,
+                           V3D_Vector       *appV)
+/*! Convert a position in geocentric coordinates in the Terrestrial
+    Intermediate Reference System back to geocentric apparent coordinates. This
+    is the inverse of sky1_appToTirs().
+ \param[in] terInterV  Position vector in Terrestrial Intermediate Ref System,
+                       e.g. as returned by sky_siteTopoToTirs()
+ \param[in] j2kUT1_d   days since J2000.0, UT1 timescale, as for
+                       sky1_appToTirs()
+ \param[in] eqEq_rad   Equation of the equinoxes (radian), as for
+                       sky1_appToTirs()
+
+ \param[out] appV      Position vector of apparent place (equatorial
+                       coordinates). May be the same vector as \a terInterV.
+
+ \par When to call this function
+    After calling sky_siteTopoToTirs(), to find the apparent right ascension
+    and declination of the direction observed.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double      gast_rad;   // Greenwich Apparent Sidereal Time (GAST)
+    V3D_Matrix  earthRotM;  // rotation matrix for current GAST
+    V3D_Vector  tirsV;
+
+    REQUIRE_NOT_NULL(terInterV);
+    REQUIRE_NOT_NULL(appV);
+
+    gast_rad = sky1_gmSiderealTimeIAU1982(j2kUT1_d) + eqEq_rad;
+    v3d_createRotationMatrix(&earthRotM, Zaxis, gast_rad);
+
+    /* The inverse of a rotation matrix is its transpose */
+    tirsV = *terInterV;
+    v3d_multMtransxV(appV, &earthRotM, &tirsV);
+}
+
+
+
+GLOBAL void sky1_tirsToAppBatch(int              count,
+                                const V3D_Vector terInterV[],
+                                const double     j2kUT1_d[],
+                                double           eqEq_rad,
+                                V3D_Vector       appV[])
+/*! Convert a series of positions in the Terrestrial Intermediate Reference
+    System, each at its own time, back to geocentric apparent coordinates.
+ \param[in] count      Number of positions
+ \param[in] terInterV  Array of \a count position vectors in the Terrestrial
+                       Intermediate Reference System, e.g. as returned by
+                       sky_siteTopoToTirsBatch()
+ \param[in] j2kUT1_d   Array of \a count times, in days since J2000.0, UT1
+                       timescale
+ \param[in] eqEq_rad   Equation of the equinoxes (radian), as for
+                       sky1_appToTirs(). This changes by less than 0.003
+                       arcseconds per hour, so one value will do for the whole
+                       batch.
+
+ \param[out] appV      Array of \a count position vectors of apparent place.
+                       May be the same array as \a terInterV.
+
+    The sidereal time is calculated in full for the first time only. For the
+    others, it is advanced from there at a constant sidereal rate. This differs
+    from the full calculation by less than 5e-10 radian (0.0001 arcseconds)
+    for each day between the time and the first time.
+
+ \par When to call this function
+    After calling sky_siteTopoToTirsBatch(), to find the apparent right
+    ascension and declination of a stream of logged directions.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double      gast0_rad;  // Greenwich Apparent Sidereal Time at j2kUT1_d[0]
+    V3D_Matrix  earthRotM;  // rotation matrix for current GAST
+    V3D_Vector  tirsV;
+    int         i;
+
+    REQUIRE(count >= 0);
+    REQUIRE_NOT_NULL(terInterV);
+    REQUIRE_NOT_NULL(j2kUT1_d);
+    REQUIRE_NOT_NULL(appV);
+
+    if (count == 0) {
+        return;
+    }
+    gast0_rad = sky1_gmSiderealTimeIAU1982(j2kUT1_d[0]) + eqEq_rad;
+
+    for (i = 0; i < count; i++) {
+        v3d_createRotationMatrix(&earthRotM,
+                                 Zaxis,
+                                 gast0_rad + SIDEREAL_RATE_RADPD
+                                             * (j2kUT1_d[i] - j2kUT1_d[0]));
+        tirsV = terInterV[i];
+        v3d_multMtransxV(&appV[i], &earthRotM, &tirsV);
+    }
+}
+
+
 /*
  *------------------------------------------------------------------------------
  *
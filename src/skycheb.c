@@ -0,0 +1,707 @@
+/*==============================================================================
+ * skycheb.c - fit Chebyshev polynomials to a celestial object's apparent
+ *             coordinates, for fast random-access lookup over long time spans
+ *
+ * Author:  David Hoadley
+ *
+ * Description: (see skycheb.h)
+ *
+ * Copyright (c) 2020, David Hoadley <vcrumble@westnet.com.au>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ *==============================================================================
+ */
+/*------------------------------------------------------------------------------
+ * Notes:
+ *      Character set: UTF-8. (Non-ASCII characters appear in this file)
+ *----------------------------------------------------------------------------*/
+
+/* ANSI includes etc. */
+#include <math.h>
+
+/* Local and project includes */
+#include "skycheb.h"
+
+#include "astron.h"
+#include "general.h"
+#include "sky0.h"
+#include "vectors3d.h"
+
+/*
+ * Local #defines and typedefs
+ */
+DEFINE_THIS_FILE;                       // For use by REQUIRE() - assertions.
+
+/*      Multiplier applied to the size of the last two Chebyshev coefficients
+        of a segment, when adding an allowance for the error between the check
+        points to the largest error found at them (see \ref page-chebyshev) */
+#define TAIL_FACTOR     2.0
+
+/*
+ * Prototypes for local functions (not called from other modules)
+ */
+LOCAL int segmentsInSpan(double startTT_cy, double endTT_cy, double segment_d);
+LOCAL void fitSegments(double startTT_cy,
+                       double endTT_cy,
+                       double segment_d,
+                       int    coeffCount,
+                       void (*getApparent)(double j2kTT_cy,
+                                           Sky_TrueEquatorial *pos),
+                       SkyCheb_Ephemeris *eph,
+                       double coeffBuffer[]);
+LOCAL void sampleComponents(void (*getApparent)(double j2kTT_cy,
+                                                Sky_TrueEquatorial *pos),
+                            double t_cy,
+                            double comp[]);
+LOCAL void evaluateComponents(const SkyCheb_Ephemeris *eph,
+                              const double segCoeffs[],
+                              double x,
+                              double comp[]);
+LOCAL double componentError_rad(int          componentCount,
+                                const double fitted[],
+                                const double actual[]);
+LOCAL double tailError_rad(int          componentCount,
+                           const double segCoeffs[],
+                           int          coeffCount);
+LOCAL double clenshaw(const double c[], int count, double x);
+
+
+/*
+ * Global variables accessible by other modules
+ */
+
+
+/*
+ * Local variables (not accessed by other modules)
+ */
+
+
+/*
+ *==============================================================================
+ *
+ * Implementation
+ *
+ *==============================================================================
+ *
+ * Global functions callable by other modules
+ *
+ *------------------------------------------------------------------------------
+ */
+GLOBAL int skycheb_coeffsRequired(double startTT_cy,
+                                  double endTT_cy,
+                                  double segment_d,
+                                  int    coeffCount)
+/*! Calculate the size of the coefficient array that must be supplied to
+    function skycheb_fitApparent() (or skycheb_fitNutation()) for the span,
+    segment length and number of coefficients specified.
+ \returns                Number of elements (of type double) required
+ \param[in]  startTT_cy  Start of the span of time to be covered: Julian
+                         centuries since J2000.0, TT timescale
+ \param[in]  endTT_cy    End of the span of time to be covered (same timescale)
+ \param[in]  segment_d   Length of each segment (days)
+ \param[in]  coeffCount  Number of Chebyshev coefficients for each coordinate
+                         in each segment (i.e. polynomial degree + 1)
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    return segmentsInSpan(startTT_cy, endTT_cy, segment_d)
+           * SKYCHEB_APPARENT_COMPONENTS * coeffCount;
+}
+
+
+
+GLOBAL void skycheb_fitApparent(double startTT_cy,
+                                double endTT_cy,
+                                double segment_d,
+                                int    coeffCount,
+                                void (*getApparent)(double j2kTT_cy,
+                                                    Sky_TrueEquatorial *pos),
+                                int    bufferSize,
+                                double coeffBuffer[],
+                                SkyCheb_Ephemeris *eph)
+/*! Fit Chebyshev polynomials to the position of a celestial object over a span
+    of time, and check the accuracy of the fit. The resulting ephemeris can
+    then be used by function skycheb_getApprox() to obtain the position at any
+    time within the span.
+ \param[in]  startTT_cy   Start of the span of time to be covered: Julian
+                          centuries since J2000.0, TT timescale
+ \param[in]  endTT_cy     End of the span of time to be covered (same
+                          timescale). The span actually covered is rounded up
+                          to a whole number of segments.
+ \param[in]  segment_d    Length of each segment (days)
+ \param[in]  coeffCount   Number of Chebyshev coefficients for each coordinate
+                          in each segment (i.e. polynomial degree + 1). Must be
+                          in the range 2 to #SKYCHEB_MAX_COEFFS.
+ \param      getApparent  Function to get the position of a celestial object in
+                          apparent coordinates (e.g. sun_nrelApparent()), as
+                          for function skyfast_init()
+ \param[in]  bufferSize   Number of elements in array \a coeffBuffer. This
+                          must be at least the value returned by
+                          skycheb_coeffsRequired() for the same span, segment
+                          length and number of coefficients.
+ \param[out] coeffBuffer  Array to hold the Chebyshev coefficients
+ \param[out] eph          Description of the ephemeris, to be passed to
+                          skycheb_getApprox(). Its field \a maxError_as is set
+                          to a bound on the position error, as described
+                          below.
+
+    Within each segment, the function \a getApparent is called at the
+    \a coeffCount Chebyshev-Gauss-Lobatto points (the extrema of the Chebyshev
+    polynomial of degree \a coeffCount - 1). The ends of each segment are
+    amongst those points, so the fitted polynomials of adjacent segments agree
+    exactly at the boundary between them, and each boundary position is only
+    calculated once.
+
+    The polynomials pass exactly through the positions at those points. To
+    check the fit, \a getApparent is called again midway (in the Chebyshev
+    sense) between each pair of adjacent points, which is where the
+    interpolation error is largest, and the result is compared with the value
+    of the polynomials there. So the total number of calls to \a getApparent is
+    about 2 × (\a coeffCount - 1) per segment.
+
+    The error (in the direction of the object plus the error in the equation of
+    the equinoxes) can be a little larger at other times than at the check
+    points. So for each segment, the largest error found at the check points is
+    increased by twice the size of the segment's last two coefficients (which
+    measure how much of the motion the polynomials have not captured), and the
+    largest of these sums over all segments is returned in
+    \a eph->maxError_as. See \ref page-chebyshev for how this compares with
+    the actual errors.
+
+ \par When to call this function
+    At program initialisation time, or offline (the coefficients can be saved
+    and reloaded later). See \ref page-chebyshev for suitable values of
+    \a segment_d and \a coeffCount.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    REQUIRE_NOT_NULL(getApparent);
+    REQUIRE_NOT_NULL(coeffBuffer);
+    REQUIRE_NOT_NULL(eph);
+    REQUIRE((coeffCount >= 2) && (coeffCount <= SKYCHEB_MAX_COEFFS));
+    REQUIRE(bufferSize >= skycheb_coeffsRequired(startTT_cy, endTT_cy,
+                                                 segment_d, coeffCount));
+
+    eph->componentCount = SKYCHEB_APPARENT_COMPONENTS;
+    fitSegments(startTT_cy, endTT_cy, segment_d, coeffCount, getApparent,
+                eph, coeffBuffer);
+}
+
+
+
+GLOBAL void skycheb_fitNutation(double startTT_cy,
+                                double endTT_cy,
+                                double segment_d,
+                                int    coeffCount,
+                                int    bufferSize,
+                                double coeffBuffer[],
+                                SkyCheb_Ephemeris *eph)
+/*! Fit Chebyshev polynomials to the nutation angles, obliquity of the ecliptic
+    and equation of the equinoxes, as calculated by sky0_nutationSpa() and
+    sky0_epsilonSpa(), over a span of time. The resulting ephemeris can then be
+    used by function skycheb_getNutation().
+ \param[in]  startTT_cy   Start of the span of time to be covered: Julian
+                          centuries since J2000.0, TT timescale
+ \param[in]  endTT_cy     End of the span of time to be covered (same
+                          timescale)
+ \param[in]  segment_d    Length of each segment (days)
+ \param[in]  coeffCount   Number of Chebyshev coefficients for each quantity
+                          in each segment. Must be in the range 2 to
+                          #SKYCHEB_MAX_COEFFS.
+ \param[in]  bufferSize   Number of elements in array \a coeffBuffer. The value
+                          returned by skycheb_coeffsRequired() is sufficient.
+ \param[out] coeffBuffer  Array to hold the Chebyshev coefficients
+ \param[out] eph          Description of the ephemeris, to be passed to
+                          skycheb_getNutation(). Its field \a maxError_as is set
+                          to a bound on the error in any of the quantities.
+
+    The fitting and checking process, and the calculation of the error bound,
+    are the same as for skycheb_fitApparent().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    REQUIRE_NOT_NULL(coeffBuffer);
+    REQUIRE_NOT_NULL(eph);
+    REQUIRE((coeffCount >= 2) && (coeffCount <= SKYCHEB_MAX_COEFFS));
+    REQUIRE(bufferSize >= segmentsInSpan(startTT_cy, endTT_cy, segment_d)
+                          * SKYCHEB_NUTATION_COMPONENTS * coeffCount);
+
+    eph->componentCount = SKYCHEB_NUTATION_COMPONENTS;
+    fitSegments(startTT_cy, endTT_cy, segment_d, coeffCount, NULL,
+                eph, coeffBuffer);
+}
+
+
+
+GLOBAL void skycheb_getApprox(const SkyCheb_Ephemeris *eph,
+                              double t_cy,
+                              Sky_TrueEquatorial *approx)
+/*! Get the celestial object's apparent coordinates and distance, and the
+    equation of the equinoxes, at any time within the span of an ephemeris
+    previously set up by skycheb_fitApparent().
+ \param[in]  eph      The ephemeris, as set up by skycheb_fitApparent()
+ \param[in]  t_cy     Julian centuries since J2000.0, TT timescale. This must be
+                      within the span of time covered by \a eph.
+ \param[out] approx   position vector, distance, etc, obtained by evaluating
+                      the Chebyshev polynomials. The position vector is
+                      normalised to unit magnitude.
+
+    The times passed to successive calls of this function may be in any order.
+    The \a eph structure is not modified, so several threads may call this
+    function at once using the same ephemeris.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  comp[SKYCHEB_APPARENT_COMPONENTS];
+    double  offset;         // time since start of span (segments)
+    double  mag;
+    int     seg;            // segment number
+
+    REQUIRE_NOT_NULL(eph);
+    REQUIRE_NOT_NULL(approx);
+    REQUIRE(eph->componentCount == SKYCHEB_APPARENT_COMPONENTS);
+
+    offset = (t_cy - eph->start_cy) / eph->segment_cy;
+    /* It is a programming error if time t_cy is outside the span */
+    REQUIRE(offset >= 0.0);
+    REQUIRE(offset <= (double)eph->segmentCount);
+
+    seg = (int)offset;
+    if (seg >= eph->segmentCount) {
+        seg = eph->segmentCount - 1;        // t_cy is at the very end of span
+    }
+    evaluateComponents(eph,
+                       eph->coeffs
+                           + seg * SKYCHEB_APPARENT_COMPONENTS * eph->coeffCount,
+                       2.0 * (offset - seg) - 1.0,
+                       comp);
+
+    /* The fitted vector is not exactly of unit magnitude. Make it so. */
+    mag = sqrt(comp[0] * comp[0] + comp[1] * comp[1] + comp[2] * comp[2]);
+    approx->appCirsV.a[0] = comp[0] / mag;
+    approx->appCirsV.a[1] = comp[1] / mag;
+    approx->appCirsV.a[2] = comp[2] / mag;
+    approx->distance_au = comp[3];
+    approx->eqEq_rad = comp[4];
+    approx->timestamp_cy = t_cy;
+}
+
+
+
+GLOBAL void skycheb_getNutation(const SkyCheb_Ephemeris *eph,
+                                double t_cy,
+                                Sky0_Nut1980 *nut)
+/*! Get the nutation angles, obliquity of the ecliptic and equation of the
+    equinoxes at any time within the span of an ephemeris previously set up by
+    skycheb_fitNutation().
+ \param[in]  eph      The ephemeris, as set up by skycheb_fitNutation()
+ \param[in]  t_cy     Julian centuries since J2000.0, TT timescale. This must be
+                      within the span of time covered by \a eph.
+ \param[out] nut      Nutation angles, obliquity and equation of the equinoxes,
+                      as would be returned by calling sky0_nutationSpa() and
+                      then sky0_epsilonSpa()
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  comp[SKYCHEB_NUTATION_COMPONENTS];
+    double  offset;         // time since start of span (segments)
+    int     seg;            // segment number
+
+    REQUIRE_NOT_NULL(eph);
+    REQUIRE_NOT_NULL(nut);
+    REQUIRE(eph->componentCount == SKYCHEB_NUTATION_COMPONENTS);
+
+    offset = (t_cy - eph->start_cy) / eph->segment_cy;
+    REQUIRE(offset >= 0.0);
+    REQUIRE(offset <= (double)eph->segmentCount);
+
+    seg = (int)offset;
+    if (seg >= eph->segmentCount) {
+        seg = eph->segmentCount - 1;
+    }
+    evaluateComponents(eph,
+                       eph->coeffs
+                           + seg * SKYCHEB_NUTATION_COMPONENTS * eph->coeffCount,
+                       2.0 * (offset - seg) - 1.0,
+                       comp);
+    nut->dPsi_rad = comp[0];
+    nut->dEps_rad = comp[1];
+    nut->eps0_rad = comp[2];
+    nut->eqEq_rad = comp[3];
+}
+
+
+/*
+ *------------------------------------------------------------------------------
+ *
+ * Local functions (not called from other modules)
+ *
+ *------------------------------------------------------------------------------
+ */
+LOCAL int segmentsInSpan(double startTT_cy, double endTT_cy, double segment_d)
+/* Calculate the number of segments required to cover a span of time.
+ Returns - number of segments (rounded up)
+ Inputs
+    startTT_cy - start of span (J2000 centuries, TT)
+    endTT_cy   - end of span (J2000 centuries, TT)
+    segment_d  - length of each segment (days)
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  segments;
+
+    REQUIRE(endTT_cy > startTT_cy);
+    REQUIRE(segment_d > 0.0);
+
+    segments = ceil((endTT_cy - startTT_cy) * JUL_CENT / segment_d);
+    return (int)segments;
+}
+
+
+
+LOCAL void fitSegments(double startTT_cy,
+                       double endTT_cy,
+                       double segment_d,
+                       int    coeffCount,
+                       void (*getApparent)(double j2kTT_cy,
+                                           Sky_TrueEquatorial *pos),
+                       SkyCheb_Ephemeris *eph,
+                       double coeffBuffer[])
+/* Fit Chebyshev polynomials over every segment of the span, and check the
+   fit, as described for skycheb_fitApparent().
+ Inputs
+    startTT_cy, endTT_cy, segment_d, coeffCount
+                - as for skycheb_fitApparent()
+    getApparent - function to calculate the object's position, or NULL to fit
+                  the nutation quantities instead
+ Outputs
+    coeffBuffer - the coefficients
+ In/Out
+    eph         - field componentCount must be set on entry. The remaining
+                  fields are set by this routine.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    /* Values of each component at the nodes of the current segment */
+    double  values[SKYCHEB_MAX_COEFFS][SKYCHEB_APPARENT_COMPONENTS];
+    double  check[SKYCHEB_APPARENT_COMPONENTS];  // full calc at check point
+    double  fitted[SKYCHEB_APPARENT_COMPONENTS]; // fitted value at check point
+    double  *segCoeffs;             // coefficients for current segment
+    double  segStart_cy;            // start time of current segment
+    double  x;                      // position within segment (-1 to +1)
+    double  sum;
+    double  err_as;
+    double  segError_rad;           // largest error at current segment's checks
+    int     n;                      // degree of polynomials
+    int     seg, comp, j, k;
+
+    eph->start_cy = startTT_cy;
+    eph->segment_cy = segment_d / JUL_CENT;
+    eph->segmentCount = segmentsInSpan(startTT_cy, endTT_cy, segment_d);
+    eph->coeffCount = coeffCount;
+    eph->maxError_as = 0.0;
+    eph->coeffs = coeffBuffer;
+
+    n = coeffCount - 1;
+    /* Node k is at x = cos(πk/n). So node 0 is at the end of the segment and
+       node n is at the start. Calculate the start of the first segment. */
+    sampleComponents(getApparent, startTT_cy, values[n]);
+
+    for (seg = 0; seg < eph->segmentCount; seg++) {
+        segStart_cy = startTT_cy + seg * eph->segment_cy;
+
+        /* The end of the previous segment is the start of this one */
+        if (seg > 0) {
+            for (comp = 0; comp < eph->componentCount; comp++) {
+                values[n][comp] = values[0][comp];
+            }
+        }
+        for (k = 0; k < n; k++) {
+            x = cos(PI * k / n);
+            sampleComponents(getApparent,
+                             segStart_cy + 0.5 * (x + 1.0) * eph->segment_cy,
+                             values[k]);
+        }
+
+        /* Calculate the coefficients by the discrete cosine transform
+                c[j] = (2/n) Σ'' f[k] cos(πjk/n)
+           where the double prime means that the first and last terms of the
+           sum are halved. The first and last coefficients are also halved, so
+           that the polynomial is simply Σ c[j] T[j](x) */
+        segCoeffs = coeffBuffer + seg * eph->componentCount * coeffCount;
+        for (comp = 0; comp < eph->componentCount; comp++) {
+            for (j = 0; j <= n; j++) {
+                sum = 0.5 * (values[0][comp]
+                             + values[n][comp] * ((j % 2 == 0) ? 1.0 : -1.0));
+                for (k = 1; k < n; k++) {
+                    sum += values[k][comp] * cos(PI * j * k / n);
+                }
+                sum *= 2.0 / n;
+                if ((j == 0) || (j == n)) {
+                    sum *= 0.5;
+                }
+                segCoeffs[comp * coeffCount + j] = sum;
+            }
+        }
+
+        /* Check the fit between each pair of adjacent nodes */
+        segError_rad = 0.0;
+        for (k = 0; k < n; k++) {
+            x = cos(PI * (k + 0.5) / n);
+            sampleComponents(getApparent,
+                             segStart_cy + 0.5 * (x + 1.0) * eph->segment_cy,
+                             check);
+            evaluateComponents(eph, segCoeffs, x, fitted);
+            sum = componentError_rad(eph->componentCount, fitted, check);
+            if (sum > segError_rad) {
+                segError_rad = sum;
+            }
+        }
+
+        /* Allow for the error between the check points */
+        err_as = radToArcsec(segError_rad
+                             + TAIL_FACTOR * tailError_rad(eph->componentCount,
+                                                           segCoeffs,
+                                                           coeffCount));
+        if (err_as > eph->maxError_as) {
+            eph->maxError_as = err_as;
+        }
+    }
+}
+
+
+
+LOCAL void sampleComponents(void (*getApparent)(double j2kTT_cy,
+                                                Sky_TrueEquatorial *pos),
+                            double t_cy,
+                            double comp[])
+/* Calculate the quantities to be fitted, at a single time.
+ Inputs
+    getApparent - function to calculate the object's position, or NULL to
+                  calculate the nutation quantities instead
+    t_cy        - Julian centuries since J2000.0, TT timescale
+ Outputs
+    comp        - the three components of the apparent position vector, the
+                  distance and the equation of the equinoxes. Or if getApparent
+                  is NULL, the nutation in longitude and obliquity, the mean
+                  obliquity and the equation of the equinoxes.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    Sky_TrueEquatorial  pos;
+    Sky0_Nut1980        nut;
+
+    if (getApparent != NULL) {
+        getApparent(t_cy, &pos);
+        comp[0] = pos.appCirsV.a[0];
+        comp[1] = pos.appCirsV.a[1];
+        comp[2] = pos.appCirsV.a[2];
+        comp[3] = pos.distance_au;
+        comp[4] = pos.eqEq_rad;
+    } else {
+        sky0_nutationSpa(t_cy, &nut);
+        sky0_epsilonSpa(t_cy, &nut);
+        comp[0] = nut.dPsi_rad;
+        comp[1] = nut.dEps_rad;
+        comp[2] = nut.eps0_rad;
+        comp[3] = nut.eqEq_rad;
+    }
+}
+
+
+
+LOCAL void evaluateComponents(const SkyCheb_Ephemeris *eph,
+                              const double segCoeffs[],
+                              double x,
+                              double comp[])
+/* Evaluate the fitted polynomials of every component for one segment.
+ Inputs
+    eph       - the ephemeris (for the number of components and coefficients)
+    segCoeffs - coefficients of all components for this segment
+    x         - position within segment (-1.0 = start, +1.0 = end)
+ Outputs
+    comp      - value of each component
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    int     i;
+
+    for (i = 0; i < eph->componentCount; i++) {
+        comp[i] = clenshaw(&segCoeffs[i * eph->coeffCount], eph->coeffCount, x);
+    }
+}
+
+
+
+LOCAL double componentError_rad(int          componentCount,
+                                const double fitted[],
+                                const double actual[])
+/* Measure the error of a fitted set of components.
+ Returns - for an apparent position: the angle between the fitted and actual
+           directions (after normalising the fitted vector) plus the error in
+           the equation of the equinoxes (radian). For nutation: the largest
+           error in any of the four angles (radian).
+ Inputs
+    componentCount - SKYCHEB_APPARENT_COMPONENTS or SKYCHEB_NUTATION_COMPONENTS
+    fitted         - values from the fitted polynomials
+    actual         - values from the full calculation
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    V3D_Vector  diffV;
+    double      mag;
+    double      err_rad;
+    int         i;
+
+    if (componentCount == SKYCHEB_APPARENT_COMPONENTS) {
+        mag = sqrt(fitted[0] * fitted[0] + fitted[1] * fitted[1]
+                   + fitted[2] * fitted[2]);
+        for (i = 0; i < 3; i++) {
+            diffV.a[i] = fitted[i] / mag - actual[i];
+        }
+        err_rad = v3d_magV(&diffV) + fabs(fitted[4] - actual[4]);
+    } else {
+        err_rad = 0.0;
+        for (i = 0; i < componentCount; i++) {
+            if (fabs(fitted[i] - actual[i]) > err_rad) {
+                err_rad = fabs(fitted[i] - actual[i]);
+            }
+        }
+    }
+    return err_rad;
+}
+
+
+
+LOCAL double tailError_rad(int          componentCount,
+                           const double segCoeffs[],
+                           int          coeffCount)
+/* Measure the size of the last two Chebyshev coefficients of each component of
+   a segment. (Two, because a component that is nearly an even or an odd
+   function over the segment has every second coefficient close to zero.)
+ Returns - for an apparent position: the magnitude of the vector of these sizes
+           for the three components of the position vector, plus the size for
+           the equation of the equinoxes (radian). For nutation: the largest
+           size for any of the four angles (radian).
+ Inputs
+    componentCount - SKYCHEB_APPARENT_COMPONENTS or SKYCHEB_NUTATION_COMPONENTS
+    segCoeffs      - coefficients of all components for this segment
+    coeffCount     - number of coefficients per component
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double      tail[SKYCHEB_APPARENT_COMPONENTS];
+    const double *c;
+    double      err_rad;
+    int         i;
+
+    for (i = 0; i < componentCount; i++) {
+        c = &segCoeffs[i * coeffCount];
+        tail[i] = fabs(c[coeffCount - 1]);
+        if (coeffCount > 2) {
+            tail[i] += fabs(c[coeffCount - 2]);
+        }
+    }
+
+    if (componentCount == SKYCHEB_APPARENT_COMPONENTS) {
+        err_rad = sqrt(tail[0] * tail[0] + tail[1] * tail[1]
+                       + tail[2] * tail[2]) + tail[4];
+    } else {
+        err_rad = 0.0;
+        for (i = 0; i < componentCount; i++) {
+            if (tail[i] > err_rad) {
+                err_rad = tail[i];
+            }
+        }
+    }
+    return err_rad;
+}
+
+
+
+LOCAL double clenshaw(const double c[], int count, double x)
+/* Evaluate a Chebyshev series using Clenshaw's recurrence.
+ Returns - c[0] T0(x) + c[1] T1(x) + ... + c[count-1] T(count-1)(x)
+ Inputs
+    c     - coefficients
+    count - number of coefficients
+    x     - argument (-1.0 <= x <= +1.0)
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  b1, b2;
+    double  temp;
+    double  twoX;
+    int     j;
+
+    b1 = 0.0;
+    b2 = 0.0;
+    twoX = x + x;
+    for (j = count - 1; j >= 1; j--) {
+        temp = b1;
+        b1 = twoX * b1 - b2 + c[j];
+        b2 = temp;
+    }
+    return x * b1 - b2 + c[0];
+}
+
+/*- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+/*! \page page-chebyshev Chebyshev ephemerides and their errors
+ *  Function skycheb_fitApparent() fits Chebyshev polynomials to the apparent
+ *  position of a celestial object, and function skycheb_getApprox() evaluates
+ *  them. The error introduced by this process depends on the segment length
+ *  and the number of coefficients per segment. Here are the errors for the
+ *  Sun (using sun_nrelApparent()) and the Moon (using moon_nrelApparent()),
+ *  compared with a full calculation at 200 000 random times over the ten
+ *  years 2020 to 2030. The storage is the size of the coefficient array
+ *  needed to cover those ten years.
+ *
+ *  ###Maximum position error (arcseconds) for different segment lengths and numbers of coefficients
+
+    Object |Segment (days) |Coefficients |Max error  |Bound   |Storage (kB)
+    :------|--------------:|------------:|----------:|-------:|-----------:
+    Sun    |4              |10           |1e-7       |2e-6    |357
+    Sun    |8              |10           |1e-5       |3e-4    |178
+    Sun    |8              |12           |3e-7       |1e-5    |214
+    Sun    |16             |12           |5e-4       |0.004   |107
+    Sun    |16             |16           |4e-6       |5e-5    |143
+    Sun    |32             |16           |0.011      |0.029   |71
+    Sun    |32             |20           |0.0009     |0.003   |89
+    -      |               |             |           |        |
+    Moon   |1              |12           |3e-7       |4e-7    |1712
+    Moon   |2              |16           |3e-7       |4e-7    |1141
+    Moon   |4              |20           |3e-7       |3e-7    |714
+
+ *  The bound is the value reported in the \a maxError_as field of the
+ *  SkyCheb_Ephemeris structure. For each segment, it is the largest error found
+ *  at the check points during the fit, plus an allowance for the error between
+ *  them of twice the size of the segment's last two coefficients. (At the
+ *  random times, the error never exceeded the error at the check points by
+ *  more than about half that size.) So the bound is never smaller than the
+ *  actual error, but where the fit is good to much better than the
+ *  coefficients suggest, it can be up to thirty times larger.
+ *
+ *  All of these errors are far smaller than the errors of the underlying
+ *  Sun and Moon algorithms themselves (about 1 arcsecond and 5 arcseconds
+ *  respectively), so a segment length of 8 days with 12 coefficients for the
+ *  Sun is a reasonable default.
+ *
+ *  Function skycheb_fitNutation() does the same for the nutation angles,
+ *  obliquity and equation of the equinoxes. Over the same ten years, 8-day
+ *  segments with 12 coefficients give a largest error of 2e-7 arcseconds
+ *  (bound 6e-6; 171 kB), and 16-day segments with 16 coefficients give 2e-6
+ *  arcseconds (bound 3e-5; 114 kB).
+ *
+ *  Each call to skycheb_getApprox() takes about 0.1 microseconds on a modern
+ *  desktop processor.
+ */
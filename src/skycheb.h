@@ -0,0 +1,128 @@
+#ifndef SKYCHEB_H
+#define SKYCHEB_H
+/*============================================================================*/
+/*! \file
+ * \brief
+ * skycheb.h - fit Chebyshev polynomials to a celestial object's apparent
+ *             coordinates, for fast random-access lookup over long time spans
+ *
+ * \author  David Hoadley
+ *
+ * \details
+ *          Routines to precalculate a compact ephemeris of a celestial object
+ *          (typically the Sun) over a span of time that may be many years
+ *          long, and to obtain the object's apparent coordinates at any time
+ *          within that span from that ephemeris. The span is divided into
+ *          equal segments, and within each segment, each coordinate is
+ *          represented by a Chebyshev polynomial. Finding a position requires
+ *          only the calculation of a segment number and the evaluation of five
+ *          short polynomials, so it takes much less than a microsecond.
+ *
+ *          Unlike the skyfast module, the times requested need not move
+ *          forward; any time within the span can be requested in any order.
+ *          See \ref page-chebyshev (at the end of skycheb.c) for the errors
+ *          introduced by this process.
+ *
+ *==============================================================================
+ */
+/*
+ * Copyright (c) 2020, David Hoadley <vcrumble@westnet.com.au>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "sky.h"
+#include "sky0.h"
+
+/*
+ * Global #defines and typedefs
+ */
+/*      Largest number of Chebyshev coefficients per coordinate supported */
+#define SKYCHEB_MAX_COEFFS 20
+
+/*      Number of coordinates fitted per segment for a Sky_TrueEquatorial
+        position: the three components of appCirsV, distance_au and eqEq_rad */
+#define SKYCHEB_APPARENT_COMPONENTS 5
+
+/*      Number of quantities fitted per segment for nutation: the four fields
+        of struct Sky0_Nut1980 */
+#define SKYCHEB_NUTATION_COMPONENTS 4
+
+/*! A piecewise Chebyshev ephemeris, as set up by skycheb_fitApparent() or
+    skycheb_fitNutation(), or as read from a file by skyeph_getEphemeris(). The
+    coefficients themselves are stored in an array supplied by the caller; this
+    structure just describes them. */
+typedef struct {
+    double       start_cy;      //!< Start of span covered (J2000 cy, TT)
+    double       segment_cy;    //!< Length of each segment (centuries)
+    int          segmentCount;  //!< Number of segments in span
+    int          coeffCount;    //!< Number of coefficients per component
+    int          componentCount;//!< Number of components in each segment
+    double       maxError_as;   /*!< Bound on the position error, from the
+                                     check of the fit (arcseconds) */
+    const double *coeffs;       /*!< Coefficients, ordered by segment, then by
+                                     component, then by degree */
+} SkyCheb_Ephemeris;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Global functions available to be called by other modules
+ */
+int skycheb_coeffsRequired(double startTT_cy,
+                           double endTT_cy,
+                           double segment_d,
+                           int    coeffCount);
+void skycheb_fitApparent(double startTT_cy,
+                         double endTT_cy,
+                         double segment_d,
+                         int    coeffCount,
+                         void (*getApparent)(double j2kTT_cy,
+                                             Sky_TrueEquatorial *pos),
+                         int    bufferSize,
+                         double coeffBuffer[],
+                         SkyCheb_Ephemeris *eph);
+void skycheb_fitNutation(double startTT_cy,
+                         double endTT_cy,
+                         double segment_d,
+                         int    coeffCount,
+                         int    bufferSize,
+                         double coeffBuffer[],
+                         SkyCheb_Ephemeris *eph);
+void skycheb_getApprox(const SkyCheb_Ephemeris *eph,
+                       double t_cy,
+                       Sky_TrueEquatorial *approx);
+void skycheb_getNutation(const SkyCheb_Ephemeris *eph,
+                         double t_cy,
+                         Sky0_Nut1980 *nut);
+
+/*
+ * Global variables accessible by other modules
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SKYCHEB_H */
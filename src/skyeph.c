@@ -0,0 +1,638 @@
+/*==============================================================================
+ * skyeph.c - read and write files of precalculated Chebyshev ephemerides, and
+ *            use them in place of the full position calculations
+ *
+ * Author:  David Hoadley
+ *
+ * Description: (see skyeph.h)
+ *
+ * Copyright (c) 2020, David Hoadley <vcrumble@westnet.com.au>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ *==============================================================================
+ */
+/*------------------------------------------------------------------------------
+ * Notes:
+ *      Character set: UTF-8. (Non-ASCII characters appear in this file)
+ *----------------------------------------------------------------------------*/
+
+/* ANSI includes etc. */
+#include <stdio.h>
+#include <string.h>
+#ifdef POSIX_SYSTEM
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+/* Local and project includes */
+#include "skyeph.h"
+
+#include "general.h"
+#include "moon.h"
+#include "planet.h"
+#include "sky0.h"
+#include "skycheb.h"
+#include "sun.h"
+
+/*
+ * Local #defines and typedefs
+ */
+DEFINE_THIS_FILE;                       // For use by REQUIRE() - assertions.
+
+/* The layout of the file depends on these sizes, so make sure the compiler has
+   not padded the structures */
+static_assert(sizeof(SkyEph_FileHeader) == 24, "SkyEph_FileHeader is padded");
+static_assert(sizeof(SkyEph_BlockEntry) == 48, "SkyEph_BlockEntry is padded");
+
+
+/*
+ * Prototypes for local functions (not called from other modules)
+ */
+LOCAL int checkBlock(const SkyEph_File *file, const SkyEph_BlockEntry *entry);
+LOCAL size_t blockSize(int32_t segmentCount,
+                       int32_t componentCount,
+                       int32_t coeffCount);
+LOCAL bool useEphemeris(int objectId, double t_cy);
+
+
+/*
+ * Global variables accessible by other modules
+ */
+
+
+/*
+ * Local variables (not accessed by other modules)
+ */
+/* Ephemerides found in the file passed to skyeph_select(), indexed by object
+   identifier. A segmentCount of zero means that the object was not found. */
+LOCAL SkyCheb_Ephemeris selectedEph[SKYEPH_OBJECT_COUNT];
+/* Object selected by skyeph_setCurrentObject() */
+LOCAL int currentObject = SKYEPH_SUN;
+
+
+/*
+ *==============================================================================
+ *
+ * Implementation
+ *
+ *==============================================================================
+ *
+ * Global functions callable by other modules
+ *
+ *------------------------------------------------------------------------------
+ */
+GLOBAL int skyeph_write(const char              path[],
+                        int                     count,
+                        const int               objectIds[],
+                        const SkyCheb_Ephemeris eph[])
+/*! Write a set of Chebyshev ephemerides to an ephemeris file, in the layout
+    described in \ref page-ephemeris-file.
+ \returns   SKYEPH_NORMAL if successful, otherwise SKYEPH_OPENFAIL or
+            SKYEPH_WRITEFAIL
+ \param[in] path       Name of the file to be written. Any existing file of
+                       this name will be replaced.
+ \param[in] count      Number of ephemerides to be written
+ \param[in] objectIds  Object identifier for each ephemeris (one of the values
+                       of SkyEph_Object)
+ \param[in] eph        The ephemerides, as set up by skycheb_fitApparent()
+                       or (for object SKYEPH_NUTATION) by skycheb_fitNutation()
+
+ \par When to call this function
+    Offline, in a program that prepares the file for later use by your
+    application.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    SkyEph_FileHeader   header;
+    SkyEph_BlockEntry   entry;
+    FILE                *fp;
+    size_t              offset;
+    size_t              n;
+    bool                ok;
+    int                 i;
+
+    REQUIRE_NOT_NULL(path);
+    REQUIRE_NOT_NULL(objectIds);
+    REQUIRE_NOT_NULL(eph);
+    REQUIRE(count > 0);
+
+    fp = fopen(path, "wb");
+    if (fp == NULL) {
+        return SKYEPH_OPENFAIL;
+    }
+
+    memcpy(header.magic, SKYEPH_MAGIC, sizeof(header.magic));
+    header.endianTag = SKYEPH_ENDIAN_TAG;
+    header.version = SKYEPH_VERSION;
+    header.blockCount = (uint32_t)count;
+    header.headerSize = (uint32_t)(sizeof(header)
+                                   + (size_t)count * sizeof(entry));
+    ok = (fwrite(&header, sizeof(header), 1, fp) == 1);
+
+    /* Directory. The coefficient blocks follow it, in the same order. */
+    offset = header.headerSize;
+    for (i = 0; ok && (i < count); i++) {
+        REQUIRE((objectIds[i] >= 0) && (objectIds[i] < SKYEPH_OBJECT_COUNT));
+        REQUIRE(eph[i].componentCount
+                == ((objectIds[i] == SKYEPH_NUTATION)
+                    ? SKYCHEB_NUTATION_COMPONENTS
+                    : SKYCHEB_APPARENT_COMPONENTS));
+
+        entry.objectId = objectIds[i];
+        entry.componentCount = eph[i].componentCount;
+        entry.coeffCount = eph[i].coeffCount;
+        entry.segmentCount = eph[i].segmentCount;
+        entry.start_cy = eph[i].start_cy;
+        entry.segment_cy = eph[i].segment_cy;
+        entry.maxError_as = eph[i].maxError_as;
+        entry.offset = (uint32_t)offset;
+        entry.reserved = 0;
+        ok = (fwrite(&entry, sizeof(entry), 1, fp) == 1);
+        offset += blockSize(entry.segmentCount, entry.componentCount,
+                            entry.coeffCount);
+    }
+
+    /* Coefficients */
+    for (i = 0; ok && (i < count); i++) {
+        n = blockSize(eph[i].segmentCount, eph[i].componentCount,
+                      eph[i].coeffCount) / sizeof(double);
+        ok = (fwrite(eph[i].coeffs, sizeof(double), n, fp) == n);
+    }
+
+    if (fclose(fp) != 0) {
+        ok = false;
+    }
+    return ok ? SKYEPH_NORMAL : SKYEPH_WRITEFAIL;
+}
+
+
+
+GLOBAL int skyeph_attach(const void *image, size_t size, SkyEph_File *file)
+/*! Check an ephemeris file image that is already in memory, and set up a
+    description of it for use by the other functions in this module. The image
+    is not copied or modified.
+ \returns   SKYEPH_NORMAL if the image is a valid ephemeris file, otherwise one
+            of the other values of SkyEph_Errors
+ \param[in]  image  Start of the file image. This must be aligned on an 8-byte
+                    boundary, and must remain in place for as long as \a file
+                    (or any ephemeris obtained from it) is in use.
+ \param[in]  size   Size of the file image (bytes)
+ \param[out] file   Description of the file, for use by skyeph_getEphemeris()
+                    and skyeph_select()
+
+ \par When to call this function
+    At program initialisation time, if the file image has been linked into the
+    program or placed in memory by some means other than skyeph_open(). (On a
+    POSIX system, skyeph_open() calls this function for you.)
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    const SkyEph_FileHeader *header;
+    uint32_t                i;
+    int                     status;
+
+    REQUIRE_NOT_NULL(image);
+    REQUIRE_NOT_NULL(file);
+    REQUIRE(((size_t)image % sizeof(double)) == 0);
+
+    file->image = (const unsigned char *)image;
+    file->size = size;
+    file->header = NULL;
+    file->directory = NULL;
+    file->mapped = false;
+
+    if (size < sizeof(SkyEph_FileHeader)) {
+        return SKYEPH_TOOSMALL;
+    }
+    header = (const SkyEph_FileHeader *)image;
+    if (memcmp(header->magic, SKYEPH_MAGIC, sizeof(header->magic)) != 0) {
+        return SKYEPH_BADMAGIC;
+    }
+    if (header->endianTag != SKYEPH_ENDIAN_TAG) {
+        return SKYEPH_WRONGENDIAN;
+    }
+    if (header->version != SKYEPH_VERSION) {
+        return SKYEPH_BADVERSION;
+    }
+    if ((header->headerSize > size)
+        || (header->blockCount
+            > (size - sizeof(SkyEph_FileHeader)) / sizeof(SkyEph_BlockEntry))) {
+        return SKYEPH_TOOSMALL;
+    }
+    if (header->headerSize != sizeof(SkyEph_FileHeader)
+                              + header->blockCount * sizeof(SkyEph_BlockEntry)) {
+        return SKYEPH_BADBLOCK;
+    }
+
+    file->header = header;
+    file->directory = (const SkyEph_BlockEntry *)(header + 1);
+    for (i = 0; i < header->blockCount; i++) {
+        status = checkBlock(file, &file->directory[i]);
+        if (status != SKYEPH_NORMAL) {
+            file->header = NULL;
+            file->directory = NULL;
+            return status;
+        }
+    }
+    return SKYEPH_NORMAL;
+}
+
+
+
+#ifdef POSIX_SYSTEM
+GLOBAL int skyeph_open(const char path[], SkyEph_File *file)
+/*! Map an ephemeris file into memory (read only) and check it. No data is read
+    from the file at this point; the operating system reads pages of the file
+    only as they are used, and shares them between all processes that map the
+    same file.
+ \returns   SKYEPH_NORMAL if successful, SKYEPH_OPENFAIL if the file cannot be
+            opened or mapped, otherwise one of the errors returned by
+            skyeph_attach()
+ \param[in]  path   Name of the ephemeris file
+ \param[out] file   Description of the file, for use by skyeph_getEphemeris()
+                    and skyeph_select()
+ \note
+    The macro POSIX_SYSTEM must be defined at compile time to use this function.
+ \par When to call this function
+    At program initialisation time. Call skyeph_close() when you no longer need
+    the file.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    struct stat st;
+    void        *image;
+    size_t      size;
+    int         fd;
+    int         status;
+
+    REQUIRE_NOT_NULL(path);
+    REQUIRE_NOT_NULL(file);
+
+    file->image = NULL;
+    file->mapped = false;
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return SKYEPH_OPENFAIL;
+    }
+    if ((fstat(fd, &st) != 0) || (st.st_size <= 0)) {
+        (void)close(fd);
+        return SKYEPH_OPENFAIL;
+    }
+    size = (size_t)st.st_size;
+    image = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    (void)close(fd);                // The mapping remains valid
+    if (image == MAP_FAILED) {
+        return SKYEPH_OPENFAIL;
+    }
+
+    status = skyeph_attach(image, size, file);
+    if (status != SKYEPH_NORMAL) {
+        (void)munmap(image, size);
+        file->image = NULL;
+        return status;
+    }
+    file->mapped = true;
+    return SKYEPH_NORMAL;
+}
+
+
+
+GLOBAL void skyeph_close(SkyEph_File *file)
+/*! Unmap an ephemeris file previously opened by skyeph_open().
+ \param[in,out] file  Description of the file. It may not be used again.
+ \note
+    Ephemerides obtained from this file by skyeph_getEphemeris() become invalid,
+    and so does the file selected by skyeph_select() if it was this one.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    REQUIRE_NOT_NULL(file);
+
+    if (file->mapped) {
+        (void)munmap((void *)(size_t)file->image, file->size);
+    }
+    file->image = NULL;
+    file->header = NULL;
+    file->directory = NULL;
+    file->mapped = false;
+}
+#endif
+
+
+
+GLOBAL int skyeph_getEphemeris(const SkyEph_File *file,
+                               int               objectId,
+                               SkyCheb_Ephemeris *eph)
+/*! Find the ephemeris of an object in an ephemeris file. The coefficients are
+    not copied; \a eph points to them where they lie in the file image.
+ \returns   SKYEPH_NORMAL if found, otherwise SKYEPH_NOTFOUND
+ \param[in]  file      The ephemeris file, as set up by skyeph_attach() or
+                       skyeph_open()
+ \param[in]  objectId  Object identifier (one of the values of SkyEph_Object)
+ \param[out] eph       The ephemeris, for use by skycheb_getApprox() or (for
+                       object SKYEPH_NUTATION) skycheb_getNutation()
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    const SkyEph_BlockEntry *entry;
+    uint32_t                i;
+
+    REQUIRE_NOT_NULL(file);
+    REQUIRE_NOT_NULL(file->header);
+    REQUIRE_NOT_NULL(eph);
+
+    for (i = 0; i < file->header->blockCount; i++) {
+        entry = &file->directory[i];
+        if (entry->objectId == objectId) {
+            eph->start_cy = entry->start_cy;
+            eph->segment_cy = entry->segment_cy;
+            eph->segmentCount = entry->segmentCount;
+            eph->coeffCount = entry->coeffCount;
+            eph->componentCount = entry->componentCount;
+            eph->maxError_as = entry->maxError_as;
+            /* The image is 8-byte aligned (checked by skyeph_attach()) and so
+               is the offset, so the cast is safe */
+            eph->coeffs = (const double *)(const void *)
+                                                (file->image + entry->offset);
+            return SKYEPH_NORMAL;
+        }
+    }
+    return SKYEPH_NOTFOUND;
+}
+
+
+
+GLOBAL void skyeph_select(const SkyEph_File *file)
+/*! Select the ephemeris file to be used by functions skyeph_sunApparent(),
+    skyeph_moonApparent(), skyeph_getApparent() and skyeph_getNutation().
+ \param[in]  file   The ephemeris file, as set up by skyeph_attach() or
+                    skyeph_open(). Or NULL, in which case those functions will
+                    use the full calculations at all times.
+
+    The file need not contain all objects, nor cover all times. If one of those
+    functions is called for an object that is not in the file, or for a time
+    outside the span covered, it falls back to the full calculation.
+
+ \par When to call this function
+    At program initialisation time, before calling skyfast_init(). This
+    function is not thread-safe; do not call it while another thread may be
+    calling the functions listed above.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    int     i;
+
+    for (i = 0; i < SKYEPH_OBJECT_COUNT; i++) {
+        selectedEph[i].segmentCount = 0;
+        if (file != NULL) {
+            (void)skyeph_getEphemeris(file, i, &selectedEph[i]);
+        }
+    }
+}
+
+
+
+GLOBAL void skyeph_setCurrentObject(int objectId)
+/*! Stores the selected object in internal storage for later use by
+    skyeph_getApparent()
+ \param[in]   objectId  Desired object: one of the values of SkyEph_Object,
+                        other than SKYEPH_NUTATION
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    REQUIRE(((objectId >= SKYEPH_MERCURY) && (objectId <= SKYEPH_NEPTUNE))
+            || (objectId == SKYEPH_SUN) || (objectId == SKYEPH_MOON));
+
+    currentObject = objectId;
+}
+
+
+
+GLOBAL void skyeph_sunApparent(double j2kTT_cy, Sky_TrueEquatorial *pos)
+/*! Get the Sun's apparent coordinates from the selected ephemeris file, or
+    from sun_nrelApparent() if the file does not cover this time.
+ \param[in]  j2kTT_cy  Julian centuries since J2000.0, TT timescale
+ \param[out] pos       Sun's apparent position vector, distance and the
+                       equation of the equinoxes
+
+ \par When to call this function
+    Pass this function to skyfast_init() in place of sun_nrelApparent(), after
+    calling skyeph_select().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    if (useEphemeris(SKYEPH_SUN, j2kTT_cy)) {
+        skycheb_getApprox(&selectedEph[SKYEPH_SUN], j2kTT_cy, pos);
+    } else {
+        sun_nrelApparent(j2kTT_cy, pos);
+    }
+}
+
+
+
+GLOBAL void skyeph_moonApparent(double j2kTT_cy, Sky_TrueEquatorial *pos)
+/*! Get the Moon's apparent coordinates from the selected ephemeris file, or
+    from moon_nrelApparent() if the file does not cover this time.
+ \param[in]  j2kTT_cy  Julian centuries since J2000.0, TT timescale
+ \param[out] pos       Moon's apparent position vector, distance and the
+                       equation of the equinoxes
+
+ \par When to call this function
+    Pass this function to skyfast_init() in place of moon_nrelApparent(), after
+    calling skyeph_select().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    if (useEphemeris(SKYEPH_MOON, j2kTT_cy)) {
+        skycheb_getApprox(&selectedEph[SKYEPH_MOON], j2kTT_cy, pos);
+    } else {
+        moon_nrelApparent(j2kTT_cy, pos);
+    }
+}
+
+
+
+GLOBAL void skyeph_getApparent(double j2kTT_cy, Sky_TrueEquatorial *pos)
+/*! Get the apparent coordinates of the object selected by
+    skyeph_setCurrentObject() from the selected ephemeris file. If the file does
+    not cover this object and time, the full calculation is done instead.
+ \param[in]  j2kTT_cy  Julian centuries since J2000.0, TT timescale
+ \param[out] pos       Object's apparent position vector, distance and the
+                       equation of the equinoxes
+
+ \note
+    For a planet, the full calculation is done by calling planet_setCurrent()
+    and planet_getApparent(), so it changes the planet module's current planet.
+
+ \par When to call this function
+    Pass this function to skyfast_init(), after calling skyeph_select() and
+    skyeph_setCurrentObject().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    if (useEphemeris(currentObject, j2kTT_cy)) {
+        skycheb_getApprox(&selectedEph[currentObject], j2kTT_cy, pos);
+    } else if (currentObject == SKYEPH_SUN) {
+        sun_nrelApparent(j2kTT_cy, pos);
+    } else if (currentObject == SKYEPH_MOON) {
+        moon_nrelApparent(j2kTT_cy, pos);
+    } else {
+        planet_setCurrent(currentObject);
+        planet_getApparent(j2kTT_cy, pos);
+    }
+}
+
+
+
+GLOBAL void skyeph_getNutation(double j2kTT_cy, Sky0_Nut1980 *nut)
+/*! Get the nutation angles, obliquity of the ecliptic and equation of the
+    equinoxes from the selected ephemeris file, or from sky0_nutationSpa() and
+    sky0_epsilonSpa() if the file does not cover this time.
+ \param[in]  j2kTT_cy  Julian centuries since J2000.0, TT timescale
+ \param[out] nut       Nutation angles, obliquity and equation of the
+                       equinoxes
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    if (useEphemeris(SKYEPH_NUTATION, j2kTT_cy)) {
+        skycheb_getNutation(&selectedEph[SKYEPH_NUTATION], j2kTT_cy, nut);
+    } else {
+        sky0_nutationSpa(j2kTT_cy, nut);
+        sky0_epsilonSpa(j2kTT_cy, nut);
+    }
+}
+
+
+/*
+ *------------------------------------------------------------------------------
+ *
+ * Local functions (not called from other modules)
+ *
+ *------------------------------------------------------------------------------
+ */
+LOCAL int checkBlock(const SkyEph_File *file, const SkyEph_BlockEntry *entry)
+/* Check that a directory entry is consistent, and that its coefficients lie
+   within the file image.
+ Returns - SKYEPH_NORMAL, SKYEPH_BADBLOCK or SKYEPH_TOOSMALL
+ Inputs
+    file  - the file image being checked
+    entry - the directory entry
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    size_t  bytes;
+
+    if ((entry->objectId < 0) || (entry->objectId >= SKYEPH_OBJECT_COUNT)
+        || (entry->componentCount
+            != ((entry->objectId == SKYEPH_NUTATION)
+                ? SKYCHEB_NUTATION_COMPONENTS
+                : SKYCHEB_APPARENT_COMPONENTS))
+        || (entry->coeffCount < 2) || (entry->coeffCount > SKYCHEB_MAX_COEFFS)
+        || (entry->segmentCount <= 0)
+        || !(entry->segment_cy > 0.0)
+        || ((entry->offset % sizeof(double)) != 0)
+        || (entry->offset < file->header->headerSize)) {
+        return SKYEPH_BADBLOCK;
+    }
+
+    bytes = blockSize(entry->segmentCount, entry->componentCount,
+                      entry->coeffCount);
+    if ((entry->offset > file->size) || (bytes > file->size - entry->offset)) {
+        return SKYEPH_TOOSMALL;
+    }
+    return SKYEPH_NORMAL;
+}
+
+
+
+LOCAL size_t blockSize(int32_t segmentCount,
+                       int32_t componentCount,
+                       int32_t coeffCount)
+/* Returns - the size of a block of coefficients (bytes)
+ Inputs
+    segmentCount, componentCount, coeffCount - dimensions of the block
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    return (size_t)segmentCount * (size_t)componentCount * (size_t)coeffCount
+           * sizeof(double);
+}
+
+
+
+LOCAL bool useEphemeris(int objectId, double t_cy)
+/* Returns - true if the selected file has an ephemeris for this object that
+             covers time t_cy
+ Inputs
+    objectId - object identifier
+    t_cy     - Julian centuries since J2000.0, TT timescale
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    const SkyCheb_Ephemeris *eph = &selectedEph[objectId];
+
+    return (eph->segmentCount > 0)
+           && (t_cy >= eph->start_cy)
+           && (t_cy <= eph->start_cy + eph->segmentCount * eph->segment_cy);
+}
+
+/*- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+/*! \page page-ephemeris-file Ephemeris files
+ *  An ephemeris file holds one or more Chebyshev ephemerides (as produced by
+ *  skycheb_fitApparent() or skycheb_fitNutation()) in a form that can be used
+ *  directly from memory, without any parsing or copying. On a POSIX system,
+ *  skyeph_open() maps the file into memory, so startup costs nothing more than
+ *  checking the header and directory, and the pages of the file are shared by
+ *  every process using it. On a system without a file system, the file image
+ *  can be linked into the program as a constant array (aligned on an 8-byte
+ *  boundary) and passed to skyeph_attach().
+ *
+ *  ###Layout (version 1)
+ *  All values are in the byte order of the machine that wrote the file, which
+ *  is recorded by the endian tag. A reader on a machine of the other byte order
+ *  rejects the file with error SKYEPH_WRONGENDIAN; regenerate the file on (or
+ *  for) the target machine.
+ *
+ *  Offset (bytes)      | Contents
+ *  --------------------|-----------------------------------------------------
+ *  0                   | Header (SkyEph_FileHeader): "SKYEPHEM", endian tag 0x01020304, version, number of blocks \e n, header size
+ *  24                  | Directory: \e n entries of type SkyEph_BlockEntry, 48 bytes each
+ *  24 + 48\e n         | Coefficients of each block, as IEEE 754 doubles
+ *
+ *  Each directory entry gives the object identifier, the dimensions and span
+ *  of its ephemeris, and the offset of its coefficients from the start of the
+ *  file. Within a block, coefficients are ordered by segment, then by
+ *  component, then by degree - exactly as skycheb_getApprox() expects them.
+ *  Every offset is a multiple of 8 bytes, so the coefficients are correctly
+ *  aligned wherever the file image is aligned on an 8-byte boundary.
+ *
+ *  ###Making a file
+ *  Fit each object with skycheb_fitApparent() (use planet_setCurrent() and
+ *  planet_getApparent() for a planet) and nutation with skycheb_fitNutation(),
+ *  then write them with skyeph_write(). See \ref page-chebyshev for suitable
+ *  segment lengths and numbers of coefficients. For example, the Sun with
+ *  8-day segments and 12 coefficients needs about 1.1 MB for the 50 years
+ *  2000-2050 (480 bytes per segment).
+ *
+ *  ###Using a file
+ *  \code
+ *      SkyEph_File    ephFile;
+ *
+ *      if (skyeph_open("sun-moon.eph", &ephFile) == SKYEPH_NORMAL) {
+ *          skyeph_select(&ephFile);
+ *      }
+ *      skyfast_init(j2kUtc_d, 60, &deltas, &skyeph_sunApparent);
+ *  \endcode
+ *  If the file cannot be opened, or does not cover the time required,
+ *  skyeph_sunApparent() falls back to sun_nrelApparent(), so the program still
+ *  works - it just starts more slowly.
+ */
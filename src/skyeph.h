@@ -0,0 +1,173 @@
+#ifndef SKYEPH_H
+#define SKYEPH_H
+/*============================================================================*/
+/*! \file
+ * \brief
+ * skyeph.h - read and write files of precalculated Chebyshev ephemerides, and
+ *            use them in place of the full position calculations
+ *
+ * \author  David Hoadley
+ *
+ * \details
+ *          Routines to save the Chebyshev ephemerides produced by the skycheb
+ *          module (for the Sun, the Moon, the planets and nutation) to a
+ *          binary file, and to use such a file later without reading or
+ *          converting its contents. The file is laid out so that, once it has
+ *          been memory-mapped (or linked into the program as a constant array,
+ *          or copied into flash memory), the coefficients can be used where
+ *          they lie. The functions skyeph_sunApparent(), skyeph_moonApparent()
+ *          and skyeph_getApparent() can be passed to skyfast_init() in place of
+ *          sun_nrelApparent(), moon_nrelApparent() and planet_getApparent().
+ *
+ *          See \ref page-ephemeris-file for the layout of the file.
+ *
+ *==============================================================================
+ */
+/*
+ * Copyright (c) 2020, David Hoadley <vcrumble@westnet.com.au>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stddef.h>
+
+#include "general.h"
+#include "sky.h"
+#include "sky0.h"
+#include "skycheb.h"
+
+/*
+ * Global #defines and typedefs
+ */
+/*      First eight bytes of every ephemeris file */
+#define SKYEPH_MAGIC            "SKYEPHEM"
+/*      Written in the native byte order of the machine writing the file. A
+        reader on a machine of the other byte order sees 0x04030201 instead. */
+#define SKYEPH_ENDIAN_TAG       0x01020304u
+/*      Version of the file layout described by the structures below */
+#define SKYEPH_VERSION          1u
+
+/*!     Identifiers of the objects whose ephemerides may be stored in a file.
+        The planets have the same numbers as used by planet_setCurrent(). */
+typedef enum {
+    SKYEPH_NUTATION = 0,    //!< Nutation, obliquity & equation of the equinoxes
+    SKYEPH_MERCURY  = 1,    //!< Mercury
+    SKYEPH_VENUS    = 2,    //!< Venus
+    SKYEPH_EMB      = 3,    //!< Earth-Moon Barycentre
+    SKYEPH_MARS     = 4,    //!< Mars
+    SKYEPH_JUPITER  = 5,    //!< Jupiter
+    SKYEPH_SATURN   = 6,    //!< Saturn
+    SKYEPH_URANUS   = 7,    //!< Uranus
+    SKYEPH_NEPTUNE  = 8,    //!< Neptune
+    SKYEPH_SUN      = 10,   //!< The Sun
+    SKYEPH_MOON     = 11,   //!< The Moon
+    SKYEPH_OBJECT_COUNT     //!< (One more than the largest identifier)
+} SkyEph_Object;
+
+/*! Errors detected when opening, checking or writing an ephemeris file */
+typedef enum {
+    SKYEPH_NORMAL,          /*!< Normal successful completion */
+    SKYEPH_OPENFAIL,        /*!< File could not be opened or mapped */
+    SKYEPH_TOOSMALL,        /*!< File is too short to hold its header,
+                             *   directory or coefficients */
+    SKYEPH_BADMAGIC,        /*!< File is not an ephemeris file */
+    SKYEPH_WRONGENDIAN,     /*!< File was written on a machine of the other
+                             *   byte order */
+    SKYEPH_BADVERSION,      /*!< File layout version is not supported */
+    SKYEPH_BADBLOCK,        /*!< A directory entry is inconsistent */
+    SKYEPH_NOTFOUND,        /*!< The requested object is not in the file */
+    SKYEPH_WRITEFAIL        /*!< File could not be written */
+} SkyEph_Errors;
+
+/*! Header at the start of an ephemeris file (24 bytes). All fields are in the
+    byte order of the machine that wrote the file. */
+typedef struct {
+    char     magic[8];      //!< #SKYEPH_MAGIC (no terminating null)
+    uint32_t endianTag;     //!< #SKYEPH_ENDIAN_TAG
+    uint32_t version;       //!< #SKYEPH_VERSION
+    uint32_t blockCount;    //!< Number of entries in the directory
+    uint32_t headerSize;    /*!< Size of this header plus the directory
+                                 (bytes) */
+} SkyEph_FileHeader;
+
+/*! Directory entry (48 bytes) describing one block of coefficients. The
+    directory immediately follows the file header. */
+typedef struct {
+    int32_t  objectId;      //!< Object identifier (see SkyEph_Object)
+    int32_t  componentCount;//!< Components per segment (5 or 4 for nutation)
+    int32_t  coeffCount;    //!< Chebyshev coefficients per component
+    int32_t  segmentCount;  //!< Number of segments
+    double   start_cy;      //!< Start of span covered (J2000 cy, TT)
+    double   segment_cy;    //!< Length of each segment (centuries)
+    double   maxError_as;   //!< Error bound found when fitting (arcseconds)
+    uint32_t offset;        /*!< Position of the coefficients, in bytes from
+                                 the start of the file (multiple of 8) */
+    uint32_t reserved;      //!< Zero
+} SkyEph_BlockEntry;
+
+/*! An ephemeris file that has been checked by skyeph_attach() or
+    skyeph_open(). The fields point into the file image itself. */
+typedef struct {
+    const unsigned char     *image;     //!< Start of the file image
+    size_t                  size;       //!< Size of the file image (bytes)
+    const SkyEph_FileHeader *header;    //!< The file header
+    const SkyEph_BlockEntry *directory; //!< The first directory entry
+    bool                    mapped;     //!< Image was mapped by skyeph_open()
+} SkyEph_File;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Global functions available to be called by other modules
+ */
+int skyeph_write(const char              path[],
+                 int                     count,
+                 const int               objectIds[],
+                 const SkyCheb_Ephemeris eph[]);
+int skyeph_attach(const void *image, size_t size, SkyEph_File *file);
+#ifdef POSIX_SYSTEM
+int skyeph_open(const char path[], SkyEph_File *file);
+void skyeph_close(SkyEph_File *file);
+#endif
+int skyeph_getEphemeris(const SkyEph_File *file,
+                        int               objectId,
+                        SkyCheb_Ephemeris *eph);
+
+/*      Functions to use a file in place of the full calculations */
+void skyeph_select(const SkyEph_File *file);
+void skyeph_setCurrentObject(int objectId);
+void skyeph_sunApparent(double j2kTT_cy, Sky_TrueEquatorial *pos);
+void skyeph_moonApparent(double j2kTT_cy, Sky_TrueEquatorial *pos);
+void skyeph_getApparent(double j2kTT_cy, Sky_TrueEquatorial *pos);
+void skyeph_getNutation(double j2kTT_cy, Sky0_Nut1980 *nut);
+
+/*
+ * Global variables accessible by other modules
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SKYEPH_H */
@@ -34,7 +34,11 @@
  */
 
 /* ANSI includes etc. */
+#include <limits.h>                     /* for LONG_MIN */
 #include <math.h>
+#ifdef POSIX_THREADS
+# include <time.h>
+#endif
 
 /* Local and project includes */
 #include "skyfast.h"
@@ -49,31 +53,81 @@
  */
 DEFINE_THIS_FILE;                       // For use by REQUIRE() - assertions.
 
-/*      --- Definitions that you may need to or wish to modify --- */
-//#define BARE_METAL_THREADS
-//#define POSIX_THREADS
-//#define NO_THREADS
+/*      The choice of BARE_METAL_THREADS, POSIX_THREADS or NO_THREADS is made in
+        skyfast.h. See \ref page-skyfast-c */
 #if defined(BARE_METAL_THREADS)
-#define startCriticalSection()      disableInterrupts()
-#define endCriticalSection()        enableInterrupts()
+#define startCriticalSection(ctx)   disableInterrupts()
+#define endCriticalSection(ctx)     enableInterrupts()
+#define loadIndex(p)                (*(p))
+#define storeIndex(p, v)            (*(p) = (v))
 
 #elif defined(POSIX_THREADS)
-#include <pthread.h>
-
-#define startCriticalSection()      pthread_mutex_lock(&mutex)
-#define endCriticalSection()        pthread_mutex_unlock(&mutex)
+/* No lock. Each of the shared indices is written by only one of the two
+   threads. The background thread only writes to nodes that the tracking thread
+   cannot yet see (numbers at or beyond writeIndex), and only after the tracking
+   thread has moved past them (lastIndex). The release store of an index
+   publishes everything written before it, and the acquire load makes it visible
+   to the other thread. Neither thread ever waits for the other. */
+#define startCriticalSection(ctx)   ((void)0)
+#define endCriticalSection(ctx)     ((void)0)
+#define loadIndex(p)                atomic_load_explicit((p), \
+                                                         memory_order_acquire)
+#define storeIndex(p, v)            atomic_store_explicit((p), (v), \
+                                                          memory_order_release)
+/*      Time that the worker thread sleeps when it has filled all the nodes */
+#define WORKER_PAUSE_ns             100000000L
 
 #else /* Must be NO_THREADS */
-#define startCriticalSection()      ((void)0)
-#define endCriticalSection()        ((void)0)
+#define startCriticalSection(ctx)   ((void)0)
+#define endCriticalSection(ctx)     ((void)0)
+#define loadIndex(p)                (*(p))
+#define storeIndex(p, v)            (*(p) = (v))
 
 #endif
 
 
 
+/*      Limits to the spacing of the nodes when a tolerance has been set by
+        skyfast_ctxSetTolerance() */
+#define MIN_SPACING_mins    1.0
+#define MAX_SPACING_mins    1440.0
+
+
 /*
  * Prototypes for local functions (not called from other modules)
  */
+LOCAL void initContext(Skyfast_Context   *ctx,
+                       double            tStartUtc_d,
+                       int               fullRecalcInterval_mins,
+                       Skyfast_Interpolation interpolation,
+                       int               nodeCount,
+                       const Sky_DeltaTs *deltas);
+LOCAL bool fillNextNode(Skyfast_Context *ctx);
+LOCAL void interpolate(Skyfast_Interpolation    method,
+                       const Sky_TrueEquatorial *p0,
+                       const Sky_TrueEquatorial *p1,
+                       const Sky_TrueEquatorial *p2,
+                       double                   t_cy,
+                       Sky_TrueEquatorial       *approx);
+LOCAL double midpointError_rad(const Skyfast_Context *ctx,
+                               long w,
+                               Sky_TrueEquatorial *mid);
+LOCAL void initReplay(Skyfast_Replay     *replay,
+                      double             tStartUtc_d,
+                      int                fullRecalcInterval_mins,
+                      Skyfast_Interpolation interpolation,
+                      int                slotCount,
+                      Skyfast_ReplayNode slots[],
+                      const Sky_DeltaTs  *deltas);
+LOCAL const Sky_TrueEquatorial *replayNode(Skyfast_Replay *replay, long n);
+LOCAL double angleBetween_rad(const V3D_Vector *aV, const V3D_Vector *bV);
+LOCAL Sky_TrueEquatorial *nodeAt(Skyfast_Context *ctx, long n);
+LOCAL void calculate(const Skyfast_Context *ctx,
+                     double t_cy,
+                     Sky_TrueEquatorial *pos);
+#ifdef POSIX_THREADS
+LOCAL void *workerThread(void *arg);
+#endif
 
 
 /*
@@ -84,18 +138,9 @@ DEFINE_THIS_FILE;                       // For use by REQUIRE() - assertions.
 /*
  * Local variables (not accessed by other modules)
  */
-LOCAL Sky_TrueEquatorial  lfiA, lfiB, lfiC;
-LOCAL Sky_TrueEquatorial  *last = &lfiA;    // items calculated for time in past
-LOCAL Sky_TrueEquatorial  *next = &lfiB;    // items calculated for time ahead
-LOCAL Sky_TrueEquatorial  *oneAfter = &lfiC;// ditto for time after next
-LOCAL volatile bool       oneAfterIsValid = false;
-
-LOCAL void (*callback)(double j2kTT_cy, Sky_TrueEquatorial *pos);
-LOCAL double        recalcInterval_cy = 0.0; // time between full recalculations
-
-#ifdef POSIX_THREADS
-LOCAL pthread_mutex_t mutex;
-#endif
+/* The context used by skyfast_init(), skyfast_backgroundUpdate() and
+   skyfast_getApprox() */
+LOCAL Skyfast_Context defaultContext;
 
 /*
  *==============================================================================
@@ -156,42 +201,17 @@ GLOBAL void skyfast_init(double            tStartUtc_d,
     the Celestial Intermediate Origin (CIO) at time \a t_cy) instead. If so,
     the function does not need to fill in the \a eqEq_rad field of struct
     Sky_TrueEquatorial.
+ \note
+    This function and the two that follow work on a single context held
+    within this module, so they can track only one object at a time. To track
+    several objects at once, or to use quadratic interpolation (which allows a
+    much longer \a fullRecalcInterval_mins for the same accuracy), use
+    skyfast_ctxInit() and the other skyfast_ctx... functions instead.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 {
-    Sky_Times   atime;              // time, in various timescales
-    double      calcTimeTT_cy;
-#ifdef POSIX_THREADS
-    int         ret;
-#endif
-
-    REQUIRE_NOT_NULL(deltas);
-    REQUIRE_NOT_NULL(getApparent);
-    REQUIRE(fullRecalcInterval_mins > 0);
-
-
-#ifdef POSIX_THREADS
-    ret = pthread_mutex_init(&mutex, NULL);
-    ASSERT(ret == 0);   // There is no possible recovery from an error here.
-#endif
-    /* Save the function address for later call by skyfast_backgroundUpdate() */
-    callback = getApparent;
-
-    sky_updateTimes(tStartUtc_d, deltas, &atime);
-
-    /* Save the recalculation rate, converted from minutes to centuries. */
-    recalcInterval_cy = fullRecalcInterval_mins / (1440.0 * JUL_CENT);
-
-    calcTimeTT_cy = atime.j2kTT_cy;
-    getApparent(calcTimeTT_cy, last);
-
-    /* Now do the same for the next time (e.g. next hour) */
-    calcTimeTT_cy += recalcInterval_cy;
-    getApparent(calcTimeTT_cy, next);
-
-    /* And again for the time after */
-    calcTimeTT_cy += recalcInterval_cy;
-    getApparent(calcTimeTT_cy, oneAfter);
-    oneAfterIsValid = true;
+    skyfast_ctxInit(&defaultContext, tStartUtc_d, fullRecalcInterval_mins,
+                    SKYFAST_LINEAR, SKYFAST_DEFAULT_NODES, deltas,
+                    getApparent);
 }
 
 
@@ -215,18 +235,7 @@ GLOBAL void skyfast_backgroundUpdate(void)
     and therefore needs to access the data for time "oneAfter".
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 {
-    double  t_cy;
-
-    REQUIRE(recalcInterval_cy > 0.0);  // skyfast_init() not called before now?
-
-    if (!oneAfterIsValid) {
-        t_cy = next->timestamp_cy + recalcInterval_cy;
-        callback(t_cy, oneAfter);
-
-        startCriticalSection();
-        oneAfterIsValid = true;
-        endCriticalSection();
-    }
+    skyfast_ctxBackgroundUpdate(&defaultContext);
 }
 
 
@@ -256,36 +265,768 @@ GLOBAL void skyfast_getApprox(double t_cy,
     coordinates.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 {
-    Sky_TrueEquatorial *temp;
-    double a;
-    double b;
+    skyfast_ctxGetApprox(&defaultContext, t_cy, approx);
+}
+
+
+
+GLOBAL void skyfast_setTolerance(double tolerance_as)
+/*! Let the module choose the interval between full recalculations, so as to
+    keep the interpolation error within \a tolerance_as. This does the same as
+    skyfast_ctxSetTolerance(), for the context used by skyfast_init().
+ \param[in]  tolerance_as  Largest interpolation error allowed (arcseconds), or
+                           zero to return to fixed intervals
+
+ \par When to call this function
+    After skyfast_init(), and before the first call to skyfast_getApprox().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    skyfast_ctxSetTolerance(&defaultContext, tolerance_as);
+}
+
+
+
+GLOBAL void skyfast_ctxInit(Skyfast_Context   *ctx,
+                            double            tStartUtc_d,
+                            int               fullRecalcInterval_mins,
+                            Skyfast_Interpolation interpolation,
+                            int               nodeCount,
+                            const Sky_DeltaTs *deltas,
+                            void (*getApparent)(double j2kTT_cy,
+                                                Sky_TrueEquatorial *pos)
+                            )
+/*! Initialise a tracking context. This does the same as skyfast_init(), but
+    for the context \a ctx, so that several objects can be tracked at once,
+    each with its own context.
+ \param[out] ctx          Context to be initialised. You supply the storage for
+                          this; it must remain in existence for as long as it
+                          is being used.
+ \param[in]  tStartUtc_d  Time for first full calculation using function
+                          \a getApparent(). UTC time in "J2KD" form - i.e days
+                          since J2000.0 (= JD - 2 451 545.0)
+ \param[in]  fullRecalcInterval_mins
+                          Interval of time between full recalculation of the
+                          object's position (minutes). Must be greater than
+                          zero.
+ \param[in]  interpolation
+                          SKYFAST_LINEAR or SKYFAST_QUADRATIC. See
+                          \ref page-interpolation for the errors of each, and
+                          hence a suitable value of
+                          \a fullRecalcInterval_mins.
+ \param[in]  nodeCount    Number of fully calculated positions that the context
+                          holds, from 4 to SKYFAST_MAX_NODES. The background
+                          calculations stay up to (\a nodeCount - 2) x
+                          \a fullRecalcInterval_mins ahead of the tracking
+                          time. Use SKYFAST_DEFAULT_NODES (4) unless the
+                          background calculations might be held up for longer
+                          than one interval.
+ \param[in]  deltas       Delta T values, as set by the sky_initTime() (or
+                          sky_initTimeSimple() or sky_initTimeDetailed())
+                          routines
+ \param      getApparent  Function to get the position of a celestial object in
+                          apparent coordinates, as for skyfast_init()
+
+ \par When to call this function
+    At program initialisation time, once for each object to be tracked. If a
+    worker thread has been started for this context with
+    skyfast_ctxStartWorker(), stop it first.
+ \note
+    Functions such as planet_getApparent() and star_getApparent() calculate
+    the position of the object selected by planet_setCurrent() or
+    star_setCurrentObject(), so only one context at a time can use each of
+    them. To track several stars at once, use skyfast_ctxInitObject() with
+    star_getApparentOf() instead.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    REQUIRE_NOT_NULL(ctx);
+    REQUIRE_NOT_NULL(getApparent);
+
+    /* Save the function address for later call by
+       skyfast_ctxBackgroundUpdate() */
+    ctx->callback = getApparent;
+    ctx->callbackOf = NULL;
+    ctx->object = NULL;
+    initContext(ctx, tStartUtc_d, fullRecalcInterval_mins, interpolation,
+                nodeCount, deltas);
+}
+
+
+
+GLOBAL void skyfast_ctxInitObject(Skyfast_Context   *ctx,
+                                  double            tStartUtc_d,
+                                  int               fullRecalcInterval_mins,
+                                  Skyfast_Interpolation interpolation,
+                                  int               nodeCount,
+                                  const Sky_DeltaTs *deltas,
+                                  void (*getApparentOf)(const void *object,
+                                                        double j2kTT_cy,
+                                                        Sky_TrueEquatorial *pos),
+                                  const void        *object)
+/*! Initialise a tracking context for a particular object. This is the same as
+    skyfast_ctxInit(), except that the function which calculates the object's
+    position is passed a pointer to a description of the object each time it
+    is called. This allows many contexts to use the same function to track
+    different objects, e.g. many stars using star_getApparentOf().
+ \param[out] ctx          Context to be initialised
+ \param[in]  tStartUtc_d  Time for first full calculation (UTC, J2KD form)
+ \param[in]  fullRecalcInterval_mins
+                          Interval of time between full recalculation of the
+                          object's position (minutes). Must be greater than
+                          zero.
+ \param[in]  interpolation
+                          SKYFAST_LINEAR or SKYFAST_QUADRATIC
+ \param[in]  nodeCount    Number of fully calculated positions, as for
+                          skyfast_ctxInit()
+ \param[in]  deltas       Delta T values, as set by the sky_initTime() (or
+                          sky_initTimeSimple() or sky_initTimeDetailed())
+                          routines
+ \param      getApparentOf
+                          Function to get the position of the object described
+                          by \a object in apparent coordinates
+ \param[in]  object       Description of the object, passed unchanged to
+                          \a getApparentOf. It must remain in existence for as
+                          long as the context is being used.
+
+ \par When to call this function
+    At program initialisation time, once for each object to be tracked.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    REQUIRE_NOT_NULL(ctx);
+    REQUIRE_NOT_NULL(getApparentOf);
+
+    ctx->callback = NULL;
+    ctx->callbackOf = getApparentOf;
+    ctx->object = object;
+    initContext(ctx, tStartUtc_d, fullRecalcInterval_mins, interpolation,
+                nodeCount, deltas);
+}
+
+
 
-    if (t_cy > next->timestamp_cy) {
-        /* Time t_cy is no longer between last and next, so we need to make next
-           and oneAfter become the new last and next respectively. But this
-           requires that our low frequency/low priority routine has completed
-           filling in all the data for oneAfter. */
-        REQUIRE(oneAfterIsValid);
-
-        startCriticalSection();
-        temp = last;
-        last = next;
-        next = oneAfter;
-        oneAfter = temp;
-        oneAfterIsValid = false;
-        endCriticalSection();
+GLOBAL void skyfast_ctxSetTolerance(Skyfast_Context *ctx, double tolerance_as)
+/*! Let the module choose the interval between full recalculations for
+    context \a ctx, so as to keep the interpolation error within
+    \a tolerance_as. The \a fullRecalcInterval_mins value given to
+    skyfast_ctxInit() becomes just the first interval tried.
+
+    Each time the background calculations calculate a node, they also calculate
+    the position halfway between it and the node before, and compare that with
+    the interpolated position there. If the difference exceeds
+    \a tolerance_as, the interval is halved (down to a minimum of one minute).
+    If the difference is comfortably less than \a tolerance_as, the interval
+    is increased by a quarter for the following node (up to a maximum of one
+    day). So the nodes
+    crowd together where the object's apparent motion is changing quickly (the
+    Moon near perigee, say) and spread out where it is not (a star). Each node
+    costs at least two full calculations instead of one, but for most objects
+    far fewer nodes are needed. See \ref page-interpolation.
+ \param[in,out] ctx           Context, as set up by skyfast_ctxInit() or
+                              skyfast_ctxInitObject()
+ \param[in]     tolerance_as  Largest interpolation error allowed (arcseconds),
+                              or zero to return to fixed intervals of
+                              \a fullRecalcInterval_mins
+
+ \par When to call this function
+    After skyfast_ctxInit() or skyfast_ctxInitObject(), and before the first
+    call to skyfast_ctxGetApprox() or skyfast_ctxStartWorker(). All the nodes
+    after the start time are recalculated.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    REQUIRE_NOT_NULL(ctx);
+    REQUIRE(ctx->recalcInterval_cy > 0.0);  // skyfast_ctxInit() not called?
+    REQUIRE(tolerance_as >= 0.0);
+#ifdef POSIX_THREADS
+    REQUIRE(!ctx->workerRunning);
+#endif
+
+    ctx->tolerance_rad = arcsecToRad(tolerance_as);
+    ctx->spacing_cy = ctx->recalcInterval_cy;
+
+    /* Discard the nodes after the start node, and calculate them again */
+    storeIndex(&ctx->writeIndex, loadIndex(&ctx->lastIndex) + 1);
+    while (fillNextNode(ctx)) {
+        ;
     }
+}
+
+
+
+GLOBAL void skyfast_ctxBackgroundUpdate(Skyfast_Context *ctx)
+/*! Recalculation of the low frequency quantities for one context. This does
+    the same as skyfast_backgroundUpdate(), but for the context \a ctx. It
+    fills in every node of the context that the tracking thread has finished
+    with, so if the context was set up with a large \a nodeCount, the first
+    call after a long delay may take several full calculations to complete.
+ \param[in,out] ctx   Context, as set up by skyfast_ctxInit() or
+                      skyfast_ctxInitObject()
+
+ \par When to call this function
+    In a low priority loop or background thread, as for
+    skyfast_backgroundUpdate(). If you are tracking several objects, call this
+    function for each of their contexts in turn. Updating one context never
+    delays skyfast_ctxGetApprox() on any context. Do not call this function for
+    a context that has a worker thread started by skyfast_ctxStartWorker().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    REQUIRE_NOT_NULL(ctx);
+    REQUIRE(ctx->recalcInterval_cy > 0.0);  // skyfast_ctxInit() not called?
+
+    while (fillNextNode(ctx)) {
+        ;                       // Keep going until there are no free nodes
+    }
+}
+
+
+
+GLOBAL void skyfast_ctxGetApprox(Skyfast_Context *ctx,
+                                 double t_cy,
+                                 Sky_TrueEquatorial *approx)
+/*! Get the best approximation to a celestial object's apparent coordinates
+    and distance, and the equation of the equinoxes, by interpolation. This
+    does the same as skyfast_getApprox(), but for the context \a ctx, and
+    using the interpolation method chosen for that context.
+ \param[in,out] ctx     Context, as set up by skyfast_ctxInit() or
+                        skyfast_ctxInitObject()
+ \param[in]     t_cy    Julian centuries since J2000.0, TT timescale. This must
+                        specify a time no earlier than the start time of the
+                        context.
+ \param[out]    approx  position vector, distance, etc, obtained by
+                        interpolation
+
+ \note
+    If the background calculations have fallen so far behind that the node
+    after time \a t_cy has not yet been calculated, this function does the full
+    calculation for time \a t_cy itself, and adds one to the count returned by
+    skyfast_ctxFallbackCount(). The position returned is then exact, but the
+    call takes as long as a full calculation. In that case the function
+    supplied to skyfast_ctxInit() (or skyfast_ctxInitObject()) may be running
+    in both threads at once, so it must not depend on unprotected static data.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    const Sky_TrueEquatorial *p0, *p1, *p2;
+    long   k;                       // Number of the node at or before t_cy
+    long   w;                       // Number of the first node not calculated
+
+    REQUIRE_NOT_NULL(ctx);
+    REQUIRE_NOT_NULL(approx);
+    REQUIRE(ctx->recalcInterval_cy > 0.0);  // skyfast_ctxInit() not called?
+
+    k = loadIndex(&ctx->lastIndex);
+    if (t_cy > nodeAt(ctx, k + 1)->timestamp_cy) {
+        /* Time t_cy is no longer between last and next, so we need to move on
+           to the nodes either side of t_cy. But we can only use nodes that our
+           low frequency/low priority routine has completed filling in. */
+        w = loadIndex(&ctx->writeIndex);
+        while ((k + 2 < w) && (t_cy > nodeAt(ctx, k + 1)->timestamp_cy)) {
+            k++;
+        }
+        storeIndex(&ctx->lastIndex, k);
+
+        if (t_cy > nodeAt(ctx, k + 1)->timestamp_cy) {
+            /* The background calculations have not kept up. Do the full
+               calculation here instead, and keep count of it. */
+            calculate(ctx, t_cy, approx);
+            storeIndex(&ctx->fallbackCount,
+                       loadIndex(&ctx->fallbackCount) + 1);
+            return;
+        }
+    }
+
+    p0 = nodeAt(ctx, k - 1);
+    p1 = nodeAt(ctx, k);
+    p2 = nodeAt(ctx, k + 1);
 
     /* It is a programming error if time t_cy is not between last and next */
-    REQUIRE(t_cy >= last->timestamp_cy);
-    REQUIRE(next->timestamp_cy >= t_cy);
+    REQUIRE(t_cy >= p1->timestamp_cy);
+    REQUIRE(p2->timestamp_cy >= t_cy);
+
+    interpolate(ctx->interpolation, p0, p1, p2, t_cy, approx);
+}
+
+
+
+GLOBAL long skyfast_ctxFallbackCount(const Skyfast_Context *ctx)
+/*! Returns the number of times that skyfast_ctxGetApprox() has had to do a
+    full calculation because the background calculations had not kept up.
+    A count that keeps growing means that the background thread is not getting
+    enough processor time, or that the context needs a larger \a nodeCount.
+ \param[in]  ctx   Context, as set up by skyfast_ctxInit() or
+                   skyfast_ctxInitObject()
+
+ \par When to call this function
+    At any time, from either thread.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    REQUIRE_NOT_NULL(ctx);
+
+    return loadIndex(&ctx->fallbackCount);
+}
+
+
+GLOBAL void skyfast_replayInit(Skyfast_Replay     *replay,
+                               double             tStartUtc_d,
+                               int                fullRecalcInterval_mins,
+                               Skyfast_Interpolation interpolation,
+                               int                slotCount,
+                               Skyfast_ReplayNode slots[],
+                               const Sky_DeltaTs  *deltas,
+                               void (*getApparent)(double j2kTT_cy,
+                                                   Sky_TrueEquatorial *pos)
+                               )
+/*! Initialise interpolation for replaying a recorded session. Unlike the
+    skyfast_ctx... functions, which can only move forward in time, the replay
+    functions accept times in any order, and can go backwards. The nodes are
+    evenly spaced \a fullRecalcInterval_mins apart, starting at
+    \a tStartUtc_d, so the nodes either side of any time are found directly.
+    Each node is calculated when it is first needed, and kept in \a slots
+    until it is displaced by another node that needs the same slot. So times
+    that move back and forth within a window of \a slotCount nodes cost no
+    further full calculations.
+ \param[out] replay       Replay state to be initialised. You supply the
+                          storage for this.
+ \param[in]  tStartUtc_d  Time of one of the nodes (UTC, J2KD form). Times
+                          before this may also be requested.
+ \param[in]  fullRecalcInterval_mins
+                          Interval of time between nodes (minutes). Must be
+                          greater than zero. See \ref page-interpolation
+ \param[in]  interpolation
+                          SKYFAST_LINEAR or SKYFAST_QUADRATIC
+ \param[in]  slotCount    Number of elements in array \a slots. Must be at
+                          least 3.
+ \param[out] slots        Storage for the nodes. It must remain in existence
+                          for as long as \a replay is being used.
+ \param[in]  deltas       Delta T values, as set by the sky_initTime() (or
+                          sky_initTimeSimple() or sky_initTimeDetailed())
+                          routines
+ \param      getApparent  Function to get the position of a celestial object in
+                          apparent coordinates, as for skyfast_init()
+
+ \par When to call this function
+    Before replaying a session. No full calculations are done until
+    skyfast_replayPreload() or skyfast_replayGetApprox() is called. To replay
+    the session again, or to scrub backwards, just call
+    skyfast_replayGetApprox() with the times you want; there is no need to
+    call this function again.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    REQUIRE_NOT_NULL(replay);
+    REQUIRE_NOT_NULL(getApparent);
+
+    replay->callback = getApparent;
+    replay->callbackOf = NULL;
+    replay->object = NULL;
+    initReplay(replay, tStartUtc_d, fullRecalcInterval_mins, interpolation,
+               slotCount, slots, deltas);
+}
+
+
+
+GLOBAL void skyfast_replayInitObject(Skyfast_Replay     *replay,
+                                     double             tStartUtc_d,
+                                     int                fullRecalcInterval_mins,
+                                     Skyfast_Interpolation interpolation,
+                                     int                slotCount,
+                                     Skyfast_ReplayNode slots[],
+                                     const Sky_DeltaTs  *deltas,
+                                     void (*getApparentOf)(
+                                                    const void *object,
+                                                    double j2kTT_cy,
+                                                    Sky_TrueEquatorial *pos),
+                                     const void         *object)
+/*! Initialise interpolation for replaying a recorded session of a particular
+    object. This is the same as skyfast_replayInit(), except that the function
+    which calculates the object's position is passed \a object each time it is
+    called, as for skyfast_ctxInitObject().
+ \param[out] replay       Replay state to be initialised
+ \param[in]  tStartUtc_d  Time of one of the nodes (UTC, J2KD form)
+ \param[in]  fullRecalcInterval_mins
+                          Interval of time between nodes (minutes). Must be
+                          greater than zero.
+ \param[in]  interpolation
+                          SKYFAST_LINEAR or SKYFAST_QUADRATIC
+ \param[in]  slotCount    Number of elements in array \a slots (at least 3)
+ \param[out] slots        Storage for the nodes
+ \param[in]  deltas       Delta T values
+ \param      getApparentOf
+                          Function to get the position of the object described
+                          by \a object in apparent coordinates
+ \param[in]  object       Description of the object, passed unchanged to
+                          \a getApparentOf
+
+ \par When to call this function
+    Before replaying a session.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    REQUIRE_NOT_NULL(replay);
+    REQUIRE_NOT_NULL(getApparentOf);
+
+    replay->callback = NULL;
+    replay->callbackOf = getApparentOf;
+    replay->object = object;
+    initReplay(replay, tStartUtc_d, fullRecalcInterval_mins, interpolation,
+               slotCount, slots, deltas);
+}
+
+
+
+GLOBAL void skyfast_replayPreload(Skyfast_Replay *replay,
+                                  double         tFrom_cy,
+                                  double         tTo_cy)
+/*! Calculate in advance all the nodes needed to interpolate between times
+    \a tFrom_cy and \a tTo_cy, so that later calls to skyfast_replayGetApprox()
+    for times in that range do no full calculations. If the range needs more
+    nodes than there are slots, only the nodes for the start of the range are
+    calculated.
+ \param[in,out] replay    Replay state, as set up by skyfast_replayInit() or
+                          skyfast_replayInitObject()
+ \param[in]     tFrom_cy  Start of the range (Julian centuries since J2000.0,
+                          TT timescale)
+ \param[in]     tTo_cy    End of the range. Must not be earlier than
+                          \a tFrom_cy.
+
+ \par When to call this function
+    Optionally, before starting a replay, or while it is paused.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  x;
+    long    n;
+    long    nLast;
+
+    REQUIRE_NOT_NULL(replay);
+    REQUIRE(replay->interval_cy > 0.0);     // skyfast_replayInit() not called?
+    REQUIRE(tTo_cy >= tFrom_cy);
+
+    x = floor((tFrom_cy - replay->origin_cy) / replay->interval_cy);
+    n = (long)x;
+    if (replay->interpolation == SKYFAST_QUADRATIC) {
+        n--;
+    }
+    x = floor((tTo_cy - replay->origin_cy) / replay->interval_cy);
+    nLast = (long)x + 1;
+    if (nLast - n >= replay->slotCount) {
+        nLast = n + replay->slotCount - 1;
+    }
+
+    for ( ; n <= nLast; n++) {
+        (void)replayNode(replay, n);
+    }
+}
+
 
-    if ((next->timestamp_cy - last->timestamp_cy) < SFA) {
+
+GLOBAL void skyfast_replayGetApprox(Skyfast_Replay *replay,
+                                    double t_cy,
+                                    Sky_TrueEquatorial *approx)
+/*! Get the best approximation to a celestial object's apparent coordinates
+    and distance, and the equation of the equinoxes, by interpolation, at any
+    time. This is the same as skyfast_ctxGetApprox(), except that successive
+    calls may ask for times in any order. The nodes either side of \a t_cy
+    are found directly from \a t_cy, and any that are not already held are
+    calculated first (so that call takes longer).
+ \param[in,out] replay  Replay state, as set up by skyfast_replayInit() or
+                        skyfast_replayInitObject()
+ \param[in]     t_cy    Julian centuries since J2000.0, TT timescale
+ \param[out]    approx  position vector, distance, etc, obtained by
+                        interpolation
+
+ \par When to call this function
+    Whenever you need the object's position during a replay.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    const Sky_TrueEquatorial *p0, *p1, *p2;
+    double  x;
+    long    n;                      // Number of the node at or before t_cy
+
+    REQUIRE_NOT_NULL(replay);
+    REQUIRE_NOT_NULL(approx);
+    REQUIRE(replay->interval_cy > 0.0);     // skyfast_replayInit() not called?
+
+    x = floor((t_cy - replay->origin_cy) / replay->interval_cy);
+    n = (long)x;
+
+    /* There are at least three slots, so these nodes never displace each
+       other */
+    p1 = replayNode(replay, n);
+    p2 = replayNode(replay, n + 1);
+    if (replay->interpolation == SKYFAST_QUADRATIC) {
+        p0 = replayNode(replay, n - 1);
+    } else {
+        p0 = p1;                    // (not used)
+    }
+    interpolate(replay->interpolation, p0, p1, p2, t_cy, approx);
+}
+
+
+#ifdef POSIX_THREADS
+GLOBAL int skyfast_ctxStartWorker(Skyfast_Context *ctx)
+/*! Start a thread that does the background calculations for context \a ctx,
+    so that you do not need to call skyfast_ctxBackgroundUpdate() yourself.
+    The thread keeps all of the context's nodes filled in, and sleeps when
+    there is nothing to do. If the system defines the SCHED_IDLE scheduling
+    policy (on Linux, compile with _GNU_SOURCE defined), the thread runs with
+    that policy, so that it only uses processor time that nothing else wants.
+    Otherwise it runs with the default scheduling policy and priority.
+ \returns   0 if the thread was started, otherwise the error code returned by
+            pthread_create()
+ \param[in,out] ctx   Context, as set up by skyfast_ctxInit() or
+                      skyfast_ctxInitObject()
+
+ \par When to call this function
+    After skyfast_ctxInit() or skyfast_ctxInitObject(), and before tracking
+    starts. Call skyfast_ctxStopWorker() before the context goes out of
+    existence or is initialised again.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    int     result;
+
+    REQUIRE_NOT_NULL(ctx);
+    REQUIRE(ctx->recalcInterval_cy > 0.0);  // skyfast_ctxInit() not called?
+    REQUIRE(!ctx->workerRunning);           // Worker already started
+
+    atomic_store_explicit(&ctx->workerStop, false, memory_order_relaxed);
+    result = -1;
+#ifdef SCHED_IDLE
+    {
+        pthread_attr_t      attr;
+        struct sched_param  param;
+
+        param.sched_priority = 0;
+        if (pthread_attr_init(&attr) == 0) {
+            if ((pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED)
+                                                                        == 0)
+                && (pthread_attr_setschedpolicy(&attr, SCHED_IDLE) == 0)
+                && (pthread_attr_setschedparam(&attr, &param) == 0)) {
+                result = pthread_create(&ctx->worker, &attr, workerThread,
+                                        ctx);
+            }
+            (void)pthread_attr_destroy(&attr);
+        }
+    }
+#endif
+    if (result != 0) {
+        /* Idle scheduling is not available (or not permitted), so use the
+           default attributes */
+        result = pthread_create(&ctx->worker, NULL, workerThread, ctx);
+    }
+    ctx->workerRunning = (result == 0);
+    return result;
+}
+
+
+
+GLOBAL void skyfast_ctxStopWorker(Skyfast_Context *ctx)
+/*! Stop the thread started by skyfast_ctxStartWorker(), and wait for it to
+    finish. This can take as long as one full calculation plus the worker's
+    sleep time (0.1 s). It does nothing if no worker thread is running.
+ \param[in,out] ctx   Context with a worker thread
+
+ \par When to call this function
+    When tracking has finished, before the context goes out of existence.
+    Do not call it from the tracking thread while tracking is in progress.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    REQUIRE_NOT_NULL(ctx);
+
+    if (ctx->workerRunning) {
+        atomic_store_explicit(&ctx->workerStop, true, memory_order_release);
+        (void)pthread_join(ctx->worker, NULL);
+        ctx->workerRunning = false;
+    }
+}
+#endif
+
+
+/*
+ *------------------------------------------------------------------------------
+ *
+ * Local functions (not called from other modules)
+ *
+ *------------------------------------------------------------------------------
+ */
+LOCAL void initContext(Skyfast_Context   *ctx,
+                       double            tStartUtc_d,
+                       int               fullRecalcInterval_mins,
+                       Skyfast_Interpolation interpolation,
+                       int               nodeCount,
+                       const Sky_DeltaTs *deltas)
+/* Set up the fully calculated positions of a context whose
+   callback has already been stored. Node 1 is at the start time, and node 0
+   (only calculated for quadratic interpolation) one interval before it. All
+   the following nodes that fit in the context are calculated too.
+ Inputs
+    tStartUtc_d, fullRecalcInterval_mins, interpolation, nodeCount, deltas
+        - as for skyfast_ctxInit()
+ In/Out
+    ctx - the context
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    Sky_Times   atime;              // time, in various timescales
+
+    REQUIRE_NOT_NULL(deltas);
+    REQUIRE(fullRecalcInterval_mins > 0);
+    REQUIRE(nodeCount >= 4);
+    REQUIRE(nodeCount <= SKYFAST_MAX_NODES);
+
+    ctx->nodeCount = nodeCount;
+    ctx->interpolation = interpolation;
+#ifdef POSIX_THREADS
+    atomic_store_explicit(&ctx->workerStop, false, memory_order_relaxed);
+    ctx->workerRunning = false;
+#endif
+
+    sky_updateTimes(tStartUtc_d, deltas, &atime);
+
+    /* Save the recalculation rate, converted from minutes to centuries. */
+    ctx->recalcInterval_cy = fullRecalcInterval_mins / (1440.0 * JUL_CENT);
+    ctx->spacing_cy = ctx->recalcInterval_cy;
+    ctx->tolerance_rad = 0.0;
+
+    calculate(ctx, atime.j2kTT_cy, nodeAt(ctx, 1));
+
+    /* Quadratic interpolation also needs the position one interval earlier.
+       (For linear interpolation, node 0 is never used.) */
+    if (interpolation == SKYFAST_QUADRATIC) {
+        calculate(ctx, atime.j2kTT_cy - ctx->recalcInterval_cy,
+                  nodeAt(ctx, 0));
+    }
+
+    storeIndex(&ctx->lastIndex, 1);
+    storeIndex(&ctx->writeIndex, 2);
+    storeIndex(&ctx->fallbackCount, 0);
+
+    /* Now do the same for the next time (e.g. next hour), the time after, and
+       so on until all the nodes are filled */
+    while (fillNextNode(ctx)) {
+        ;
+    }
+}
+
+
+
+LOCAL bool fillNextNode(Skyfast_Context *ctx)
+/* Calculate the next node of the context, if the tracking thread has finished
+   with the element of the node array that it occupies.
+ Returns
+    true if a node was calculated, false if there was no free node
+ In/Out
+    ctx - the context
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    long    k;
+    long    w;
+    double  t_cy;
+    double  spacing_cy;
+    double  err_rad;
+    double  growMargin;
+    Sky_TrueEquatorial mid;
+
+    startCriticalSection(ctx);
+    k = loadIndex(&ctx->lastIndex);
+    endCriticalSection(ctx);
+    w = loadIndex(&ctx->writeIndex);
+
+    /* The tracking thread may still be using nodes k - 1, k and k + 1 */
+    if (w - (k - 1) >= ctx->nodeCount) {
+        return false;
+    }
+
+    t_cy = nodeAt(ctx, w - 1)->timestamp_cy;
+    spacing_cy = ctx->spacing_cy;
+    calculate(ctx, t_cy + spacing_cy, nodeAt(ctx, w));
+
+    if (ctx->tolerance_rad > 0.0) {
+        /* Halve the spacing until the error halfway between this node and the
+           one before is within the tolerance, then increase it by a quarter
+           for the next node if there is enough margin. (The interpolation
+           error is roughly proportional to the square of the spacing for
+           linear interpolation, and to the cube for quadratic, so a quarter
+           more spacing means about 1.6 or 2 times the error.) */
+        growMargin = (ctx->interpolation == SKYFAST_QUADRATIC) ? 3.0 : 2.0;
+        err_rad = midpointError_rad(ctx, w, &mid);
+        while ((err_rad > ctx->tolerance_rad)
+               && (spacing_cy > MIN_SPACING_mins / (1440.0 * JUL_CENT))) {
+            /* The midpoint position becomes the new node */
+            spacing_cy *= 0.5;
+            *nodeAt(ctx, w) = mid;
+            err_rad = midpointError_rad(ctx, w, &mid);
+        }
+        if ((err_rad < ctx->tolerance_rad / growMargin)
+            && (spacing_cy < MAX_SPACING_mins / (1440.0 * JUL_CENT))) {
+            spacing_cy *= 1.25;
+        }
+        ctx->spacing_cy = spacing_cy;
+    }
+
+    startCriticalSection(ctx);
+    storeIndex(&ctx->writeIndex, w + 1);
+    endCriticalSection(ctx);
+    return true;
+}
+
+
+
+LOCAL void interpolate(Skyfast_Interpolation    method,
+                       const Sky_TrueEquatorial *p0,
+                       const Sky_TrueEquatorial *p1,
+                       const Sky_TrueEquatorial *p2,
+                       double                   t_cy,
+                       Sky_TrueEquatorial       *approx)
+/* Interpolate between nodes p1 and p2 (also using p0 for quadratic
+   interpolation).
+ Inputs
+    method - SKYFAST_LINEAR or SKYFAST_QUADRATIC
+    p0     - the node before p1 (not used for linear interpolation)
+    p1, p2 - the nodes either side of time t_cy
+    t_cy   - Julian centuries since J2000.0, TT timescale
+ Outputs
+    approx - the interpolated position
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double a;
+    double b;
+    double c;
+    double mag;
+    int    i;
+
+    if (method == SKYFAST_QUADRATIC) {
+        /* Three-point Lagrange interpolation through prev, last and next. The
+           coefficients a, b and c are the Lagrange basis polynomials for the
+           three nodes, evaluated at time t_cy. */
+        a = ((t_cy - p1->timestamp_cy) * (t_cy - p2->timestamp_cy))
+            / ((p0->timestamp_cy - p1->timestamp_cy)
+               * (p0->timestamp_cy - p2->timestamp_cy));
+        b = ((t_cy - p0->timestamp_cy) * (t_cy - p2->timestamp_cy))
+            / ((p1->timestamp_cy - p0->timestamp_cy)
+               * (p1->timestamp_cy - p2->timestamp_cy));
+        c = ((t_cy - p0->timestamp_cy) * (t_cy - p1->timestamp_cy))
+            / ((p2->timestamp_cy - p0->timestamp_cy)
+               * (p2->timestamp_cy - p1->timestamp_cy));
+        for (i = 0; i < 3; i++) {
+            approx->appCirsV.a[i] = a * p0->appCirsV.a[i]
+                                    + b * p1->appCirsV.a[i]
+                                    + c * p2->appCirsV.a[i];
+        }
+        approx->distance_au = a * p0->distance_au + b * p1->distance_au
+                              + c * p2->distance_au;
+        approx->eqEq_rad = a * p0->eqEq_rad + b * p1->eqEq_rad
+                           + c * p2->eqEq_rad;
+
+        /* The interpolated vector is very close to unit magnitude, but not
+           exactly. Make it so. */
+        mag = sqrt(approx->appCirsV.a[0] * approx->appCirsV.a[0]
+                   + approx->appCirsV.a[1] * approx->appCirsV.a[1]
+                   + approx->appCirsV.a[2] * approx->appCirsV.a[2]);
+        for (i = 0; i < 3; i++) {
+            approx->appCirsV.a[i] /= mag;
+        }
+        return;
+    }
+
+    if ((p2->timestamp_cy - p1->timestamp_cy) < SFA) {
         a = 0.0;
         b = 1.0;
     } else {
-        a = (t_cy - last->timestamp_cy)
-            / (next->timestamp_cy - last->timestamp_cy);
+        a = (t_cy - p1->timestamp_cy) / (p2->timestamp_cy - p1->timestamp_cy);
         b = 1.0 - a;
     }
     /* Do a simple linear interpolation between the two appCirsV position
@@ -294,41 +1035,218 @@ GLOBAL void skyfast_getApprox(double t_cy,
      * vectors are less than one degree apart, the resulting position error is
      * very small (< 0.3′). If the two appCirsV are a few arcminutes
      * apart, the magnitude error of the resulting vector is negligible.  */
-    approx->appCirsV.a[0] =  a * next->appCirsV.a[0] + b * last->appCirsV.a[0];
-    approx->appCirsV.a[1] =  a * next->appCirsV.a[1] + b * last->appCirsV.a[1];
-    approx->appCirsV.a[2] =  a * next->appCirsV.a[2] + b * last->appCirsV.a[2];
+    approx->appCirsV.a[0] =  a * p2->appCirsV.a[0] + b * p1->appCirsV.a[0];
+    approx->appCirsV.a[1] =  a * p2->appCirsV.a[1] + b * p1->appCirsV.a[1];
+    approx->appCirsV.a[2] =  a * p2->appCirsV.a[2] + b * p1->appCirsV.a[2];
     /* And a linear interpolation of the other two quantities also. */
-    approx->distance_au = a * next->distance_au + b * last->distance_au;
-    approx->eqEq_rad    = a * next->eqEq_rad + b * last->eqEq_rad;
+    approx->distance_au = a * p2->distance_au + b * p1->distance_au;
+    approx->eqEq_rad    = a * p2->eqEq_rad + b * p1->eqEq_rad;
 }
 
 
-/*
- *------------------------------------------------------------------------------
- *
- * Local functions (not called from other modules)
- *
- *------------------------------------------------------------------------------
- */
+
+LOCAL double midpointError_rad(const Skyfast_Context *ctx,
+                               long w,
+                               Sky_TrueEquatorial *mid)
+/* Estimate the interpolation error between node w - 1 and node w, by doing a
+   full calculation halfway between them and comparing it with the
+   interpolated position there.
+ Returns
+    The angle between the two positions (radians)
+ Inputs
+    ctx - the context
+    w   - number of the node just calculated. Nodes w - 1 and (for quadratic
+          interpolation) w - 2 must also be available.
+ Outputs
+    mid - the fully calculated position halfway between the two nodes
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    const Sky_TrueEquatorial *p0, *p1, *p2;
+    Sky_TrueEquatorial  approx;
+    double              t_cy;
+    double              err_rad;
+
+    p0 = &ctx->node[(w - 2) % ctx->nodeCount];
+    p1 = &ctx->node[(w - 1) % ctx->nodeCount];
+    p2 = &ctx->node[w % ctx->nodeCount];
+    t_cy = 0.5 * (p1->timestamp_cy + p2->timestamp_cy);
+
+    calculate(ctx, t_cy, mid);
+    interpolate(ctx->interpolation, p0, p1, p2, t_cy, &approx);
+    err_rad = angleBetween_rad(&mid->appCirsV, &approx.appCirsV);
+
+    /* The midpoint only shows the part of the linear interpolation error that
+       is due to the object's acceleration, which is zero at times. The part
+       due to the rate of change of acceleration, which peaks at other points
+       in the interval, is about as big as the quadratic interpolation error at
+       the midpoint. So add that too (when node w - 2 exists). */
+    if ((ctx->interpolation == SKYFAST_LINEAR) && (w >= 3)) {
+        interpolate(SKYFAST_QUADRATIC, p0, p1, p2, t_cy, &approx);
+        err_rad += angleBetween_rad(&mid->appCirsV, &approx.appCirsV);
+    }
+    return err_rad;
+}
+
+
+
+LOCAL void initReplay(Skyfast_Replay     *replay,
+                      double             tStartUtc_d,
+                      int                fullRecalcInterval_mins,
+                      Skyfast_Interpolation interpolation,
+                      int                slotCount,
+                      Skyfast_ReplayNode slots[],
+                      const Sky_DeltaTs  *deltas)
+/* Set up a replay whose callback has already been stored. Marks all the slots
+   as empty.
+ Inputs
+    tStartUtc_d, fullRecalcInterval_mins, interpolation, slotCount, deltas
+        - as for skyfast_replayInit()
+ In/Out
+    replay - the replay state
+ Outputs
+    slots  - the slots, all marked empty
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    Sky_Times   atime;              // time, in various timescales
+    int         i;
+
+    REQUIRE_NOT_NULL(slots);
+    REQUIRE_NOT_NULL(deltas);
+    REQUIRE(fullRecalcInterval_mins > 0);
+    REQUIRE(slotCount >= 3);
+
+    sky_updateTimes(tStartUtc_d, deltas, &atime);
+
+    replay->slot = slots;
+    replay->slotCount = slotCount;
+    replay->origin_cy = atime.j2kTT_cy;
+    replay->interval_cy = fullRecalcInterval_mins / (1440.0 * JUL_CENT);
+    replay->interpolation = interpolation;
+    replay->calculationCount = 0;
+    for (i = 0; i < slotCount; i++) {
+        slots[i].number = LONG_MIN;
+    }
+}
+
+
+
+LOCAL const Sky_TrueEquatorial *replayNode(Skyfast_Replay *replay, long n)
+/* Returns the position at node number n, calculating it first if it is not
+   already held in its slot.
+ Inputs
+    n      - node number (may be negative)
+ In/Out
+    replay - the replay state
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    Skyfast_ReplayNode  *s;
+    double              t_cy;
+    long                i;
+
+    i = n % replay->slotCount;
+    if (i < 0) {
+        i += replay->slotCount;
+    }
+    s = &replay->slot[i];
+
+    if (s->number != n) {
+        t_cy = replay->origin_cy + (double)n * replay->interval_cy;
+        if (replay->callbackOf != NULL) {
+            replay->callbackOf(replay->object, t_cy, &s->pos);
+        } else {
+            replay->callback(t_cy, &s->pos);
+        }
+        s->number = n;
+        replay->calculationCount++;
+    }
+    return &s->pos;
+}
+
+
+
+LOCAL double angleBetween_rad(const V3D_Vector *aV, const V3D_Vector *bV)
+/* Returns the angle between two vectors (radians). As the linearly
+   interpolated vector is not of unit magnitude, this uses both the cross and
+   dot products.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    V3D_Vector  crossV;
+
+    v3d_crossProductV(&crossV, aV, bV);
+    return atan2(v3d_magV(&crossV), v3d_dotProductV(aV, bV));
+}
+
+
+
+LOCAL Sky_TrueEquatorial *nodeAt(Skyfast_Context *ctx, long n)
+/* Returns the element of the context's node array that holds node number n
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    return &ctx->node[n % ctx->nodeCount];
+}
+
+
+
+LOCAL void calculate(const Skyfast_Context *ctx,
+                     double t_cy,
+                     Sky_TrueEquatorial *pos)
+/* Call whichever function was supplied to calculate the context's object.
+ Inputs
+    ctx   - the context
+    t_cy  - Julian centuries since J2000.0, TT timescale
+ Outputs
+    pos   - the object's apparent position
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    if (ctx->callbackOf != NULL) {
+        ctx->callbackOf(ctx->object, t_cy, pos);
+    } else {
+        ctx->callback(t_cy, pos);
+    }
+}
+
+
+#ifdef POSIX_THREADS
+LOCAL void *workerThread(void *arg)
+/* The thread started by skyfast_ctxStartWorker(). Keeps the context's nodes
+   filled in until told to stop.
+ Inputs
+    arg - the context
+ Returns
+    NULL
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    Skyfast_Context *ctx = arg;
+    const struct timespec pause = { 0, WORKER_PAUSE_ns };
+
+    while (!atomic_load_explicit(&ctx->workerStop, memory_order_acquire)) {
+        if (!fillNextNode(ctx)) {
+            (void)nanosleep(&pause, NULL);
+        }
+    }
+    return NULL;
+}
+#endif
 
 /*- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
-/*! \page page-skyfast-c Edits you may want to make to skyfast.c
+/*! \page page-skyfast-c Edits you may want to make to skyfast.h
  *
  *  There are four different ways that you might want to use the skyfast
  *  module. It can be configured to run in two threads or one. To
- *  control this, define one or none of the following three macros. (Don't
- *  define more than one.) They are BARE_METAL_THREADS, POSIX_THREADS or
- *  NO_THREADS.
- *
+ *  control this, define one or none of the following three macros in
+ *  skyfast.h. (Don't define more than one.) They are BARE_METAL_THREADS,
+ *  POSIX_THREADS or NO_THREADS.
  *  The four different approaches are:
  *      1. The simplest approach is to define NO_THREADS (or not to define any
  *          macro at all), and not to call the skyfast_backgroundUpdate()
  *          routine at all. The limitation is that you will only be able to
  *          track your object for a period that is twice as long as the number
  *          that you pass to the \a fullRecalcInterval_mins parameter of routine
- *          skyfast_init(), in minutes. If you try to track longer than this,
- *          the program will abort.
+ *          skyfast_init(), in minutes. If you track longer than this,
+ *          skyfast_getApprox() does a full calculation on every call, which
+ *          is as slow as not using this module at all. (The number of times
+ *          this happens is returned by skyfast_ctxFallbackCount().)
  *      2. The next simplest is once again to define NO_THREADS (or not to
  *          define any macro at all), and to put calls to
  *          skyfast_backgroundUpdate() in the same loop as your calls to
@@ -355,7 +1273,37 @@ GLOBAL void skyfast_getApprox(double t_cy,
  *      4. The fourth approach is basically the same as the third, but it
  *          enables implementation on processors running a POSIX-compliant
  *          operating system (such as Linux). You will need to define the
- *          POSIX_THREADS macro, and then create the posix
- *          threads yourself; this macro simply causes this module to use the
- *          pthreads Mutex mechanism to control access to shared data.
+ *          POSIX_THREADS macro, and then either create the posix
+ *          threads yourself, or call skyfast_ctxStartWorker() to have this
+ *          module start a low priority thread of its own to do the background
+ *          calculations (and skyfast_ctxStopWorker() to stop it). This macro
+ *          causes this module to hand the precalculated data between the two
+ *          threads using C11 atomic operations (so a C11 compiler is
+ *          required for skyfast.c), instead of a lock. C++ code may still
+ *          include skyfast.h, which then uses the equivalent std::atomic
+ *          types.
+ *          skyfast_getApprox() never blocks waiting for the background
+ *          thread, nor makes a system call.
+ *
+ *  Whichever approach you use, you can track several objects at once by
+ *  giving each one its own Skyfast_Context (see skyfast_ctxInit()). Each
+ *  context hands over its own data independently of the others.
+ *
+ *  A context holds a ring of fully calculated positions, the number of which
+ *  is set by the \a nodeCount parameter of skyfast_ctxInit(). With the
+ *  default of SKYFAST_DEFAULT_NODES (4), the background calculations must be
+ *  done within one interval of the tracking thread moving on. A larger ring
+ *  lets the background thread work further ahead, so that it can be held up
+ *  for several intervals (by other work at higher priority, say) without
+ *  skyfast_ctxGetApprox() ever finding the next position missing. If it does
+ *  find it missing, it does the full calculation itself rather than fail.
+ *
+ *  The skyfast_ctx... functions only go forward in time. To replay a recorded
+ *  session, possibly faster than real time, and to scrub backwards and
+ *  forwards through it, use skyfast_replayInit() and skyfast_replayGetApprox()
+ *  instead. These keep evenly spaced nodes in a cache of whatever size you
+ *  provide, calculating each node the first time it is needed. Replaying a
+ *  stretch of the session again does no further full calculations, as long as
+ *  the stretch spans no more nodes than the cache holds. The replay functions
+ *  do all their calculations in the calling thread.
  */
@@ -48,6 +48,128 @@
 /*
  * Global #defines and typedefs
  */
+/*      --- Definitions that you may need to or wish to modify --- */
+/*      Define one (or none) of these. See \ref page-skyfast-c */
+//#define BARE_METAL_THREADS
+//#define POSIX_THREADS
+//#define NO_THREADS
+#ifdef POSIX_THREADS
+#include <pthread.h>
+#ifdef __cplusplus
+#include <atomic>
+#else
+#include <stdatomic.h>
+#endif
+#endif
+
+/*! Interpolation methods available to skyfast_ctxInit() and
+    skyfast_ctxInitObject(). See \ref page-interpolation */
+typedef enum {
+    SKYFAST_LINEAR,     /*!< Linear interpolation between the two positions
+                         *   either side of the requested time */
+    SKYFAST_QUADRATIC   /*!< Quadratic (3-point Lagrange) interpolation using
+                         *   also the position before those two, followed by
+                         *   renormalisation of the position vector */
+} Skyfast_Interpolation;
+
+/*      Largest number of fully calculated positions that a context can hold */
+#define SKYFAST_MAX_NODES   32
+
+/*      Number of positions held by the context used by skyfast_init() */
+#define SKYFAST_DEFAULT_NODES 4
+
+/*      Sequence numbers of the positions, shared between the tracking thread
+        and the background thread, and the flag that stops the worker thread.
+        C++ cannot include <stdatomic.h>, so it sees the std::atomic types,
+        which have the same size and representation as the C11 ones */
+#ifdef POSIX_THREADS
+#ifdef __cplusplus
+typedef std::atomic<long> Skyfast_Index;
+typedef std::atomic<bool> Skyfast_Flag;
+#else
+typedef atomic_long   Skyfast_Index;
+typedef atomic_bool   Skyfast_Flag;
+#endif
+#else
+typedef volatile long Skyfast_Index;
+#endif
+
+/*! Interpolation state for tracking one celestial object. Set up by
+    skyfast_ctxInit() or skyfast_ctxInitObject(). The caller provides the
+    storage, but should treat the contents as private to the skyfast
+    functions.
+
+    The fully calculated positions (nodes) are numbered in time order, and
+    node number n is held in element n % nodeCount of array \a node. The
+    tracking thread interpolates between node \a lastIndex and the one after
+    it (also using the one before it, for quadratic interpolation). The
+    background calculations fill in the nodes after those, up to the limit of
+    the array. */
+typedef struct {
+    Sky_TrueEquatorial  node[SKYFAST_MAX_NODES]; //!< Fully calculated positions
+    int                 nodeCount;  //!< Number of elements of node[] in use
+    Skyfast_Index       lastIndex;  /*!< Node at or before the time most
+                                         recently requested (tracking thread
+                                         writes, background thread reads) */
+    Skyfast_Index       writeIndex; /*!< Number of the next node to be
+                                         calculated (background thread writes,
+                                         tracking thread reads) */
+    Skyfast_Index       fallbackCount; /*!< Number of times that
+                                         skyfast_ctxGetApprox() found the next
+                                         node not yet calculated, and did a
+                                         full calculation instead */
+    double              recalcInterval_cy; /*!< Time between full
+                                                recalculations (centuries) */
+    double              spacing_cy; /*!< Time between the next two nodes to be
+                                         calculated (centuries). Equal to
+                                         \a recalcInterval_cy unless a
+                                         tolerance has been set */
+    double              tolerance_rad; /*!< Largest interpolation error
+                                            allowed, or zero for fixed spacing
+                                            (see skyfast_ctxSetTolerance()) */
+    Skyfast_Interpolation interpolation; //!< Interpolation method
+    /*! Function to calculate the object's position (or NULL) */
+    void (*callback)(double j2kTT_cy, Sky_TrueEquatorial *pos);
+    /*! Function to calculate the position of \a object (or NULL) */
+    void (*callbackOf)(const void *object,
+                       double j2kTT_cy,
+                       Sky_TrueEquatorial *pos);
+    const void          *object;    //!< Object passed to callbackOf
+#ifdef POSIX_THREADS
+    pthread_t           worker;     //!< Thread started by skyfast_ctxStartWorker()
+    Skyfast_Flag        workerStop; //!< Tells the worker thread to stop
+    bool                workerRunning; //!< Worker thread has been started
+#endif
+} Skyfast_Context;
+
+/*! One slot of the cache used by a Skyfast_Replay. */
+typedef struct {
+    long                number;     //!< Number of the node held, or LONG_MIN
+    Sky_TrueEquatorial  pos;        //!< Fully calculated position
+} Skyfast_ReplayNode;
+
+/*! Interpolation state for replaying a recorded session, in which the
+    requested times may jump about or go backwards. Set up by
+    skyfast_replayInit() or skyfast_replayInitObject(). The nodes are evenly
+    spaced, so the node either side of any time is found directly, and each
+    node is kept in the slot given by its number modulo \a slotCount until it
+    is displaced by another. Unlike Skyfast_Context, this is not designed to
+    be shared between threads. */
+typedef struct {
+    Skyfast_ReplayNode  *slot;      //!< Cache of nodes (caller's storage)
+    int                 slotCount;  //!< Number of elements of slot[]
+    double              origin_cy;  //!< Time of node number 0 (TT, centuries)
+    double              interval_cy; //!< Time between nodes (centuries)
+    Skyfast_Interpolation interpolation; //!< Interpolation method
+    /*! Function to calculate the object's position (or NULL) */
+    void (*callback)(double j2kTT_cy, Sky_TrueEquatorial *pos);
+    /*! Function to calculate the position of \a object (or NULL) */
+    void (*callbackOf)(const void *object,
+                       double j2kTT_cy,
+                       Sky_TrueEquatorial *pos);
+    const void          *object;    //!< Object passed to callbackOf
+    long                calculationCount; //!< Full calculations done so far
+} Skyfast_Replay;
 
 
 #ifdef __cplusplus
@@ -63,6 +185,68 @@ void skyfast_init(double            tStartUtc_d,
                   );
 void skyfast_backgroundUpdate(void);
 void skyfast_getApprox(double t_cy, Sky_TrueEquatorial *approx);
+void skyfast_setTolerance(double tolerance_as);
+
+/*      The same, for any number of objects, each with its own context */
+void skyfast_ctxInit(Skyfast_Context   *ctx,
+                     double            tStartUtc_d,
+                     int               fullRecalcInterval_mins,
+                     Skyfast_Interpolation interpolation,
+                     int               nodeCount,
+                     const Sky_DeltaTs *deltas,
+                     void (*getApparent)(double j2kTT_cy,
+                                         Sky_TrueEquatorial *pos)
+                     );
+void skyfast_ctxInitObject(Skyfast_Context   *ctx,
+                           double            tStartUtc_d,
+                           int               fullRecalcInterval_mins,
+                           Skyfast_Interpolation interpolation,
+                           int               nodeCount,
+                           const Sky_DeltaTs *deltas,
+                           void (*getApparentOf)(const void *object,
+                                                 double j2kTT_cy,
+                                                 Sky_TrueEquatorial *pos),
+                           const void        *object);
+void skyfast_ctxSetTolerance(Skyfast_Context *ctx, double tolerance_as);
+void skyfast_ctxBackgroundUpdate(Skyfast_Context *ctx);
+void skyfast_ctxGetApprox(Skyfast_Context *ctx,
+                          double t_cy,
+                          Sky_TrueEquatorial *approx);
+long skyfast_ctxFallbackCount(const Skyfast_Context *ctx);
+
+/*      Random access to a window of evenly spaced nodes, for replay */
+void skyfast_replayInit(Skyfast_Replay     *replay,
+                        double             tStartUtc_d,
+                        int                fullRecalcInterval_mins,
+                        Skyfast_Interpolation interpolation,
+                        int                slotCount,
+                        Skyfast_ReplayNode slots[],
+                        const Sky_DeltaTs  *deltas,
+                        void (*getApparent)(double j2kTT_cy,
+                                            Sky_TrueEquatorial *pos)
+                        );
+void skyfast_replayInitObject(Skyfast_Replay     *replay,
+                              double             tStartUtc_d,
+                              int                fullRecalcInterval_mins,
+                              Skyfast_Interpolation interpolation,
+                              int                slotCount,
+                              Skyfast_ReplayNode slots[],
+                              const Sky_DeltaTs  *deltas,
+                              void (*getApparentOf)(const void *object,
+                                                    double j2kTT_cy,
+                                                    Sky_TrueEquatorial *pos),
+                              const void         *object);
+void skyfast_replayPreload(Skyfast_Replay *replay,
+                           double         tFrom_cy,
+                           double         tTo_cy);
+void skyfast_replayGetApprox(Skyfast_Replay *replay,
+                             double t_cy,
+                             Sky_TrueEquatorial *approx);
+
+#ifdef POSIX_THREADS
+int skyfast_ctxStartWorker(Skyfast_Context *ctx);
+void skyfast_ctxStopWorker(Skyfast_Context *ctx);
+#endif
 
 /*
  * Global variables accessible by other modules
@@ -124,6 +308,66 @@ void skyfast_getApprox(double t_cy, Sky_TrueEquatorial *approx);
  *
  *  In all cases, the error appears to approximately quadruple for every
  *  doubling of the interpolation interval.
+ *
+ *  ###Quadratic interpolation
+ *  The table above is for linear interpolation, which is what skyfast_init()
+ *  uses. Functions skyfast_ctxInit() and skyfast_ctxInitObject() also offer
+ *  quadratic interpolation (SKYFAST_QUADRATIC), which fits a parabola through
+ *  the three most recent fully calculated positions (the one before "last",
+ *  "last" and "next") and then rescales the resulting vector to unit
+ *  magnitude. It needs one extra full calculation at initialisation time, but
+ *  none afterwards, and each call to skyfast_ctxGetApprox() costs only a few
+ *  more multiplications and a square root. Its error grows with the cube of
+ *  the interval, rather than the square.
+ *
+ *  The following table compares the two methods. Errors here are the largest
+ *  difference in direction from a full calculation, sampled 37 times per
+ *  interval over 366 days (Sun) or 60 days (Moon) from the start of 2024.
+ *
+    Object |hours  |Linear |Quadratic
+    :------|------:|------:|--------:
+    Sun    |6      |0.018  |0.0013
+    Sun    |12     |0.072  |0.011
+    Sun    |18     |0.16   |0.035
+    Sun    |24     |0.29   |0.084
+    Sun    |36     |0.65   |0.28
+    -      |       |       |
+    Moon   |0.5    |0.094  |0.0026
+    Moon   |1      |0.38   |0.021
+    Moon   |1.5    |0.85   |0.070
+    Moon   |2      |1.5    |0.17
+    Moon   |3      |3.4    |0.56
+    Moon   |4      |6.0    |1.3
+
+ *  So for an error budget of 0.1 arcseconds, the longest usable interval is:
+ *      - for the Sun, about 17 hours with linear interpolation, or 25 hours
+ *        with quadratic interpolation
+ *      - for the Moon, about 30 minutes with linear interpolation, or 100
+ *        minutes with quadratic interpolation - i.e. less than a third as
+ *        many full calculations.
+ *
+ *  ###Adaptive intervals
+ *  If you call skyfast_ctxSetTolerance() (or skyfast_setTolerance()), the
+ *  module chooses the interval itself, checking each new interval with an
+ *  extra full calculation at its midpoint. The table below shows the full
+ *  calculations needed to track for 30 days (from 22 August 2024), and the
+ *  largest error found (sampled every 5 minutes), for a fixed interval chosen
+ *  from the tables above and for a tolerance of 0.1 arcseconds. The star is
+ *  Sirius.
+ *
+    Object |Method    |Fixed interval |Calculations |Adaptive calculations
+    :------|:---------|--------------:|------------:|--------------------:
+    Sun    |Linear    |17 h           |49 (0.14″)   |128 (0.086″)
+    Moon   |Linear    |30 min         |1446 (0.094″)|2381 (0.098″)
+    Moon   |Quadratic |100 min        |439 (0.098″) |882 (0.098″)
+    Star   |Linear    |1 h            |726 (0.000″) |91 (0.010″)
+
+ *  So where you already know a suitable interval (from the tables above),
+ *  the adaptive intervals cost up to twice as many full calculations,
+ *  because of the midpoint checks. Where you don't, they keep the error
+ *  within the tolerance without your having to work one out, and for slowly
+ *  moving objects such as stars they need far fewer calculations than a
+ *  cautious fixed interval. (The interval never exceeds one day.)
  */
 
 #endif /* SKYFAST_H */
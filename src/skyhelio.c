@@ -0,0 +1,368 @@
+/*==============================================================================
+ * skyhelio.c - aiming and cosine efficiency of a field of heliostats
+ *
+ * Author:  David Hoadley
+ *
+ * Description: (see skyhelio.h)
+ *
+ * Copyright (c) 2020, David Hoadley <vcrumble@westnet.com.au>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ *==============================================================================
+ */
+/*------------------------------------------------------------------------------
+ * Notes:
+ *      Character set: UTF-8. (Non-ASCII characters appear in this file)
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * Notes:
+ *      Character set: UTF-8. (Non-ASCII characters appear in this file)
+ *----------------------------------------------------------------------------*/
+
+/* ANSI includes etc. */
+#include "instead-of-math.h"
+
+/* Local and project includes */
+#include "skyhelio.h"
+
+#include "general.h"
+#include "sky0.h"
+
+/*
+ * Local #defines and typedefs
+ */
+DEFINE_THIS_FILE;                       // For use by REQUIRE() - assertions.
+
+/*
+ * Prototypes for local functions (not called from other modules)
+ */
+
+
+/*
+ * Global variables accessible by other modules
+ */
+
+
+/*
+ * Local variables (not accessed by other modules)
+ */
+
+
+/*
+ *==============================================================================
+ *
+ * Implementation
+ *
+ *==============================================================================
+ *
+ * Global functions callable by other modules
+ *
+ *------------------------------------------------------------------------------
+ */
+GLOBAL void skyhelio_setFieldStorage(int            count,
+                                     double         storage[],
+                                     SkyHelio_Field *field)
+/*! Set up a SkyHelio_Field to hold \a count heliostats in the array
+    \a storage, which you supply.
+ \param[in]  count    Number of heliostats
+ \param[in]  storage  Array of at least \a count x SKYHELIO_FIELD_DOUBLES
+                      elements. It must remain in existence for as long as
+                      \a field is in use.
+ \param[out] field    Structure of arrays, pointing into \a storage
+
+ \par When to call this function
+    At program initialisation time, before calling skyhelio_setHeliostat() for
+    each of the heliostats.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    int     c;
+
+    REQUIRE_NOT_NULL(storage);
+    REQUIRE_NOT_NULL(field);
+    REQUIRE(count > 0);
+
+    field->count = count;
+    for (c = 0; c < 3; c++) {
+        field->targetV[c] = &storage[c * count];
+    }
+}
+
+
+
+GLOBAL void skyhelio_setHeliostat(int            index,
+                                  double         east_m,
+                                  double         north_m,
+                                  double         height_m,
+                                  double         aimEast_m,
+                                  double         aimNorth_m,
+                                  double         aimHeight_m,
+                                  SkyHelio_Field *field)
+/*! Set the position of one heliostat, and of the point on the receiver at which
+    it is to aim.
+ \param[in]     index        Number of the heliostat within the field (0 to
+                             count - 1)
+ \param[in]     east_m       Distance of the heliostat's pivot point east of
+                             the origin of the field (metres)
+ \param[in]     north_m      Distance of the pivot point north of the origin
+                             (metres)
+ \param[in]     height_m     Height of the pivot point above the origin
+                             (metres)
+ \param[in]     aimEast_m    Distance of the aim point east of the origin
+                             (metres)
+ \param[in]     aimNorth_m   Distance of the aim point north of the origin
+                             (metres)
+ \param[in]     aimHeight_m  Height of the aim point above the origin (metres)
+ \param[in,out] field        Structure of arrays, as set up by
+                             skyhelio_setFieldStorage()
+
+ The origin is any convenient point of the field, such as the base of the
+ receiver tower. The field is assumed to be small enough (a few kilometres)
+ that the horizon planes of all its heliostats are parallel.
+
+ \par When to call this function
+    At program initialisation time, for each heliostat. Call it again if the
+    aim point of a heliostat changes.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    V3D_Vector  targetV;        // from heliostat to aim point (North,East,Zen)
+    double      mag;
+
+    REQUIRE_NOT_NULL(field);
+    REQUIRE((index >= 0) && (index < field->count));
+
+    targetV.a[0] = aimNorth_m - north_m;
+    targetV.a[1] = aimEast_m - east_m;
+    targetV.a[2] = aimHeight_m - height_m;
+    mag = v3d_magV(&targetV);
+    REQUIRE(mag > 0.0);
+
+    field->targetV[0][index] = targetV.a[0] / mag;
+    field->targetV[1][index] = targetV.a[1] / mag;
+    field->targetV[2][index] = targetV.a[2] / mag;
+}
+
+
+
+GLOBAL void skyhelio_aimBatch(const V3D_Vector     *sunTopoV,
+                              const SkyHelio_Field *field,
+                              double               cosEfficiency[],
+                              V3D_Vector           normalV[],
+                              double               azimuth_rad[],
+                              double               elevation_rad[])
+/*! Calculate, for every heliostat of a field, the normal its mirror must point
+    along to reflect the Sun onto its aim point, and the cosine efficiency.
+ \param[in]  sunTopoV       Topocentric unit vector of the Sun, as calculated
+                            by sky_siteTirsToTopo() (field \a rectV of its
+                            \a topo argument) or sky_siteTirsToTopoV()
+ \param[in]  field          The heliostats, as set up by
+                            skyhelio_setFieldStorage() and
+                            skyhelio_setHeliostat()
+ \param[out] cosEfficiency  Array of field->count elements, to receive the
+                            cosine of the angle of incidence of the Sun's rays
+                            on each mirror
+ \param[out] normalV        \b Optional. Array of field->count elements, to
+                            receive the unit normal of each mirror (North,
+                            East, Zenith). May be NULL.
+ \param[out] azimuth_rad    \b Optional. Array of field->count elements, to
+                            receive the azimuth of each mirror's normal
+                            (radian, range [-π, +π]). May be NULL.
+ \param[out] elevation_rad  \b Optional. Array of field->count elements, to
+                            receive the elevation of each mirror's normal
+                            (radian). May be NULL, but only if \a azimuth_rad
+                            is also NULL.
+
+ The normal bisects the angle between the Sun and the aim point, so the angle
+ of incidence θ is half the angle between them, and cos θ is half the length
+ of the sum of the two unit vectors. This is the value that
+ sky_siteIncidence_rad() would give for the normal, but is found without
+ calling acos() and cos(). The results are meaningless while the Sun is below
+ the horizon (sunTopoV->a[2] <= 0).
+
+ \par When to call this function
+    Each time around your main loop, after calculating the Sun's position. Pass
+    NULL for the optional outputs that you don't need; if you need only the
+    cosine efficiency, no trigonometric functions are called at all.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  sx, sy, sz;         // Sun's unit vector
+    double  nx, ny, nz;         // sum of Sun and target vectors
+    double  mag;
+    int     i;
+
+    REQUIRE_NOT_NULL(sunTopoV);
+    REQUIRE_NOT_NULL(field);
+    REQUIRE_NOT_NULL(cosEfficiency);
+    REQUIRE((azimuth_rad == NULL) || (elevation_rad != NULL));
+
+    sx = sunTopoV->a[0];
+    sy = sunTopoV->a[1];
+    sz = sunTopoV->a[2];
+
+    for (i = 0; i < field->count; i++) {
+        nx = sx + field->targetV[0][i];
+        ny = sy + field->targetV[1][i];
+        nz = sz + field->targetV[2][i];
+        mag = sqrt(nx * nx + ny * ny + nz * nz);
+        cosEfficiency[i] = 0.5 * mag;
+        if (normalV != NULL) {
+            if (mag > 0.0) {
+                normalV[i].a[0] = nx / mag;
+                normalV[i].a[1] = ny / mag;
+                normalV[i].a[2] = nz / mag;
+            } else {
+                /* Sun directly behind the aim point. Any normal will do */
+                normalV[i].a[0] = 0.0;
+                normalV[i].a[1] = 0.0;
+                normalV[i].a[2] = 1.0;
+            }
+        }
+        if (azimuth_rad != NULL) {
+            /* atan2() needs no normalisation */
+            azimuth_rad[i] = atan2(ny, nx);
+            elevation_rad[i] = atan2(nz, sqrt(nx * nx + ny * ny));
+        }
+    }
+}
+
+
+
+GLOBAL int skyhelio_integrate(const SkyHelio_Field    *field,
+                              const SkyCheb_Ephemeris *sunEph,
+                              const Sky_DeltaTs       *deltas,
+                              const Sky_SiteProp      *site,
+                              double                  startUtc_d,
+                              double                  step_d,
+                              int                     stepCount,
+                              double                  sumCosEfficiency[])
+/*! Sum the cosine efficiency of every heliostat of a field over a number of
+    equally spaced times, for example every 5 minutes for a year, taking the
+    Sun's position from a Chebyshev ephemeris.
+ \returns                     The number of times at which the Sun was above
+                              the horizon. (Dividing each sum by this gives the
+                              mean cosine efficiency while the Sun is up.)
+ \param[in]  field            The heliostats, as set up by
+                              skyhelio_setFieldStorage() and
+                              skyhelio_setHeliostat()
+ \param[in]  sunEph           Chebyshev ephemeris of the Sun's apparent
+                              position, as set up by skycheb_fitApparent() (with
+                              sun_nrelApparent()) or skyeph_getEphemeris(). It
+                              must cover all of the times.
+ \param[in]  deltas           Delta T values, as set up by sky_initTime() (or
+                              its variants)
+ \param[in]  site             Properties of the site of the field, as set up by
+                              sky_setSiteLocation() and sky_setSiteTempPress()
+ \param[in]  startUtc_d       First time (days since J2000.0, UTC)
+ \param[in]  step_d           Interval between times (days)
+ \param[in]  stepCount        Number of times
+ \param[out] sumCosEfficiency Array of field->count elements, to receive the
+                              sum, for each heliostat, of its cosine efficiency
+                              at the times when the Sun was above the horizon
+
+ \par When to call this function
+    When evaluating the layout of a field. If you need to weight each time
+    differently (e.g. by the direct normal irradiance), step through the times
+    yourself and call skyhelio_aimBatch() for each.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    Sky_Times           atime;      // time, in various timescales
+    Sky_TrueEquatorial  pos;        // apparent position of the Sun
+    V3D_Vector          terInterV;  // Sun in Terrestrial Intermediate Ref Sys
+    V3D_Vector          sunTopoV;   // Sun in horizon coordinates
+    double              sx, sy, sz;
+    double              nx, ny, nz;
+    int                 sunUpCount;
+    int                 step;
+    int                 i;
+
+    REQUIRE_NOT_NULL(field);
+    REQUIRE_NOT_NULL(sunEph);
+    REQUIRE_NOT_NULL(deltas);
+    REQUIRE_NOT_NULL(site);
+    REQUIRE_NOT_NULL(sumCosEfficiency);
+    REQUIRE(stepCount >= 0);
+
+    for (i = 0; i < field->count; i++) {
+        sumCosEfficiency[i] = 0.0;
+    }
+
+    sunUpCount = 0;
+    for (step = 0; step < stepCount; step++) {
+        sky_updateTimes(startUtc_d + step * step_d, deltas, &atime);
+        skycheb_getApprox(sunEph, atime.j2kTT_cy, &pos);
+        sky0_appToTirs(&pos.appCirsV, atime.j2kUT1_d, pos.eqEq_rad, &terInterV);
+        sky_siteTirsToTopoV(&terInterV, pos.distance_au, site, &sunTopoV);
+        if (sunTopoV.a[2] <= 0.0) {
+            continue;                   // Sun is down
+        }
+        sunUpCount++;
+
+        /* As for skyhelio_aimBatch(), but accumulating only the efficiency */
+        sx = sunTopoV.a[0];
+        sy = sunTopoV.a[1];
+        sz = sunTopoV.a[2];
+        for (i = 0; i < field->count; i++) {
+            nx = sx + field->targetV[0][i];
+            ny = sy + field->targetV[1][i];
+            nz = sz + field->targetV[2][i];
+            sumCosEfficiency[i] += 0.5 * sqrt(nx * nx + ny * ny + nz * nz);
+        }
+    }
+    return sunUpCount;
+}
+
+/*- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+/*! \page page-heliostat Heliostat fields
+ *  A heliostat reflects the Sun onto a fixed target, so the normal to its
+ *  mirror must bisect the angle between the direction of the Sun (unit vector
+ *  s) and the direction of the target (unit vector t):
+ *
+ *      n = (s + t) / |s + t|
+ *
+ *  The angle of incidence θ of the Sun's rays on the mirror is half the angle
+ *  between s and t, and the cosine efficiency - the fraction of the mirror's
+ *  area presented to the Sun - is cos θ = |s + t| / 2. It is the largest
+ *  single loss of a heliostat field, and the one that depends most on the
+ *  layout: heliostats on the side of the tower away from the Sun (the north
+ *  side, in the northern hemisphere) do best.
+ *
+ *  The vectors t depend only on the layout, so skyhelio_setHeliostat()
+ *  calculates them once. The vector s is the same for the whole field, so
+ *  each heliostat costs skyhelio_aimBatch() only three additions and a square
+ *  root, plus a division for the normal and two atan2() calls if the drive
+ *  angles are wanted. The vectors are held as a structure of arrays, as for
+ *  sky_siteTirsToTopoBatch(), so that the loop can be vectorised by the
+ *  compiler.
+ *
+ *  skyhelio_integrate() takes the Sun's position from a Chebyshev ephemeris
+ *  (see \ref page-chebyshev), so each time step costs about a microsecond for
+ *  the Sun's position, plus the work for the heliostats. A year at 5-minute
+ *  steps (105 120 times) for a field of 10 000 heliostats therefore needs
+ *  about 5 × 10^8 heliostat evaluations, which takes a second or two on a
+ *  modern desktop processor.
+ *
+ *  These routines do not consider shading or blocking by neighbouring
+ *  heliostats, atmospheric attenuation, or spillage at the receiver.
+ */
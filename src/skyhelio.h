@@ -0,0 +1,117 @@
+#ifndef SKYHELIO_H
+#define SKYHELIO_H
+/*============================================================================*/
+/*! \file
+ * \brief
+ * skyhelio.h - aiming and cosine efficiency of a field of heliostats
+ *
+ * \author  David Hoadley
+ *
+ * \details
+ *          Routines to find, for each heliostat of a field, the direction its
+ *          mirror's normal must point in to reflect the Sun onto a receiver,
+ *          the drive angles (azimuth and elevation) of that normal, and the
+ *          cosine efficiency - the cosine of the angle of incidence of the
+ *          Sun's rays on the mirror.
+ *
+ *          The unit vectors from the heliostats to the aim point are set up
+ *          once, in a "structure of arrays" (like Sky_SiteBatch) in storage
+ *          supplied by the caller. Then, each time around the main loop, one
+ *          topocentric Sun vector (from sky_siteTirsToTopo() or
+ *          sky_siteTirsToTopoV()) is used for the whole field by
+ *          skyhelio_aimBatch(). For field layout studies, skyhelio_integrate()
+ *          sums the cosine efficiency of every heliostat over many time steps,
+ *          taking the Sun's position from a Chebyshev ephemeris (see
+ *          skycheb.h). See \ref page-heliostat (at the end of skyhelio.c).
+ *
+ *==============================================================================
+ */
+/*
+ * Copyright (c) 2020, David Hoadley <vcrumble@westnet.com.au>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "sky.h"
+#include "skycheb.h"
+
+/*
+ * Global #defines and typedefs
+ */
+/*!     Number of doubles of storage needed per heliostat by
+        skyhelio_setFieldStorage() */
+#define SKYHELIO_FIELD_DOUBLES 3
+
+/*!     The heliostats of a field, arranged as one array per component of the
+        unit vector from each heliostat to its aim point (a "structure of
+        arrays"). The arrays are in storage that you supply to
+        skyhelio_setFieldStorage(), and you set up each heliostat by calling
+        skyhelio_setHeliostat(). */
+typedef struct {
+    int     count;              //!< Number of heliostats
+    double  *targetV[3];        /*!< Component [c] (North, East, Zenith) of
+                                     each heliostat's unit vector to its aim
+                                     point */
+} SkyHelio_Field;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Global functions available to be called by other modules
+ */
+void skyhelio_setFieldStorage(int            count,
+                              double         storage[],
+                              SkyHelio_Field *field);
+void skyhelio_setHeliostat(int            index,
+                           double         east_m,
+                           double         north_m,
+                           double         height_m,
+                           double         aimEast_m,
+                           double         aimNorth_m,
+                           double         aimHeight_m,
+                           SkyHelio_Field *field);
+void skyhelio_aimBatch(const V3D_Vector     *sunTopoV,
+                       const SkyHelio_Field *field,
+                       double               cosEfficiency[],
+                       V3D_Vector           normalV[],
+                       double               azimuth_rad[],
+                       double               elevation_rad[]);
+int skyhelio_integrate(const SkyHelio_Field    *field,
+                       const SkyCheb_Ephemeris *sunEph,
+                       const Sky_DeltaTs       *deltas,
+                       const Sky_SiteProp      *site,
+                       double                  startUtc_d,
+                       double                  step_d,
+                       int                     stepCount,
+                       double                  sumCosEfficiency[]);
+
+/*
+ * Global variables accessible by other modules
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SKYHELIO_H */
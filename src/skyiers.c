@@ -0,0 +1,636 @@
+/*==============================================================================
+ * skyiers.c - read Earth orientation parameters from IERS "finals" files
+ *
+ * Author:  David Hoadley
+ *
+ * Description: (see skyiers.h)
+ *
+ * Copyright (c) 2020, David Hoadley <vcrumble@westnet.com.au>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ *==============================================================================
+ */
+/*------------------------------------------------------------------------------
+ * Notes:
+ *      Character set: UTF-8. (Non-ASCII characters appear in this file)
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * Notes:
+ *      Character set: UTF-8. (Non-ASCII characters appear in this file)
+ *----------------------------------------------------------------------------*/
+
+/* ANSI includes etc. */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Local and project includes */
+#include "skyiers.h"
+
+#include "astron.h"
+#include "general.h"
+
+/*
+ * Local #defines and typedefs
+ */
+DEFINE_THIS_FILE;                       // For use by REQUIRE() - assertions.
+
+/*      Columns (numbered from 1) and widths of the fields used, in the Bulletin
+        A part of each line of a finals file */
+#define MJD_COLUMN              8
+#define MJD_WIDTH               8
+#define XPOLAR_COLUMN           19
+#define XPOLAR_WIDTH            9
+#define YPOLAR_COLUMN           38
+#define YPOLAR_WIDTH            9
+#define UT1UTC_COLUMN           59
+#define UT1UTC_WIDTH            10
+
+/*      MJD of 1900 January 1, the origin of the times in leap-seconds.list,
+        and the smallest of those times */
+#define MJD_1JAN1900            15020.0
+#define NTP_TIME_MIN            1.0e9
+
+/*      Result of parsing a line that has no values (e.g. beyond the end of the
+        predictions) */
+#define LINE_HAS_NO_DATA        (-1)
+
+/*      Results of getField() */
+typedef enum {
+    FIELD_OK,
+    FIELD_BLANK,
+    FIELD_BAD
+} FieldStatus;
+
+/*
+ * Prototypes for local functions (not called from other modules)
+ */
+LOCAL int parseLine(const char line[], int *mjd, SkyIers_Day *day);
+LOCAL int parseLeapLine(const char line[], double *mjd, int *deltaAT_s);
+LOCAL FieldStatus getField(const char line[],
+                           size_t     length,
+                           int        column,
+                           int        width,
+                           double     *value);
+
+
+/*
+ * Global variables accessible by other modules
+ */
+
+
+/*
+ * Local variables (not accessed by other modules)
+ */
+
+
+/*
+ *==============================================================================
+ *
+ * Implementation
+ *
+ *==============================================================================
+ *
+ * Global functions callable by other modules
+ *
+ *------------------------------------------------------------------------------
+ */
+GLOBAL int skyiers_load(const char    path[],
+                        int           capacity,
+                        SkyIers_Day   days[],
+                        SkyIers_Table *table,
+                        int           *errorLine)
+/*! Read the daily values of UT1 - UTC and polar motion from an IERS finals file
+    into a table.
+ \returns               SKYIERS_NORMAL, SKYIERS_OPENFAIL, SKYIERS_BADLINE,
+                        SKYIERS_TOOMANY or SKYIERS_NODATA (see SkyIers_Errors).
+                        After SKYIERS_TOOMANY, the table holds the first
+                        \a capacity days of the file, and may be used.
+ \param[in]  path       Name of the file: finals2000A.all, finals2000A.data or
+                        finals2000A.daily (or the equivalent finals.* files),
+                        as downloaded from the IERS
+ \param[in]  capacity   Number of elements in array \a days
+ \param[out] days       Array to receive the values, one element per day. It
+                        must remain in existence for as long as \a table is in
+                        use. (finals2000A.all, from 1973 to a year ahead, has
+                        about 20 000 days.)
+ \param[out] table      Description of the table of values
+ \param[out] errorLine  \b Optional. Number of the line (from 1) at which an
+                        error was found, or 0 if none. May be NULL.
+
+ Lines with no values for UT1 - UTC or polar motion (the lines for dates after
+ the end of the predictions) are skipped. The lines that are read must be for
+ consecutive days.
+
+ \par When to call this function
+    At program initialisation time. A program running continuously can call it
+    again (into a second array) after downloading a newer file, and then switch
+    to the new table.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    FILE        *fp;
+    char        line[SKYIERS_MAX_LINE];
+    SkyIers_Day spare;          // For lines beyond the capacity of days
+    int         mjd;
+    int         lineNum;
+    int         n;              // Number of days read so far
+    int         result;
+    int         status;
+
+    REQUIRE_NOT_NULL(path);
+    REQUIRE(capacity > 0);
+    REQUIRE_NOT_NULL(days);
+    REQUIRE_NOT_NULL(table);
+
+    table->firstMjd = SKYIERS_NO_DAY;
+    table->count = 0;
+    table->days = days;
+    if (errorLine != NULL) {
+        *errorLine = 0;
+    }
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        return SKYIERS_OPENFAIL;
+    }
+
+    status = SKYIERS_NORMAL;
+    n = 0;
+    lineNum = 0;
+    while ((status == SKYIERS_NORMAL)
+           && (fgets(line, (int)sizeof(line), fp) != NULL)) {
+        lineNum++;
+        if ((strchr(line, '\n') == NULL) && !feof(fp)) {
+            status = SKYIERS_BADLINE;           // Line too long
+        } else {
+            result = parseLine(line, &mjd, (n < capacity) ? &days[n] : &spare);
+            if (result == SKYIERS_NORMAL) {
+                if (n == 0) {
+                    table->firstMjd = mjd;
+                }
+                if (mjd != table->firstMjd + n) {
+                    status = SKYIERS_BADLINE;   // Not the next day
+                } else if (n >= capacity) {
+                    status = SKYIERS_TOOMANY;
+                } else {
+                    n++;
+                }
+            } else if (result != LINE_HAS_NO_DATA) {
+                status = result;
+            }
+        }
+    }
+    fclose(fp);
+
+    table->count = n;
+    if ((status == SKYIERS_NORMAL) && (n == 0)) {
+        status = SKYIERS_NODATA;
+    }
+    if ((status != SKYIERS_NORMAL) && (status != SKYIERS_NODATA)
+        && (errorLine != NULL)) {
+        *errorLine = lineNum;
+    }
+    return status;
+}
+
+
+
+GLOBAL int skyiers_lookup(const SkyIers_Table *table,
+                          double              mjdUtc,
+                          double              *ut1Utc_s,
+                          double              *xPolar_as,
+                          double              *yPolar_as)
+/*! Find UT1 - UTC and the polar motion at a given time, by linear interpolation
+    between the values of the days before and after it.
+ \returns                SKYIERS_NORMAL, or SKYIERS_OUTOFRANGE if \a mjdUtc is
+                         outside the span of the table, in which case the values
+                         of its first or last day are returned.
+ \param[in]  table       Table of values, as set up by skyiers_load()
+ \param[in]  mjdUtc      Modified Julian Date (= JD - 2 400 000.5), UTC timescale
+ \param[out] ut1Utc_s    UT1 - UTC (seconds)
+ \param[out] xPolar_as   \b Optional. Polar motion in x (arcseconds). May be
+                         NULL.
+ \param[out] yPolar_as   \b Optional. Polar motion in y (arcseconds). May be
+                         NULL.
+
+ The day containing \a mjdUtc is found directly from its position in the table,
+ without any searching. Across a leap second, UT1 - UTC jumps by one second;
+ this is allowed for when interpolating, so the value returned is correct on
+ both sides of the leap.
+
+ \par When to call this function
+    Whenever you need the values for a particular time. For a program running
+    continuously, skyiers_refresh() does this for you, once per day.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    const SkyIers_Day *d0;      // Day before the time
+    const SkyIers_Day *d1;      // Day after the time
+    double  pos;                // Position of time in table (days)
+    double  frac;               // Fraction of the way from d0 to d1
+    double  jump_s;             // Leap second between d0 and d1
+    int     i;
+    int     status;
+
+    REQUIRE_NOT_NULL(table);
+    REQUIRE_NOT_NULL(table->days);
+    REQUIRE(table->count > 0);
+    REQUIRE_NOT_NULL(ut1Utc_s);
+
+    status = SKYIERS_NORMAL;
+    pos = mjdUtc - table->firstMjd;
+    if (pos < 0.0) {
+        status = SKYIERS_OUTOFRANGE;
+        pos = 0.0;
+    } else if (pos > table->count - 1) {
+        status = SKYIERS_OUTOFRANGE;
+        pos = table->count - 1;
+    }
+    i = (int)pos;
+    if (i >= table->count - 1) {
+        i = table->count - 1;           // Last day (no interpolation needed)
+        frac = 0.0;
+        d1 = &table->days[i];
+    } else {
+        frac = pos - i;
+        d1 = &table->days[i + 1];
+    }
+    d0 = &table->days[i];
+
+    jump_s = 0.0;
+    if (d1->ut1Utc_s - d0->ut1Utc_s > 0.5) {
+        jump_s = 1.0;                   // Leap second at start of day d1
+    } else if (d1->ut1Utc_s - d0->ut1Utc_s < -0.5) {
+        jump_s = -1.0;                  // (Negative leap second)
+    }
+
+    *ut1Utc_s = d0->ut1Utc_s + frac * (d1->ut1Utc_s - jump_s - d0->ut1Utc_s);
+    if (xPolar_as != NULL) {
+        *xPolar_as = d0->xPolar_as + frac * (d1->xPolar_as - d0->xPolar_as);
+    }
+    if (yPolar_as != NULL) {
+        *yPolar_as = d0->yPolar_as + frac * (d1->yPolar_as - d0->yPolar_as);
+    }
+    return status;
+}
+
+
+
+GLOBAL int skyiers_loadLeapSeconds(const char      path[],
+                                   Sky_LeapSeconds *leap,
+                                   int             *errorLine)
+/*! Read a table of leap seconds from a file, in place of the list built into
+    sky-time.c.
+ \returns               SKYIERS_NORMAL, SKYIERS_OPENFAIL, SKYIERS_BADLINE or
+                        SKYIERS_NODATA (see SkyIers_Errors). If an error is
+                        returned, \a leap holds the built-in leap seconds,
+                        updated by any lines read before the error.
+ \param[in]  path       Name of the file. This is either Leap_Second.dat, from
+                        the IERS, or leap-seconds.list, as distributed by the
+                        IERS, NIST and with the IANA time zone database.
+ \param[out] leap       Table of leap seconds
+ \param[out] errorLine  \b Optional. Number of the line (from 1) at which an
+                        error was found, or 0 if none. May be NULL.
+
+ \par When to call this function
+    At program initialisation time, in place of sky_initLeapSeconds(), if you
+    have a file that is more up to date than this library.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    FILE    *fp;
+    char    line[SKYIERS_MAX_LINE];
+    double  mjd;
+    int     deltaAT_s;
+    int     lineNum;
+    int     n;                  // Number of leap seconds read so far
+    int     result;
+    int     status;
+
+    REQUIRE_NOT_NULL(path);
+    REQUIRE_NOT_NULL(leap);
+
+    sky_initLeapSeconds(leap);
+    if (errorLine != NULL) {
+        *errorLine = 0;
+    }
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        return SKYIERS_OPENFAIL;
+    }
+
+    status = SKYIERS_NORMAL;
+    n = 0;
+    lineNum = 0;
+    while ((status == SKYIERS_NORMAL)
+           && (fgets(line, (int)sizeof(line), fp) != NULL)) {
+        lineNum++;
+        if ((strchr(line, '\n') == NULL) && !feof(fp)) {
+            status = SKYIERS_BADLINE;           // Line too long
+        } else {
+            result = parseLeapLine(line, &mjd, &deltaAT_s);
+            if (result == SKYIERS_NORMAL) {
+                /* Lines are in date order, so each value overrides the
+                   previous one from its date onwards */
+                sky_setLeapSecond((int)mjd, deltaAT_s, leap);
+                n++;
+            } else if (result != LINE_HAS_NO_DATA) {
+                status = result;
+            }
+        }
+    }
+    fclose(fp);
+
+    if ((status == SKYIERS_NORMAL) && (n == 0)) {
+        status = SKYIERS_NODATA;
+    }
+    if ((status == SKYIERS_BADLINE) && (errorLine != NULL)) {
+        *errorLine = lineNum;
+    }
+    return status;
+}
+
+
+
+GLOBAL bool skyiers_refresh(const SkyIers_Table *table,
+                            double              mjdUtc,
+                            int                 deltaAT_s,
+                            int                 *dayMjd,
+                            Sky_DeltaTs         *d,
+                            Sky_PolarMot        *polar)
+/*! Update the delta times and polar motion from a table, if the date has
+    changed since the last call.
+ \returns                True if the date changed, and \a d and \a polar were
+                         updated. False if nothing was done.
+ \param[in]     table    Table of values, as set up by skyiers_load()
+ \param[in]     mjdUtc   Modified Julian Date (= JD - 2 400 000.5), UTC
+                         timescale
+ \param[in]     deltaAT_s (= TAI - UTC). Cumulative number of leap seconds
+                         (seconds), as for sky_initTime(). If your program may
+                         run across a leap second, pass
+                         sky_leapSeconds_s(&leap, mjdUtc).
+ \param[in,out] dayMjd   MJD of the day for which \a d and \a polar were last
+                         set. Initialise this to SKYIERS_NO_DAY before the
+                         first call, and thereafter leave it alone.
+ \param[out]    d        Delta times, set by sky_initTime() with the value of
+                         UT1 - UTC at the middle of the day
+ \param[out]    polar    \b Optional. Polar motion, set by
+                         sky_setPolarMotion() with the values at the middle of
+                         the day. May be NULL if you are ignoring polar motion.
+
+ Using one value for the whole day means that UT1 - UTC may be in error by up
+ to about a millisecond (half a day's change) - much less than the errors of
+ the predictions themselves beyond the first few weeks. If the time is outside
+ the span of the table, the values of its first or last day are used.
+
+ \par When to call this function
+    Each time around your main loop, before sky_updateTimes(). It costs only a
+    comparison, except on the first call of each day. When it returns true,
+    call sky_adjustSiteForPolarMotion() for each site (if \a polar is not NULL).
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  midday;             // MJD of the middle of the day
+    double  ut1Utc_s;
+    double  xPolar_as;
+    double  yPolar_as;
+    int     day;
+
+    REQUIRE_NOT_NULL(table);
+    REQUIRE_NOT_NULL(dayMjd);
+    REQUIRE_NOT_NULL(d);
+
+    midday = floor(mjdUtc);
+    day = (int)midday;
+    if (day == *dayMjd) {
+        return false;
+    }
+
+    midday += 0.5;
+    (void)skyiers_lookup(table, midday, &ut1Utc_s, &xPolar_as, &yPolar_as);
+    sky_initTime(deltaAT_s, ut1Utc_s, d);
+    if (polar != NULL) {
+        sky_setPolarMotion(xPolar_as,
+                           yPolar_as,
+                           (midday - MJD_J2000) / JUL_CENT,
+                           polar);
+    }
+    *dayMjd = day;
+    return true;
+}
+
+
+
+/*
+ *------------------------------------------------------------------------------
+ *
+ * Local functions (not called from other modules).
+ *
+ *------------------------------------------------------------------------------
+ */
+LOCAL int parseLine(const char line[], int *mjd, SkyIers_Day *day)
+/* Extract the values used from one line of a finals file.
+ Returns
+    SKYIERS_NORMAL, LINE_HAS_NO_DATA or SKYIERS_BADLINE
+ Inputs
+    line - the line, as read by fgets()
+ Outputs
+    mjd  - Modified Julian Date of the line
+    day  - UT1 - UTC and polar motion (only if SKYIERS_NORMAL is returned)
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double      mjdValue;
+    size_t      length;
+    FieldStatus s1, s2, s3, s4;
+
+    length = strlen(line);
+    s1 = getField(line, length, MJD_COLUMN, MJD_WIDTH, &mjdValue);
+    if (s1 == FIELD_BLANK) {
+        return LINE_HAS_NO_DATA;
+    }
+    s2 = getField(line, length, XPOLAR_COLUMN, XPOLAR_WIDTH, &day->xPolar_as);
+    s3 = getField(line, length, YPOLAR_COLUMN, YPOLAR_WIDTH, &day->yPolar_as);
+    s4 = getField(line, length, UT1UTC_COLUMN, UT1UTC_WIDTH, &day->ut1Utc_s);
+    if ((s1 == FIELD_BAD) || (s2 == FIELD_BAD) || (s3 == FIELD_BAD)
+        || (s4 == FIELD_BAD)) {
+        return SKYIERS_BADLINE;
+    }
+    if ((s2 == FIELD_BLANK) || (s3 == FIELD_BLANK) || (s4 == FIELD_BLANK)) {
+        return LINE_HAS_NO_DATA;
+    }
+    if ((fabs(day->ut1Utc_s) > 1.0) || (mjdValue < 1.0)) {
+        return SKYIERS_BADLINE;
+    }
+    mjdValue = floor(mjdValue + 0.5);
+    *mjd = (int)mjdValue;
+    return SKYIERS_NORMAL;
+}
+
+
+
+LOCAL int parseLeapLine(const char line[], double *mjd, int *deltaAT_s)
+/* Extract the date and value of TAI - UTC from one line of a leap second file.
+   Lines of Leap_Second.dat hold the MJD, day, month, year and TAI - UTC. Lines
+   of leap-seconds.list hold the time in seconds since 1900 January 1 (the NTP
+   time) and TAI - UTC. In both, comments start with '#'.
+ Returns
+    SKYIERS_NORMAL, LINE_HAS_NO_DATA or SKYIERS_BADLINE
+ Inputs
+    line      - the line, as read by fgets()
+ Outputs
+    mjd       - Modified Julian Date from which the value applies
+    deltaAT_s - TAI - UTC (seconds)
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double      value[5];
+    const char  *p;
+    char        *endPtr;
+    int         count;              // Numbers needed on the line
+    int         i;
+
+    p = line;
+    while ((*p == ' ') || (*p == '\t')) {
+        p++;
+    }
+    if ((*p == '#') || (*p == '\n') || (*p == '\r') || (*p == '\0')) {
+        return LINE_HAS_NO_DATA;
+    }
+
+    count = 5;
+    for (i = 0; i < count; i++) {
+        value[i] = strtod(p, &endPtr);
+        if (endPtr == p) {
+            return SKYIERS_BADLINE;
+        }
+        p = endPtr;
+        if ((i == 0) && (value[0] >= NTP_TIME_MIN)) {
+            count = 2;                  // leap-seconds.list format
+        }
+    }
+
+    if (count == 2) {
+        *mjd = MJD_1JAN1900 + floor(value[0] / 86400.0);
+        *deltaAT_s = (int)value[1];
+    } else {
+        *mjd = floor(value[0]);
+        *deltaAT_s = (int)value[4];
+    }
+    if ((*mjd < MJD_1JAN1900) || (*deltaAT_s < 0) || (*deltaAT_s > 127)) {
+        return SKYIERS_BADLINE;
+    }
+    return SKYIERS_NORMAL;
+}
+
+
+
+LOCAL FieldStatus getField(const char line[],
+                           size_t     length,
+                           int        column,
+                           int        width,
+                           double     *value)
+/* Read a number from a fixed-width field of a line
+ Returns
+    FIELD_OK, FIELD_BLANK if the field is empty (or beyond the end of the line),
+    or FIELD_BAD if it does not contain a number
+ Inputs
+    line   - the line
+    length - length of the line (characters)
+    column - first column of the field (numbered from 1)
+    width  - width of the field (characters)
+ Outputs
+    value  - the number (only if FIELD_OK is returned)
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    char    field[16];
+    char    *endPtr;
+    size_t  first;
+    size_t  n;
+    size_t  i;
+
+    first = (size_t)(column - 1);
+    if (first >= length) {
+        return FIELD_BLANK;
+    }
+    n = (size_t)width;
+    if (first + n > length) {
+        n = length - first;
+    }
+    if (n >= sizeof(field)) {
+        return FIELD_BAD;
+    }
+    memcpy(field, &line[first], n);
+    field[n] = '\0';
+
+    /* Treat the newline (if the line ends within the field) as a blank */
+    for (i = 0; i < n; i++) {
+        if ((field[i] == '\n') || (field[i] == '\r')) {
+            field[i] = ' ';
+        }
+    }
+    if (strspn(field, " ") == n) {
+        return FIELD_BLANK;
+    }
+
+    *value = strtod(field, &endPtr);
+    if ((endPtr == field) || (strspn(endPtr, " ") != strlen(endPtr))) {
+        return FIELD_BAD;
+    }
+    return FIELD_OK;
+}
+
+/*- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+/*! \page page-iers-finals IERS finals files
+ *  The IERS Rapid Service/Prediction Centre publishes the Earth orientation
+ *  parameters every day, in files such as
+ *      - finals2000A.all   - from 1973 to about a year ahead
+ *      - finals2000A.data  - from 1992 to about a year ahead
+ *      - finals2000A.daily - the last 90 days, and predictions for 90 days
+ *
+ *  Each line of these files gives the values for one day, at 0h UTC, in fixed
+ *  columns. skyiers_load() uses only these columns of the Bulletin A part of
+ *  each line:
+ *
+ *  Columns | Value
+ *  :-------|:---------------------------------------
+ *  8-15    | Modified Julian Date
+ *  19-27   | Polar motion x (arcseconds)
+ *  38-46   | Polar motion y (arcseconds)
+ *  59-68   | UT1 - UTC (seconds)
+ *
+ *  These are the same values that are printed in the weekly Bulletin A, and
+ *  beyond the last measured day they are predictions. The lines for dates
+ *  beyond the predictions have no values, and are skipped.
+ *
+ *  The values are stored one per day, so the day containing any time is found
+ *  by subtracting the first date of the table, and the values are then
+ *  interpolated linearly between that day and the next. Linear interpolation
+ *  of daily values of UT1 - UTC is good to a few microseconds, and of polar
+ *  motion to well under a milliarcsecond. Each entry takes 24 bytes, so the
+ *  whole of finals2000A.all takes about 480 kB; a program that only needs the
+ *  coming months can read finals2000A.daily into a much smaller array.
+ *
+ *  Note that the files do not give TAI - UTC (the number of leap seconds),
+ *  which must still be supplied to skyiers_refresh(). Use
+ *  sky_leapSeconds_s() to get it, from the table built into sky-time.c or from
+ *  one read with skyiers_loadLeapSeconds().
+ */
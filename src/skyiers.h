@@ -0,0 +1,134 @@
+#ifndef SKYIERS_H
+#define SKYIERS_H
+/*============================================================================*/
+/*! \file
+ * \brief
+ * skyiers.h - read Earth orientation parameters from IERS "finals" files
+ *
+ * \author  David Hoadley
+ *
+ * \details
+ *          Routines to read the daily values of UT1 - UTC and polar motion
+ *          published by the IERS Rapid Service/Prediction Centre (the data of
+ *          Bulletin A) in the files finals2000A.all, finals2000A.data and
+ *          finals2000A.daily. The values are stored in a table with one entry
+ *          per day, in an array supplied by the caller, from which the values
+ *          for any time can be found without searching.
+ *
+ *          For a program that runs for many days, skyiers_refresh() updates a
+ *          Sky_DeltaTs and a Sky_PolarMot from the table, but only when the
+ *          date changes, so it can be called every time around the main loop.
+ *          This replaces the single values given to sky_initTime() (or
+ *          sky_initTimeDetailed()) and sky_setPolarMotion().
+ *
+ *          The leap seconds built into sky-time.c can also be replaced by
+ *          those read from the IERS file Leap_Second.dat or the file
+ *          leap-seconds.list.
+ *
+ *          See \ref page-iers-finals (at the end of skyiers.c) for details.
+ *
+ *==============================================================================
+ */
+/*
+ * Copyright (c) 2020, David Hoadley <vcrumble@westnet.com.au>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "sky.h"
+
+/*
+ * Global #defines and typedefs
+ */
+/*      Longest line (including the newline) that can be read from the file */
+#define SKYIERS_MAX_LINE        256
+
+/*      Value to initialise the day number used by skyiers_refresh() to, before
+        the first call. (It is not the MJD of any day in a finals file.) */
+#define SKYIERS_NO_DAY          0
+
+/*!     The Earth orientation parameters for one day (at 0h UTC) */
+typedef struct {
+    double  ut1Utc_s;           //!< UT1 - UTC (seconds)
+    double  xPolar_as;          //!< Polar motion in x (arcseconds)
+    double  yPolar_as;          //!< Polar motion in y (arcseconds)
+} SkyIers_Day;
+
+/*!     A table of Earth orientation parameters, one entry per day. Entry i is
+        for the day with Modified Julian Date \a firstMjd + i. The entries
+        contain no pointers, so the array can be saved to a file and later
+        mapped into memory, with this structure filled in to describe it. */
+typedef struct {
+    int                 firstMjd;   //!< MJD of the first entry
+    int                 count;      //!< Number of entries
+    const SkyIers_Day   *days;      //!< The entries
+} SkyIers_Table;
+
+/*! Errors detected when loading or looking up a table */
+typedef enum {
+    SKYIERS_NORMAL,         /*!< Normal successful completion */
+    SKYIERS_OPENFAIL,       /*!< File could not be opened */
+    SKYIERS_BADLINE,        /*!< A line could not be understood, or was not
+                             *   for the day after that of the line before */
+    SKYIERS_TOOMANY,        /*!< The file has more days than the array can
+                             *   hold */
+    SKYIERS_NODATA,         /*!< The file has no usable lines */
+    SKYIERS_OUTOFRANGE      /*!< Time is outside the span of the table. The
+                             *   values of the nearest day are returned */
+} SkyIers_Errors;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Global functions available to be called by other modules
+ */
+int skyiers_load(const char    path[],
+                 int           capacity,
+                 SkyIers_Day   days[],
+                 SkyIers_Table *table,
+                 int           *errorLine);
+int skyiers_lookup(const SkyIers_Table *table,
+                   double              mjdUtc,
+                   double              *ut1Utc_s,
+                   double              *xPolar_as,
+                   double              *yPolar_as);
+int skyiers_loadLeapSeconds(const char      path[],
+                            Sky_LeapSeconds *leap,
+                            int             *errorLine);
+bool skyiers_refresh(const SkyIers_Table *table,
+                     double              mjdUtc,
+                     int                 deltaAT_s,
+                     int                 *dayMjd,
+                     Sky_DeltaTs         *d,
+                     Sky_PolarMot        *polar);
+
+/*
+ * Global variables accessible by other modules
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SKYIERS_H */
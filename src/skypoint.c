@@ -0,0 +1,549 @@
+/*==============================================================================
+ * skypoint.c - pointing model for alt-azimuth mounts, such as telescopes,
+ *              trackers and heliostats
+ *
+ * Author:  David Hoadley
+ *
+ * Description: (see skypoint.h)
+ *
+ * Copyright (c) 2020, David Hoadley <vcrumble@westnet.com.au>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ *==============================================================================
+ */
+/*------------------------------------------------------------------------------
+ * Notes:
+ *      Character set: UTF-8. (Non-ASCII characters appear in this file)
+ *----------------------------------------------------------------------------*/
+
+/* ANSI includes etc. */
+#include "instead-of-math.h"
+
+/* Local and project includes */
+#include "skypoint.h"
+
+#include "general.h"
+
+/*
+ * Local #defines and typedefs
+ */
+DEFINE_THIS_FILE;                       // For use by REQUIRE() - assertions.
+
+/*      Limits for reversing the model by iteration (see skypoint_mountToTopo) */
+#define MAX_ITERATIONS      10
+#define ITERATION_TOL_RAD   1e-12
+
+/*
+ * Prototypes for local functions (not called from other modules)
+ */
+LOCAL void termPartials(double azimuth_rad,
+                        double elevation_rad,
+                        double dAzCosEl[],
+                        double dEl[]);
+LOCAL void applyModel(const SkyPoint_Model *model,
+                      double               azimuth_rad,
+                      double               elevation_rad,
+                      double               *dAz_rad,
+                      double               *dEl_rad);
+LOCAL double wrapAngle(double angle_rad);
+
+
+/*
+ * Global variables accessible by other modules
+ */
+
+
+/*
+ * Local variables (not accessed by other modules)
+ */
+
+
+/*
+ *==============================================================================
+ *
+ * Implementation
+ *
+ *==============================================================================
+ *
+ * Global functions callable by other modules
+ *
+ *------------------------------------------------------------------------------
+ */
+GLOBAL void skypoint_init(SkyPoint_Model *model)
+/*! Initialise a pointing model to have all coefficients zero - i.e. a perfect
+    mount.
+ \param[out] model  All coefficients set to zero
+
+ \par When to call this function
+    At program initialisation time, for each mount, unless you are about to
+    load its coefficients from somewhere or fit them with skypoint_fit().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    int     k;
+
+    REQUIRE_NOT_NULL(model);
+
+    for (k = 0; k < SKYPOINT_TERM_COUNT; k++) {
+        model->coeff_rad[k] = 0.0;
+    }
+}
+
+
+
+GLOBAL void skypoint_topoToMount(const SkyPoint_Model *model,
+                                 double               azimuth_rad,
+                                 double               elevation_rad,
+                                 double               *mountAz_rad,
+                                 double               *mountEl_rad)
+/*! Apply the pointing model to a topocentric position, to find the positions
+    to which the mount's axes must be driven to point at it.
+ \param[in]  model          Pointing model coefficients for this mount
+ \param[in]  azimuth_rad    Topocentric azimuth (radian), e.g. from the
+                            \a azimuth_rad field of the result of
+                            sky_siteTirsToTopo()
+ \param[in]  elevation_rad  Topocentric elevation (radian), e.g. from the
+                            \a elevation_rad field of the result of
+                            sky_siteTirsToTopo()
+ \param[out] mountAz_rad    Position of the mount's azimuth axis (radian)
+ \param[out] mountEl_rad    Position of the mount's elevation axis (radian)
+
+    Several of the azimuth terms are proportional to tan(elevation) or
+    sec(elevation), and so grow without limit close to the zenith. This is a
+    property of alt-azimuth mounts, not of the model.
+
+ \par When to call this function
+    Each time around your main loop, after calling sky_siteTirsToTopo().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  dAz_rad;
+    double  dEl_rad;
+
+    REQUIRE_NOT_NULL(model);
+    REQUIRE_NOT_NULL(mountAz_rad);
+    REQUIRE_NOT_NULL(mountEl_rad);
+
+    applyModel(model, azimuth_rad, elevation_rad, &dAz_rad, &dEl_rad);
+    *mountAz_rad = azimuth_rad + dAz_rad;
+    *mountEl_rad = elevation_rad + dEl_rad;
+}
+
+
+
+GLOBAL void skypoint_mountToTopo(const SkyPoint_Model *model,
+                                 double               mountAz_rad,
+                                 double               mountEl_rad,
+                                 double               *azimuth_rad,
+                                 double               *elevation_rad)
+/*! Reverse the pointing model, to find the topocentric position that the mount
+    is actually pointing at from the positions of its axes.
+ \param[in]  model          Pointing model coefficients for this mount
+ \param[in]  mountAz_rad    Position of the mount's azimuth axis (radian)
+ \param[in]  mountEl_rad    Position of the mount's elevation axis (radian)
+ \param[out] azimuth_rad    Topocentric azimuth (radian)
+ \param[out] elevation_rad  Topocentric elevation (radian)
+
+    The corrections depend on the topocentric position, which is what we are
+    trying to find, so this function iterates. As the corrections are small,
+    it takes only two or three iterations to converge to 1e-12 radian.
+
+ \par When to call this function
+    When you have read the mount's encoders and want to know where it is
+    pointing. Follow it with a call to v3d_polarToRect() and then
+    sky_siteTopoToTirs() if you want the apparent position.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  az_rad;
+    double  el_rad;
+    double  dAz_rad;
+    double  dEl_rad;
+    double  prevAz_rad;
+    double  prevEl_rad;
+    int     i;
+
+    REQUIRE_NOT_NULL(model);
+    REQUIRE_NOT_NULL(azimuth_rad);
+    REQUIRE_NOT_NULL(elevation_rad);
+
+    az_rad = mountAz_rad;
+    el_rad = mountEl_rad;
+    for (i = 0; i < MAX_ITERATIONS; i++) {
+        prevAz_rad = az_rad;
+        prevEl_rad = el_rad;
+        applyModel(model, az_rad, el_rad, &dAz_rad, &dEl_rad);
+        az_rad = mountAz_rad - dAz_rad;
+        el_rad = mountEl_rad - dEl_rad;
+        if ((fabs(az_rad - prevAz_rad) < ITERATION_TOL_RAD)
+            && (fabs(el_rad - prevEl_rad) < ITERATION_TOL_RAD)) {
+            break;
+        }
+    }
+    *azimuth_rad = az_rad;
+    *elevation_rad = el_rad;
+}
+
+
+
+GLOBAL void skypoint_topoToMountBatch(int                  count,
+                                      const SkyPoint_Model models[],
+                                      const double         azimuth_rad[],
+                                      const double         elevation_rad[],
+                                      double               mountAz_rad[],
+                                      double               mountEl_rad[])
+/*! Apply the pointing model to the topocentric positions for a number of
+    mounts, each with its own model. The results are the same as calling
+    skypoint_topoToMount() for each mount.
+ \param[in]  count          Number of mounts
+ \param[in]  models         Array of \a count pointing models
+ \param[in]  azimuth_rad    Array of \a count topocentric azimuths (radian)
+ \param[in]  elevation_rad  Array of \a count topocentric elevations (radian)
+ \param[out] mountAz_rad    Array of \a count azimuth axis positions (radian)
+ \param[out] mountEl_rad    Array of \a count elevation axis positions
+                            (radian)
+
+ \par When to call this function
+    Each time around your main loop, for a field of trackers or heliostats,
+    after calculating the direction each one must point in.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  dAz_rad;
+    double  dEl_rad;
+    int     i;
+
+    REQUIRE(count >= 0);
+    REQUIRE_NOT_NULL(models);
+    REQUIRE_NOT_NULL(azimuth_rad);
+    REQUIRE_NOT_NULL(elevation_rad);
+    REQUIRE_NOT_NULL(mountAz_rad);
+    REQUIRE_NOT_NULL(mountEl_rad);
+
+    for (i = 0; i < count; i++) {
+        applyModel(&models[i],
+                   azimuth_rad[i],
+                   elevation_rad[i],
+                   &dAz_rad,
+                   &dEl_rad);
+        mountAz_rad[i] = azimuth_rad[i] + dAz_rad;
+        mountEl_rad[i] = elevation_rad[i] + dEl_rad;
+    }
+}
+
+
+
+GLOBAL int skypoint_fit(int            count,
+                        const double   azimuth_rad[],
+                        const double   elevation_rad[],
+                        const double   mountAz_rad[],
+                        const double   mountEl_rad[],
+                        unsigned       termMask,
+                        SkyPoint_Model *model,
+                        double         *rms_rad)
+/*! Find the pointing model coefficients that best fit a set of observations,
+    by linear least squares.
+ \returns    SKYPOINT_NORMAL if successful, SKYPOINT_TOOFEW if there are too
+             few observations, or SKYPOINT_SINGULAR if the observations cannot
+             distinguish between the selected terms. In the latter two cases,
+             \a model is not changed.
+ \param[in]  count          Number of observations
+ \param[in]  azimuth_rad    Array of \a count topocentric azimuths (radian):
+                            where the object observed actually was
+ \param[in]  elevation_rad  Array of \a count topocentric elevations (radian)
+ \param[in]  mountAz_rad    Array of \a count azimuth axis positions (radian):
+                            where the mount was when it was centred on the
+                            object
+ \param[in]  mountEl_rad    Array of \a count elevation axis positions
+                            (radian)
+ \param[in]  termMask       Terms to be fitted: bit (1u << k) set for each
+                            term k of SkyPoint_Term, or SKYPOINT_ALL_TERMS.
+                            Terms not selected are set to zero.
+ \param[out] model          Fitted coefficients
+ \param[out] rms_rad        Root mean square of the remaining pointing errors
+                            on the sky, after the fit (radian). May be NULL if
+                            not required.
+
+    The azimuth errors are multiplied by cos(elevation) before fitting, so
+    that all errors are measured as angles on the sky. This also keeps the
+    fit well behaved for observations near the zenith.
+
+    The work is proportional to \a count, with a single pass through the
+    observations to build the normal equations (at most 7 x 7) and another to
+    find the remaining errors. Five thousand observations take about a
+    millisecond, so a whole field of heliostats can be recalibrated in
+    seconds.
+
+ \par When to call this function
+    After logging a set of observations, well spread over the sky, for a mount.
+    For a heliostat, the "observations" are the directions of the mirror normal
+    that put the reflected beam on target, together with the axis positions.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  normM[SKYPOINT_TERM_COUNT][SKYPOINT_TERM_COUNT]; // Normal equations
+    double  rhs[SKYPOINT_TERM_COUNT];   // Right hand side of normal equations
+    double  diag[SKYPOINT_TERM_COUNT];  // Original diagonal of normM
+    double  soln[SKYPOINT_TERM_COUNT];
+    double  dAzCosEl[SKYPOINT_TERM_COUNT];
+    double  dEl[SKYPOINT_TERM_COUNT];
+    double  rowA[SKYPOINT_TERM_COUNT];
+    double  rowE[SKYPOINT_TERM_COUNT];
+    int     term[SKYPOINT_TERM_COUNT];  // Which term each unknown belongs to
+    int     n;                          // Number of terms being fitted
+    double  cosEl;
+    double  resA;                       // Azimuth error on the sky (radian)
+    double  resE;                       // Elevation error (radian)
+    double  sumSq;
+    double  sum;
+    int     i, j, k;
+
+    REQUIRE(count >= 0);
+    REQUIRE_NOT_NULL(azimuth_rad);
+    REQUIRE_NOT_NULL(elevation_rad);
+    REQUIRE_NOT_NULL(mountAz_rad);
+    REQUIRE_NOT_NULL(mountEl_rad);
+    REQUIRE_NOT_NULL(model);
+
+    n = 0;
+    for (k = 0; k < SKYPOINT_TERM_COUNT; k++) {
+        if ((termMask & (1u << k)) != 0) {
+            term[n] = k;
+            n++;
+        }
+    }
+    /* Each observation gives two equations, one in azimuth, one in elevation */
+    if (2 * count < n) {
+        return SKYPOINT_TOOFEW;
+    }
+
+    /* 1. Accumulate the normal equations */
+    for (j = 0; j < n; j++) {
+        rhs[j] = 0.0;
+        for (k = 0; k < n; k++) {
+            normM[j][k] = 0.0;
+        }
+    }
+    for (i = 0; i < count; i++) {
+        termPartials(azimuth_rad[i], elevation_rad[i], dAzCosEl, dEl);
+        cosEl = cos(elevation_rad[i]);
+        resA = wrapAngle(mountAz_rad[i] - azimuth_rad[i]) * cosEl;
+        resE = mountEl_rad[i] - elevation_rad[i];
+        for (j = 0; j < n; j++) {
+            rowA[j] = dAzCosEl[term[j]];
+            rowE[j] = dEl[term[j]];
+        }
+        for (j = 0; j < n; j++) {
+            rhs[j] += rowA[j] * resA + rowE[j] * resE;
+            for (k = 0; k <= j; k++) {
+                normM[j][k] += rowA[j] * rowA[k] + rowE[j] * rowE[k];
+            }
+        }
+    }
+
+    /* 2. Solve them by Cholesky decomposition. (Only the lower triangle of
+          normM has been filled in, and only it is used.) A pivot that has
+          almost vanished, relative to the original diagonal element, means
+          that the term cannot be separated from the others. */
+    for (j = 0; j < n; j++) {
+        diag[j] = normM[j][j];
+    }
+    for (j = 0; j < n; j++) {
+        sum = normM[j][j];
+        for (k = 0; k < j; k++) {
+            sum -= normM[j][k] * normM[j][k];
+        }
+        if (sum <= 1e-12 * diag[j]) {
+            return SKYPOINT_SINGULAR;
+        }
+        normM[j][j] = sqrt(sum);
+        for (i = j + 1; i < n; i++) {
+            sum = normM[i][j];
+            for (k = 0; k < j; k++) {
+                sum -= normM[i][k] * normM[j][k];
+            }
+            normM[i][j] = sum / normM[j][j];
+        }
+    }
+    /*    Forward substitution (L y = rhs), then back substitution (Lt x = y) */
+    for (j = 0; j < n; j++) {
+        sum = rhs[j];
+        for (k = 0; k < j; k++) {
+            sum -= normM[j][k] * soln[k];
+        }
+        soln[j] = sum / normM[j][j];
+    }
+    for (j = n - 1; j >= 0; j--) {
+        sum = soln[j];
+        for (k = j + 1; k < n; k++) {
+            sum -= normM[k][j] * soln[k];
+        }
+        soln[j] = sum / normM[j][j];
+    }
+
+    skypoint_init(model);
+    for (j = 0; j < n; j++) {
+        model->coeff_rad[term[j]] = soln[j];
+    }
+
+    /* 3. Find the errors remaining after the fit */
+    if (rms_rad != NULL) {
+        sumSq = 0.0;
+        for (i = 0; i < count; i++) {
+            termPartials(azimuth_rad[i], elevation_rad[i], dAzCosEl, dEl);
+            resA = wrapAngle(mountAz_rad[i] - azimuth_rad[i])
+                   * cos(elevation_rad[i]);
+            resE = mountEl_rad[i] - elevation_rad[i];
+            for (j = 0; j < n; j++) {
+                resA -= dAzCosEl[term[j]] * soln[j];
+                resE -= dEl[term[j]] * soln[j];
+            }
+            sumSq += resA * resA + resE * resE;
+        }
+        *rms_rad = (count > 0) ? sqrt(sumSq / count) : 0.0;
+    }
+    return SKYPOINT_NORMAL;
+}
+
+/*
+ *------------------------------------------------------------------------------
+ *
+ * Local functions (not called from other modules).
+ *
+ *------------------------------------------------------------------------------
+ */
+LOCAL void termPartials(double azimuth_rad,
+                        double elevation_rad,
+                        double dAzCosEl[],
+                        double dEl[])
+/* Calculate the effect of each term of the model on the mount's axis
+   positions, for a unit coefficient. The azimuth effects are multiplied by
+   cos(elevation), which removes the sec(elevation) from them.
+ Inputs
+    azimuth_rad   - topocentric azimuth (radian)
+    elevation_rad - topocentric elevation (radian)
+ Outputs
+    dAzCosEl - effect of each term on the azimuth axis, times cos(elevation).
+               Array indexed by SkyPoint_Term.
+    dEl      - effect of each term on the elevation axis.
+               Array indexed by SkyPoint_Term.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  sinA, cosA;
+    double  sinE, cosE;
+
+    sincos(azimuth_rad, &sinA, &cosA);
+    sincos(elevation_rad, &sinE, &cosE);
+
+    dAzCosEl[SKYPOINT_IA]   = -cosE;
+    dEl[SKYPOINT_IA]        = 0.0;
+    dAzCosEl[SKYPOINT_IE]   = 0.0;
+    dEl[SKYPOINT_IE]        = 1.0;
+    dAzCosEl[SKYPOINT_CA]   = -1.0;
+    dEl[SKYPOINT_CA]        = 0.0;
+    dAzCosEl[SKYPOINT_NPAE] = -sinE;
+    dEl[SKYPOINT_NPAE]      = 0.0;
+    dAzCosEl[SKYPOINT_AN]   = -sinA * sinE;
+    dEl[SKYPOINT_AN]        = -cosA;
+    dAzCosEl[SKYPOINT_AW]   = -cosA * sinE;
+    dEl[SKYPOINT_AW]        = sinA;
+    dAzCosEl[SKYPOINT_TF]   = 0.0;
+    dEl[SKYPOINT_TF]        = -cosE;
+}
+
+
+
+LOCAL void applyModel(const SkyPoint_Model *model,
+                      double               azimuth_rad,
+                      double               elevation_rad,
+                      double               *dAz_rad,
+                      double               *dEl_rad)
+/* Calculate the corrections to the mount's axis positions given by the model
+   at a topocentric position.
+ Inputs
+    model         - pointing model coefficients
+    azimuth_rad   - topocentric azimuth (radian)
+    elevation_rad - topocentric elevation (radian)
+ Outputs
+    dAz_rad - correction to the azimuth axis (radian)
+    dEl_rad - correction to the elevation axis (radian)
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  dAzCosEl[SKYPOINT_TERM_COUNT];
+    double  dEl[SKYPOINT_TERM_COUNT];
+    double  sumAz;
+    double  sumEl;
+    int     k;
+
+    termPartials(azimuth_rad, elevation_rad, dAzCosEl, dEl);
+    sumAz = 0.0;
+    sumEl = 0.0;
+    for (k = 0; k < SKYPOINT_TERM_COUNT; k++) {
+        sumAz += model->coeff_rad[k] * dAzCosEl[k];
+        sumEl += model->coeff_rad[k] * dEl[k];
+    }
+    *dAz_rad = sumAz / cos(elevation_rad);
+    *dEl_rad = sumEl;
+}
+
+
+
+LOCAL double wrapAngle(double angle_rad)
+/* Reduce an angle to the range [-Pi, +Pi)
+ Returns
+    The reduced angle (radian)
+ Inputs
+    angle_rad - angle (radian)
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    return angle_rad - TWOPI * floor((angle_rad + PI) / TWOPI);
+}
+
+/*- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+/*! \page page-pointing-model The pointing model
+ *  No mount is perfect. The encoders' zero points are not exactly at north and
+ *  the horizon, the axes are not quite perpendicular to each other, the
+ *  azimuth axis is not quite vertical, and the structure sags under its own
+ *  weight. The skypoint module models these effects with the following terms
+ *  of the TPOINT alt-azimuth model. A is the azimuth, E the elevation, and the
+ *  table shows how much each term, with a coefficient of 1, adds to the
+ *  positions of the mount's axes.
+ *
+ *  Term | Meaning                                   | Azimuth axis  | Elevation axis
+ *  :----|:------------------------------------------|:--------------|:-------------
+ *  IA   | Azimuth index error                       | −1            | 0
+ *  IE   | Elevation index error                     | 0             | +1
+ *  CA   | Collimation (left-right) error            | −sec E        | 0
+ *  NPAE | Non-perpendicularity of the two axes      | −tan E        | 0
+ *  AN   | Azimuth axis tilted towards north         | −sin A tan E  | −cos A
+ *  AW   | Azimuth axis tilted towards west          | −cos A tan E  | +sin A
+ *  TF   | Tube (or frame) flexure                   | 0             | −cos E
+ *
+ *  For an alt-azimuth mount, a misaligned azimuth axis (AN and AW) plays the
+ *  part that polar axis misalignment plays for an equatorial mount.
+ *
+ *  Function skypoint_fit() finds the coefficients from logged observations.
+ *  With the seven terms and observations well spread over the sky, a few
+ *  dozen observations are enough to find the coefficients; more simply
+ *  reduce the effect of the measurement noise. Observations all made at one
+ *  azimuth cannot separate IA from AN and AW, and skypoint_fit() reports
+ *  SKYPOINT_SINGULAR in such cases. Fit fewer terms (using the \a termMask
+ *  argument) if the observations do not cover enough of the sky.
+ */
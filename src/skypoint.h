@@ -0,0 +1,131 @@
+#ifndef SKYPOINT_H
+#define SKYPOINT_H
+/*============================================================================*/
+/*! \file
+ * \brief
+ * skypoint.h - pointing model for alt-azimuth mounts, such as telescopes,
+ *              trackers and heliostats
+ *
+ * \author  David Hoadley
+ *
+ * \details
+ *          Routines to correct for the mechanical imperfections of an
+ *          alt-azimuth mount: index errors of the encoders, collimation error,
+ *          non-perpendicularity of the axes, tilt of the azimuth axis and tube
+ *          (or frame) flexure. These are the standard terms of the TPOINT
+ *          alt-azimuth model. The correction is applied after
+ *          sky_siteTirsToTopo(), to convert the topocentric azimuth and
+ *          elevation into the positions the mount's axes must be driven to,
+ *          and can be reversed to find the direction actually pointed at from
+ *          the mount's axis positions.
+ *
+ *          The coefficients for each mount are kept in a SkyPoint_Model,
+ *          alongside its Sky_SiteProp. They can be found from a set of logged
+ *          observations with skypoint_fit(). See \ref page-pointing-model (at
+ *          the end of skypoint.c) for the terms of the model.
+ *
+ *==============================================================================
+ */
+/*
+ * Copyright (c) 2020, David Hoadley <vcrumble@westnet.com.au>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "sky.h"
+
+/*
+ * Global #defines and typedefs
+ */
+/*!     The terms of the pointing model. The sign conventions are those of
+        TPOINT. See \ref page-pointing-model for their effects. */
+typedef enum {
+    SKYPOINT_IA,            //!< Azimuth index error
+    SKYPOINT_IE,            //!< Elevation index error
+    SKYPOINT_CA,            //!< Collimation error (left-right)
+    SKYPOINT_NPAE,          //!< Non-perpendicularity of azimuth & elev. axes
+    SKYPOINT_AN,            //!< Azimuth axis tilt, towards north
+    SKYPOINT_AW,            //!< Azimuth axis tilt, towards west
+    SKYPOINT_TF,            //!< Tube (or frame) flexure
+    SKYPOINT_TERM_COUNT     //!< (Number of terms)
+} SkyPoint_Term;
+
+/*      Mask with a bit set for every term, for skypoint_fit() */
+#define SKYPOINT_ALL_TERMS      ((1u << SKYPOINT_TERM_COUNT) - 1u)
+
+/*!     Pointing model coefficients for one mount */
+typedef struct {
+    double  coeff_rad[SKYPOINT_TERM_COUNT]; /*!< Coefficient of each term,
+                                                 indexed by SkyPoint_Term
+                                                 (radian) */
+} SkyPoint_Model;
+
+/*! Errors detected when fitting a pointing model */
+typedef enum {
+    SKYPOINT_NORMAL,        /*!< Normal successful completion */
+    SKYPOINT_TOOFEW,        /*!< Fewer observations than terms to be fitted */
+    SKYPOINT_SINGULAR       /*!< The observations cannot separate the terms
+                             *   (e.g. they are all at the same azimuth) */
+} SkyPoint_Errors;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Global functions available to be called by other modules
+ */
+void skypoint_init(SkyPoint_Model *model);
+void skypoint_topoToMount(const SkyPoint_Model *model,
+                          double               azimuth_rad,
+                          double               elevation_rad,
+                          double               *mountAz_rad,
+                          double               *mountEl_rad);
+void skypoint_mountToTopo(const SkyPoint_Model *model,
+                          double               mountAz_rad,
+                          double               mountEl_rad,
+                          double               *azimuth_rad,
+                          double               *elevation_rad);
+void skypoint_topoToMountBatch(int                  count,
+                               const SkyPoint_Model models[],
+                               const double         azimuth_rad[],
+                               const double         elevation_rad[],
+                               double               mountAz_rad[],
+                               double               mountEl_rad[]);
+int skypoint_fit(int            count,
+                 const double   azimuth_rad[],
+                 const double   elevation_rad[],
+                 const double   mountAz_rad[],
+                 const double   mountEl_rad[],
+                 unsigned       termMask,
+                 SkyPoint_Model *model,
+                 double         *rms_rad);
+
+/*
+ * Global variables accessible by other modules
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SKYPOINT_H */
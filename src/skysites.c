@@ -0,0 +1,621 @@
+/*==============================================================================
+ * skysites.c - load a database of observing sites from a CSV file
+ *
+ * Author:  David Hoadley
+ *
+ * Description: (see skysites.h)
+ *
+ * Copyright (c) 2020, David Hoadley <vcrumble@westnet.com.au>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ *==============================================================================
+ */
+/*------------------------------------------------------------------------------
+ * Notes:
+ *      Character set: UTF-8. (Non-ASCII characters appear in this file)
+ *----------------------------------------------------------------------------*/
+
+/* ANSI includes etc. */
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef POSIX_THREADS
+# include <pthread.h>
+#endif
+
+/* Local and project includes */
+#include "skysites.h"
+
+#include "general.h"
+
+/*
+ * Local #defines and typedefs
+ */
+DEFINE_THIS_FILE;                       // For use by REQUIRE() - assertions.
+
+/*      Number of values on each line of the file */
+#define FIELD_COUNT             8
+
+/*      Number of points in a horizon mask read from a file (1° apart) */
+#define HORIZON_POINTS          360
+
+/*      Result of parsing a line that is not a site */
+#define LINE_IS_NOT_A_SITE      (-1)
+
+/*      A range of entries to be initialised by one thread */
+typedef struct {
+    SkySites_Entry  *first;
+    int             count;
+} InitJob;
+
+/*
+ * Prototypes for local functions (not called from other modules)
+ */
+LOCAL int parseLine(const char line[], bool headerAllowed,
+                    SkySites_Record *record);
+LOCAL void initEntry(SkySites_Entry *entry);
+LOCAL void fillHorizon(double az1_deg, double el1_deg,
+                       double az2_deg, double el2_deg,
+                       double elevation_deg[]);
+LOCAL void *initRange(void *arg);
+
+
+/*
+ * Global variables accessible by other modules
+ */
+
+
+/*
+ * Local variables (not accessed by other modules)
+ */
+/*      Values used for fields missing from the end of a line: 10 °C, 1010 hPa,
+        UTC, and a horizontal surface */
+LOCAL const double defaultField[FIELD_COUNT] = {
+    0.0, 0.0, 0.0, 10.0, 1010.0, 0.0, 0.0, 0.0
+};
+
+
+/*
+ *==============================================================================
+ *
+ * Implementation
+ *
+ *==============================================================================
+ *
+ * Global functions callable by other modules
+ *
+ *------------------------------------------------------------------------------
+ */
+GLOBAL int skysites_load(const char     path[],
+                         int            capacity,
+                         SkySites_Entry entries[],
+                         int            threadCount,
+                         int            *count,
+                         int            *errorLine)
+/*! Read a site database from a CSV file, and initialise every site in it.
+ \returns    SKYSITES_NORMAL if successful, SKYSITES_OPENFAIL if the file
+             cannot be opened, SKYSITES_BADLINE if a line could not be
+             understood, or SKYSITES_TOOMANY if there are more than
+             \a capacity sites in the file. In the case of an error, no sites
+             are initialised.
+ \param[in]  path        Name of the file
+ \param[in]  capacity    Number of elements in array \a entries
+ \param[out] entries     The sites, in the order in which they appear in the
+                         file. Every field of the first \a count elements is
+                         set.
+ \param[in]  threadCount Number of threads to use for the initialisation (see
+                         skysites_initEntries())
+ \param[out] count       Number of sites read
+ \param[out] errorLine   Line number of the line in error (if the return value
+                         is SKYSITES_BADLINE or SKYSITES_TOOMANY), otherwise 0.
+                         May be NULL if not required.
+
+ \par When to call this function
+    At program initialisation time. See \ref page-site-csv for the format of
+    the file.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    FILE    *fp;
+    char    line[SKYSITES_MAX_LINE];
+    SkySites_Record spare;      // For lines beyond the capacity of entries
+    int     lineNum;
+    int     n;                  // Number of sites read so far
+    int     result;
+    int     status;
+
+    REQUIRE_NOT_NULL(path);
+    REQUIRE(capacity >= 0);
+    REQUIRE_NOT_NULL(entries);
+    REQUIRE_NOT_NULL(count);
+
+    *count = 0;
+    if (errorLine != NULL) {
+        *errorLine = 0;
+    }
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        return SKYSITES_OPENFAIL;
+    }
+
+    /* 1. Read all the lines. This is quick compared with the initialisation */
+    status = SKYSITES_NORMAL;
+    n = 0;
+    lineNum = 0;
+    while ((status == SKYSITES_NORMAL)
+           && (fgets(line, (int)sizeof(line), fp) != NULL)) {
+        lineNum++;
+        if ((strchr(line, '\n') == NULL) && !feof(fp)) {
+            status = SKYSITES_BADLINE;          // Line too long
+        } else if (n >= capacity) {
+            /* Only an error if this line has a site on it */
+            result = parseLine(line, (n == 0), &spare);
+            if (result != LINE_IS_NOT_A_SITE) {
+                status = SKYSITES_TOOMANY;
+            }
+        } else {
+            result = parseLine(line, (n == 0), &entries[n].record);
+            if (result == SKYSITES_NORMAL) {
+                n++;
+            } else if (result != LINE_IS_NOT_A_SITE) {
+                status = result;
+            }
+        }
+    }
+    fclose(fp);
+
+    if (status != SKYSITES_NORMAL) {
+        if (errorLine != NULL) {
+            *errorLine = lineNum;
+        }
+        return status;
+    }
+
+    /* 2. Initialise the sites */
+    skysites_initEntries(n, entries, threadCount);
+    *count = n;
+    return SKYSITES_NORMAL;
+}
+
+
+
+GLOBAL void skysites_initEntries(int            count,
+                                 SkySites_Entry entries[],
+                                 int            threadCount)
+/*! Initialise the \a site and \a surface fields of each entry from its
+    \a record field, by calling sky_setSiteLocation(), sky_setSiteTempPress(),
+    sky_setSiteTimeZone() and sky_setupSiteSurface().
+ \param[in]     count       Number of entries
+ \param[in,out] entries     Array of \a count entries. Field \a record must
+                            be filled in on input; fields \a site and
+                            \a surface are set on output.
+ \param[in]     threadCount Number of threads to share the work among
+                            (including the calling thread), up to
+                            SKYSITES_MAX_THREADS. This is ignored unless the
+                            macro POSIX_THREADS is defined, in which case the
+                            entries are divided into this many contiguous
+                            ranges, one per thread. If a thread cannot be
+                            started, its range is done by the calling thread.
+
+    The first entry is always initialised by the calling thread before any
+    others are started, so that the refraction table (shared by all sites) is
+    built only once.
+
+    On a modern desktop processor, each site takes about 0.25 microseconds to
+    initialise, while skysites_load() takes about 1 microsecond per site to
+    read the file. So extra threads are only worthwhile for very large
+    databases, or on slow processors.
+
+ \par When to call this function
+    This is called by skysites_load(). Call it yourself if you have filled in
+    the records in some other way.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    InitJob     job[SKYSITES_MAX_THREADS];
+    int         jobCount;
+    int         perJob;
+    int         i;
+#ifdef POSIX_THREADS
+    pthread_t   thread[SKYSITES_MAX_THREADS];
+    bool        started[SKYSITES_MAX_THREADS];
+#endif
+
+    REQUIRE(count >= 0);
+    REQUIRE((count == 0) || (entries != NULL));
+
+    if (count == 0) {
+        return;
+    }
+    initEntry(&entries[0]);
+
+    /* Divide the remaining entries into contiguous ranges */
+#ifdef POSIX_THREADS
+    jobCount = threadCount;
+    if (jobCount > SKYSITES_MAX_THREADS) {
+        jobCount = SKYSITES_MAX_THREADS;
+    }
+    if (jobCount > count - 1) {
+        jobCount = count - 1;
+    }
+#else
+    (void)threadCount;
+    jobCount = 1;
+#endif
+    if (jobCount < 1) {
+        jobCount = 1;
+    }
+    perJob = (count - 1 + jobCount - 1) / jobCount;
+    for (i = 0; i < jobCount; i++) {
+        job[i].first = &entries[1 + i * perJob];
+        job[i].count = perJob;
+        if (1 + (i + 1) * perJob > count) {
+            job[i].count = count - (1 + i * perJob);
+        }
+    }
+
+#ifdef POSIX_THREADS
+    /* Job 0 is done by this thread, the others by new threads */
+    for (i = 1; i < jobCount; i++) {
+        started[i] = (pthread_create(&thread[i], NULL, initRange, &job[i])
+                      == 0);
+    }
+    (void)initRange(&job[0]);
+    for (i = 1; i < jobCount; i++) {
+        if (started[i]) {
+            pthread_join(thread[i], NULL);
+        } else {
+            (void)initRange(&job[i]);
+        }
+    }
+#else
+    (void)initRange(&job[0]);
+#endif
+}
+
+
+
+GLOBAL int skysites_loadHorizon(const char      path[],
+                                Sky_HorizonMask *mask,
+                                int             *errorLine)
+/*! Read the horizon profile of a site from a CSV file, and set up a horizon
+    mask from it.
+ \returns    SKYSITES_NORMAL if successful, SKYSITES_OPENFAIL if the file
+             cannot be opened, or SKYSITES_BADLINE if a line could not be
+             understood, the azimuths are not in increasing order, or there
+             are no points at all. In the case of an error, \a mask is not
+             changed.
+ \param[in]  path        Name of the file
+ \param[out] mask        Horizon mask, with 360 points 1° apart
+ \param[out] errorLine   Line number of the line in error (if the return value
+                         is SKYSITES_BADLINE), otherwise 0. May be NULL if not
+                         required.
+
+    Each line of the file has two values: an azimuth and the elevation of the
+    horizon at that azimuth (both in degrees). The azimuths must be in
+    increasing order, within the range [0, 360), but need not be equally
+    spaced. Blank lines, comment lines and a line of headings are ignored, as
+    for skysites_load(). The profile is resampled at every whole degree of
+    azimuth, by linear interpolation (wrapping around from the last point to
+    the first), so that sky_horizonElevation_rad() can then find the elevation
+    of the horizon in any direction in a fixed, short time.
+
+ \par When to call this function
+    At program initialisation time, for each site with an obstructed horizon.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    FILE    *fp;
+    char    line[SKYSITES_MAX_LINE];
+    double  elevation_deg[HORIZON_POINTS];
+    double  az_deg, el_deg;             // Point just read
+    double  firstAz_deg, firstEl_deg;   // First point in file
+    double  prevAz_deg, prevEl_deg;     // Previous point in file
+    char    *endPtr;
+    const char *p;
+    int     lineNum;
+    int     pointCount;
+    int     status;
+
+    REQUIRE_NOT_NULL(path);
+    REQUIRE_NOT_NULL(mask);
+
+    if (errorLine != NULL) {
+        *errorLine = 0;
+    }
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        return SKYSITES_OPENFAIL;
+    }
+
+    status = SKYSITES_NORMAL;
+    firstAz_deg = firstEl_deg = prevAz_deg = prevEl_deg = 0.0;
+    pointCount = 0;
+    lineNum = 0;
+    while ((status == SKYSITES_NORMAL)
+           && (fgets(line, (int)sizeof(line), fp) != NULL)) {
+        lineNum++;
+        p = line;
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if ((*p == '\0') || (*p == '#')
+            || ((pointCount == 0) && !isdigit((unsigned char)*p) && (*p != '-')
+                && (*p != '+') && (*p != '.'))) {
+            continue;                   // Blank, comment or headings
+        }
+        /* Read "azimuth, elevation" */
+        az_deg = strtod(p, &endPtr);
+        if (endPtr == p) {
+            status = SKYSITES_BADLINE;
+            break;
+        }
+        p = endPtr;
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if (*p != ',') {
+            status = SKYSITES_BADLINE;
+            break;
+        }
+        p++;
+        el_deg = strtod(p, &endPtr);
+        if (endPtr == p) {
+            status = SKYSITES_BADLINE;
+            break;
+        }
+        p = endPtr;
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if ((*p != '\0') || (az_deg < 0.0) || (az_deg >= 360.0)
+            || (el_deg < -90.0) || (el_deg > 90.0)
+            || ((pointCount > 0) && (az_deg <= prevAz_deg))) {
+            status = SKYSITES_BADLINE;
+            break;
+        }
+
+        if (pointCount == 0) {
+            firstAz_deg = az_deg;
+            firstEl_deg = el_deg;
+        } else {
+            fillHorizon(prevAz_deg, prevEl_deg, az_deg, el_deg, elevation_deg);
+        }
+        prevAz_deg = az_deg;
+        prevEl_deg = el_deg;
+        pointCount++;
+    }
+    fclose(fp);
+
+    if ((status == SKYSITES_NORMAL) && (pointCount == 0)) {
+        status = SKYSITES_BADLINE;
+    }
+    if (status != SKYSITES_NORMAL) {
+        if (errorLine != NULL) {
+            *errorLine = lineNum;
+        }
+        return status;
+    }
+
+    /* Wrap around from the last point to the first */
+    fillHorizon(prevAz_deg, prevEl_deg, firstAz_deg + 360.0, firstEl_deg,
+                elevation_deg);
+    sky_setHorizonMask(HORIZON_POINTS, elevation_deg, mask);
+    return SKYSITES_NORMAL;
+}
+
+/*
+ *------------------------------------------------------------------------------
+ *
+ * Local functions (not called from other modules).
+ *
+ *------------------------------------------------------------------------------
+ */
+LOCAL int parseLine(const char line[], bool headerAllowed,
+                    SkySites_Record *record)
+/* Read the values from one line of the file.
+ Returns
+    SKYSITES_NORMAL if the line describes a site, LINE_IS_NOT_A_SITE if it is
+    blank, a comment, or (if headerAllowed) a heading line, otherwise
+    SKYSITES_BADLINE
+ Inputs
+    line          - the line, terminated by a null
+    headerAllowed - true if no site has been read yet, so that a line starting
+                    with something other than a number is taken to be a line
+                    of column headings
+ Outputs
+    record        - values read from the line (unchanged unless the result is
+                    SKYSITES_NORMAL)
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double      field[FIELD_COUNT];
+    const char  *p;
+    char        *endPtr;
+    int         n;                      // Number of fields read
+
+    p = line;
+    while (isspace((unsigned char)*p)) {
+        p++;
+    }
+    if ((*p == '\0') || (*p == '#')) {
+        return LINE_IS_NOT_A_SITE;
+    }
+    if (headerAllowed && !isdigit((unsigned char)*p) && (*p != '-')
+        && (*p != '+') && (*p != '.')) {
+        return LINE_IS_NOT_A_SITE;
+    }
+
+    for (n = 0; n < FIELD_COUNT; n++) {
+        field[n] = defaultField[n];
+    }
+    n = 0;
+    for (;;) {
+        field[n] = strtod(p, &endPtr);
+        if (endPtr == p) {
+            return SKYSITES_BADLINE;            // Not a number
+        }
+        n++;
+        p = endPtr;
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
+        if ((*p != ',') || (n >= FIELD_COUNT)) {
+            return SKYSITES_BADLINE;
+        }
+        p++;
+    }
+
+    /* Latitude, longitude and height are required. The others may be left
+       off the end of the line. Check the ranges, so that the site functions'
+       assertions cannot fail. */
+    if ((n < 3)
+        || (field[0] < -90.0) || (field[0] > 90.0)
+        || (field[1] < -360.0) || (field[1] > 360.0)
+        || (field[3] <= -100.0) || (field[4] < 0.0)
+        || (field[5] < -24.0) || (field[5] > 24.0)) {
+        return SKYSITES_BADLINE;
+    }
+
+    record->latitude_deg = field[0];
+    record->longitude_deg = field[1];
+    record->height_m = field[2];
+    record->temperature_degC = field[3];
+    record->pressure_hPa = field[4];
+    record->timeZone_h = field[5];
+    record->surfaceAz_deg = field[6];
+    record->surfaceSlope_deg = field[7];
+    return SKYSITES_NORMAL;
+}
+
+
+
+LOCAL void initEntry(SkySites_Entry *entry)
+/* Initialise the site and surface of one entry from its record.
+ In/Out
+    entry - field record on input; fields site and surface set on output
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    const SkySites_Record *r = &entry->record;
+
+    sky_setSiteLocation(r->latitude_deg, r->longitude_deg, r->height_m,
+                        &entry->site);
+    sky_setSiteTempPress(r->temperature_degC, r->pressure_hPa, &entry->site);
+    sky_setSiteTimeZone(r->timeZone_h, &entry->site);
+    sky_setupSiteSurface(r->surfaceAz_deg, r->surfaceSlope_deg,
+                         &entry->surface);
+}
+
+
+
+LOCAL void *initRange(void *arg)
+/* Initialise a contiguous range of entries. (This has the form of a thread
+   start routine, so that it can be run in its own thread.)
+ Returns
+    NULL
+ Inputs
+    arg - pointer to an InitJob describing the range
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    const InitJob *job = (const InitJob *)arg;
+    int     i;
+
+    for (i = 0; i < job->count; i++) {
+        initEntry(&job->first[i]);
+    }
+    return NULL;
+}
+
+
+
+LOCAL void fillHorizon(double az1_deg, double el1_deg,
+                       double az2_deg, double el2_deg,
+                       double elevation_deg[])
+/* Set the points of the horizon that lie between two points read from the
+   file, by linear interpolation.
+ Inputs
+    az1_deg, el1_deg - first point (degrees)
+    az2_deg, el2_deg - second point (degrees). az2_deg must be greater than
+                       az1_deg, but may be 360° or more if this is the segment
+                       that wraps around to the first point in the file
+ Outputs
+    elevation_deg    - elements for every whole degree of azimuth at or after
+                       az1_deg and before az2_deg (taken modulo 360°)
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  startAz_deg;
+    int     k;
+
+    startAz_deg = ceil(az1_deg);
+    for (k = (int)startAz_deg; k < az2_deg; k++) {
+        elevation_deg[k % HORIZON_POINTS] = el1_deg + (el2_deg - el1_deg)
+                                            * ((k - az1_deg)
+                                               / (az2_deg - az1_deg));
+    }
+}
+
+/*- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+/*! \page page-site-csv Site database files
+ *  Function skysites_load() reads a file of comma-separated values, with one
+ *  site per line. The values on each line are, in order
+ *      -# latitude (degrees, north positive)
+ *      -# longitude (degrees, east positive)
+ *      -# height above the ellipsoid (metres)
+ *      -# average temperature (°C) - default 10
+ *      -# average atmospheric pressure (hPa) - default 1010
+ *      -# time zone offset from UTC (hours) - default 0
+ *      -# azimuth of the surface's normal (degrees) - default 0
+ *      -# slope of the surface from horizontal (degrees) - default 0
+ *      .
+ *  The first three are required. Any of the others may be left off the end of
+ *  the line, in which case the defaults shown are used. Blank lines, and lines
+ *  whose first non-blank character is \c #, are ignored. If the first line
+ *  that is not ignored starts with something other than a number, it is taken
+ *  to be a line of column headings, and is ignored too. For example:
+ *  \verbatim
+    lat,long,height,temp,press,tz,surfAz,surfSlope
+    # Canberra fleet
+    -35.28,149.13,578,13,950,10,0,35
+    -35.31,149.19,590,13,949,10,0,35
+    \endverbatim
+ *
+ *  Values are read with \c strtod(), so the decimal point character is that
+ *  of the current locale.
+ *
+ *  Function skysites_loadHorizon() reads a file of the same form, but with
+ *  just two values on each line: an azimuth (degrees, in increasing order,
+ *  from 0 up to but not including 360) and the elevation of the horizon at
+ *  that azimuth (degrees). For example:
+ *  \verbatim
+    az,el
+    0,2.5
+    45,4.1
+    90,12.0
+    135,6.3
+    180,1.0
+    270,0.5
+    \endverbatim
+ */
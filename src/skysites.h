@@ -0,0 +1,123 @@
+#ifndef SKYSITES_H
+#define SKYSITES_H
+/*============================================================================*/
+/*! \file
+ * \brief
+ * skysites.h - load a database of observing sites from a CSV file
+ *
+ * \author  David Hoadley
+ *
+ * \details
+ *          Routines to read the details of many observing sites (for example,
+ *          the solar trackers of a fleet) from a comma-separated values file,
+ *          and to initialise a Sky_SiteProp and a surface Sky_SiteHorizon for
+ *          each of them. The sites are stored in an array supplied by the
+ *          caller, so no heap storage is used. If the macro POSIX_THREADS is
+ *          defined (see skyfast.h), the initialisation is shared among a number
+ *          of threads.
+ *
+ *          A horizon profile for a site can also be read from a file, to set
+ *          up a Sky_HorizonMask.
+ *
+ *          See \ref page-site-csv (at the end of skysites.c) for the format
+ *          of the files.
+ *
+ *==============================================================================
+ */
+/*
+ * Copyright (c) 2020, David Hoadley <vcrumble@westnet.com.au>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "sky.h"
+
+/*
+ * Global #defines and typedefs
+ */
+/*      Longest line (including the newline) that can be read from the file */
+#define SKYSITES_MAX_LINE       256
+
+/*      Largest number of threads that skysites_initEntries() will use */
+#define SKYSITES_MAX_THREADS    16
+
+/*!     The values read from one line of the file */
+typedef struct {
+    double  latitude_deg;       //!< Latitude of site (degrees, north +ve)
+    double  longitude_deg;      //!< Longitude of site (degrees, east +ve)
+    double  height_m;           //!< Height above ellipsoid (metres)
+    double  temperature_degC;   //!< Average temperature (°C)
+    double  pressure_hPa;       //!< Average atmospheric pressure (hPa)
+    double  timeZone_h;         //!< Time zone offset from UTC (hours)
+    double  surfaceAz_deg;      //!< Azimuth of surface's normal (degrees)
+    double  surfaceSlope_deg;   //!< Slope of surface from horizontal (degrees)
+} SkySites_Record;
+
+/*!     One site of the database. An array of these is the "arena" into which
+        skysites_load() reads the sites.
+    \note Field \a site contains a pointer to another part of itself, so an
+        entry must not be copied or moved once it has been initialised. */
+typedef struct {
+    SkySites_Record record;     //!< Values read from the file
+    Sky_SiteProp    site;       //!< Site properties, from sky_setSiteLocation()
+    Sky_SiteHorizon surface;    //!< Surface, from sky_setupSiteSurface()
+} SkySites_Entry;
+
+/*! Errors detected when loading a site database */
+typedef enum {
+    SKYSITES_NORMAL,        /*!< Normal successful completion */
+    SKYSITES_OPENFAIL,      /*!< File could not be opened */
+    SKYSITES_BADLINE,       /*!< A line could not be understood, or had values
+                             *   out of range */
+    SKYSITES_TOOMANY        /*!< The file has more sites than the array can
+                             *   hold */
+} SkySites_Errors;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Global functions available to be called by other modules
+ */
+int skysites_load(const char     path[],
+                  int            capacity,
+                  SkySites_Entry entries[],
+                  int            threadCount,
+                  int            *count,
+                  int            *errorLine);
+void skysites_initEntries(int            count,
+                          SkySites_Entry entries[],
+                          int            threadCount);
+int skysites_loadHorizon(const char      path[],
+                         Sky_HorizonMask *mask,
+                         int             *errorLine);
+
+/*
+ * Global variables accessible by other modules
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SKYSITES_H */
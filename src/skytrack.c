@@ -0,0 +1,363 @@
+/*==============================================================================
+ * skytrack.c - rotation angles and row-to-row shading of single-axis trackers
+ *
+ * Author:  David Hoadley
+ *
+ * Description: (see skytrack.h)
+ *
+ * Copyright (c) 2020, David Hoadley <vcrumble@westnet.com.au>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ *==============================================================================
+ */
+/*------------------------------------------------------------------------------
+ * Notes:
+ *      Character set: UTF-8. (Non-ASCII characters appear in this file)
+ *----------------------------------------------------------------------------*/
+
+/* ANSI includes etc. */
+#include "instead-of-math.h"
+
+/* Local and project includes */
+#include "skytrack.h"
+
+#include "general.h"
+
+/*
+ * Local #defines and typedefs
+ */
+DEFINE_THIS_FILE;                       // For use by REQUIRE() - assertions.
+
+/*
+ * Prototypes for local functions (not called from other modules)
+ */
+LOCAL void rowAngles(const V3D_Vector   *sunTopoV,
+                     const SkyTrack_Row *row,
+                     double             *ideal_rad,
+                     double             *rotation_rad,
+                     double             *shadedFraction);
+
+
+/*
+ * Global variables accessible by other modules
+ */
+
+
+/*
+ * Local variables (not accessed by other modules)
+ */
+
+
+/*
+ *==============================================================================
+ *
+ * Implementation
+ *
+ *==============================================================================
+ *
+ * Global functions callable by other modules
+ *
+ *------------------------------------------------------------------------------
+ */
+GLOBAL void skytrack_setupRow(double       axisAzimuth_deg,
+                              double       axisTilt_deg,
+                              double       groundCoverage,
+                              double       slopeAzimuth_deg,
+                              double       slope_deg,
+                              double       maxAngle_deg,
+                              bool         backtrack,
+                              SkyTrack_Row *row)
+/*! Set up the geometry of a row of single-axis trackers.
+ \param[in]  axisAzimuth_deg  Azimuth of the direction along the axis in which
+                              it slopes down (degrees, clockwise from North).
+                              For a horizontal axis, either direction along it
+                              may be given, but this choice sets the sign of
+                              the rotation angles (see \ref page-single-axis).
+ \param[in]  axisTilt_deg     Tilt of the axis from the horizontal (degrees)
+ \param[in]  groundCoverage   Ground coverage ratio: the width of the collectors
+                              divided by the horizontal distance between the
+                              axes of adjacent rows. Must be greater than 0
+                              and less than 1.
+ \param[in]  slopeAzimuth_deg Azimuth of the direction in which the ground
+                              slopes down (degrees)
+ \param[in]  slope_deg        Slope of the ground from the horizontal (degrees).
+                              The rows are assumed to be laid out evenly on this
+                              plane. Use 0 for flat ground.
+ \param[in]  maxAngle_deg     Limit of the rotation either way from the zero
+                              position (degrees), e.g. 60.0
+ \param[in]  backtrack        If true, the rows backtrack to avoid shading each
+                              other; if false, they track the Sun directly
+ \param[out] row              Geometry of the row, to be passed to
+                              skytrack_angles() or skytrack_anglesBatch()
+
+ \par When to call this function
+    At program initialisation time only, for each row (or group of rows with
+    the same geometry).
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    Sky_SiteHorizon normal;     // collectors' normal at zero rotation
+    Sky_SiteHorizon ground;     // normal to the ground
+    double          cosSlope;
+
+    REQUIRE((groundCoverage > 0.0) && (groundCoverage < 1.0));
+    REQUIRE_NOT_NULL(row);
+
+    /* At zero rotation, the collectors lie in the plane of the tilted axis,
+       facing towards the lower end of the axis. A positive rotation turns them
+       towards the horizontal direction 90° clockwise from the axis azimuth. */
+    sky_setupSiteSurface(axisAzimuth_deg, axisTilt_deg, &normal);
+    row->normalV = normal.rectV;
+    v3d_polarToRect(&row->crossV, degToRad(axisAzimuth_deg + 90.0), 0.0);
+
+    /* The slope of the ground across the rows is the rotation that would turn
+       the collectors to face the same way as the ground's normal */
+    sky_setupSiteSurface(slopeAzimuth_deg, slope_deg, &ground);
+    row->crossSlope_rad = atan2(v3d_dotProductV(&ground.rectV, &row->crossV),
+                                v3d_dotProductV(&ground.rectV, &row->normalV));
+    cosSlope = cos(row->crossSlope_rad);
+
+    row->axesDistance = 1.0 / (groundCoverage * cosSlope);
+    row->maxAngle_rad = degToRad(maxAngle_deg);
+    row->backtrack = backtrack;
+}
+
+
+
+GLOBAL void skytrack_angles(const V3D_Vector   *sunTopoV,
+                            const SkyTrack_Row *row,
+                            double             *ideal_rad,
+                            double             *rotation_rad,
+                            double             *shadedFraction)
+/*! Calculate the rotation angle of a row of single-axis trackers, and how much
+    of the row is shaded by its neighbour.
+ \param[in]  sunTopoV       Topocentric unit vector of the Sun, as calculated
+                            by sky_siteTirsToTopo() (field \a rectV of its
+                            \a topo argument) or sky_siteTirsToTopoV()
+ \param[in]  row            Geometry of the row, as set by skytrack_setupRow()
+ \param[out] ideal_rad      Rotation angle that would point the collectors as
+                            nearly as possible at the Sun (radian), ignoring
+                            shading and the rotation limits
+ \param[out] rotation_rad   Rotation angle to be commanded (radian). This is
+                            the backtracking angle if the row backtracks and the
+                            ideal angle would cause shading, limited to the
+                            range set by \a maxAngle_deg of skytrack_setupRow().
+                            Zero (collectors flat, or in the plane of the axis)
+                            while the Sun is below the horizon.
+ \param[out] shadedFraction Fraction of the width of the collectors that is in
+                            the shadow of the adjacent row, at \a rotation_rad.
+                            0.0 if none is shaded, 1.0 if all is (which includes
+                            when the Sun is below the horizon or behind the
+                            collectors).
+
+ \par When to call this function
+    Each time around your main loop, after calculating the Sun's position. If
+    you have many rows, call skytrack_anglesBatch() instead.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    REQUIRE_NOT_NULL(sunTopoV);
+    REQUIRE_NOT_NULL(row);
+    REQUIRE_NOT_NULL(ideal_rad);
+    REQUIRE_NOT_NULL(rotation_rad);
+    REQUIRE_NOT_NULL(shadedFraction);
+
+    rowAngles(sunTopoV, row, ideal_rad, rotation_rad, shadedFraction);
+}
+
+
+
+GLOBAL void skytrack_anglesBatch(int                count,
+                                 const SkyTrack_Row rows[],
+                                 const V3D_Vector   *sunTopoV,
+                                 double             ideal_rad[],
+                                 double             rotation_rad[],
+                                 double             shadedFraction[])
+/*! Calculate the rotation angles and shaded fractions for a number of rows of
+    single-axis trackers, all seeing the Sun in the same direction. The results
+    are the same as calling skytrack_angles() for each row.
+ \param[in]  count          Number of rows
+ \param[in]  rows           Array of \a count row geometries, as set by
+                            skytrack_setupRow()
+ \param[in]  sunTopoV       Topocentric unit vector of the Sun, as for
+                            skytrack_angles()
+ \param[out] ideal_rad      Array of \a count ideal rotation angles (radian)
+ \param[out] rotation_rad   Array of \a count rotation angles to be commanded
+                            (radian)
+ \param[out] shadedFraction Array of \a count shaded fractions
+
+ \par When to call this function
+    Each time around your main loop, for a field of trackers, after calculating
+    the Sun's position. The rows must be close enough together that the Sun is
+    in the same direction from all of them - usually this means within a few
+    kilometres. (If not, calculate the Sun's position for each group of rows
+    and call this function for each group.)
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    int     i;
+
+    REQUIRE(count >= 0);
+    REQUIRE_NOT_NULL(rows);
+    REQUIRE_NOT_NULL(sunTopoV);
+    REQUIRE_NOT_NULL(ideal_rad);
+    REQUIRE_NOT_NULL(rotation_rad);
+    REQUIRE_NOT_NULL(shadedFraction);
+
+    for (i = 0; i < count; i++) {
+        rowAngles(sunTopoV,
+                  &rows[i],
+                  &ideal_rad[i],
+                  &rotation_rad[i],
+                  &shadedFraction[i]);
+    }
+}
+
+
+
+/*
+ *------------------------------------------------------------------------------
+ *
+ * Local functions (not called from other modules).
+ *
+ *------------------------------------------------------------------------------
+ */
+LOCAL void rowAngles(const V3D_Vector   *sunTopoV,
+                     const SkyTrack_Row *row,
+                     double             *ideal_rad,
+                     double             *rotation_rad,
+                     double             *shadedFraction)
+/* Calculate the rotation angles and shaded fraction for one row. This is the
+   common code of skytrack_angles() and skytrack_anglesBatch().
+ Inputs
+    sunTopoV       - topocentric unit vector of the Sun
+    row            - geometry of the row
+ Outputs
+    ideal_rad      - true-tracking rotation angle (radian)
+    rotation_rad   - rotation angle, backtracked and limited (radian)
+    shadedFraction - fraction of the collectors' width that is shaded
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  ideal;              // true-tracking angle (θT)
+    double  rotation;           // rotation angle to command (θ)
+    double  cosGap;             // cosine of the Sun's angle from the slope
+    double  cosAoi;             // cos of the Sun's angle from collectors' normal
+    double  shaded;
+
+    /* The ideal angle is the angle of the Sun, in the plane perpendicular to
+       the axis, from the collectors' normal at zero rotation */
+    ideal = atan2(v3d_dotProductV(sunTopoV, &row->crossV),
+                  v3d_dotProductV(sunTopoV, &row->normalV));
+    *ideal_rad = ideal;
+
+    if (sunTopoV->a[2] <= 0.0) {
+        /* Sun is below the horizon. Leave the row at its zero position */
+        *rotation_rad = 0.0;
+        *shadedFraction = 1.0;
+        return;
+    }
+
+    /* The shadow of the adjacent row just reaches this row when
+       cos(θ - θT) = axesDistance * |cos(θT - βc)| (Anderson & Mikofski, 2020).
+       The magnitude matters when |θT - βc| > 90° (a tilted axis, or a low Sun
+       over sloping ground): without it, the row would be turned back past the
+       Sun, rather than towards the plane of the ground. */
+    cosGap = fabs(row->axesDistance * cos(ideal - row->crossSlope_rad));
+    rotation = ideal;
+    if (row->backtrack && (cosGap < 1.0)) {
+        if (ideal >= 0.0) {
+            rotation = ideal - acos(cosGap);
+        } else {
+            rotation = ideal + acos(cosGap);
+        }
+    }
+    if (rotation > row->maxAngle_rad) {
+        rotation = row->maxAngle_rad;
+    } else if (rotation < -row->maxAngle_rad) {
+        rotation = -row->maxAngle_rad;
+    }
+    *rotation_rad = rotation;
+
+    /* Seen along the Sun's rays, this row and the adjacent one each span
+       cos(θ - θT) collector widths, and their centres are cosGap apart */
+    cosAoi = cos(rotation - ideal);
+    if (cosAoi <= 0.0) {
+        shaded = 1.0;                   // Sun is behind the collectors
+    } else {
+        shaded = 1.0 - cosGap / cosAoi;
+        if (shaded < 0.0) {
+            shaded = 0.0;
+        } else if (shaded > 1.0) {
+            shaded = 1.0;
+        }
+    }
+    *shadedFraction = shaded;
+}
+
+/*- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+/*! \page page-single-axis Single-axis trackers
+ *  A single-axis tracker turns a row of collectors about one axis, usually
+ *  running north-south, so that they follow the Sun from east to west. The
+ *  skytrack module uses these conventions:
+ *      - The axis points in azimuth γa, tilted down by βa from the horizontal.
+ *        At zero rotation the collectors lie in the plane of the axis, so
+ *        they face azimuth γa, tilted by βa. (For a horizontal axis, they are
+ *        flat.)
+ *      - A positive rotation θ turns the collectors towards the horizontal
+ *        direction 90° clockwise from γa. For example, with γa = 180° (the
+ *        axis running north-south, and either horizontal or sloping down to
+ *        the south), positive angles face west, i.e. the afternoon Sun. With
+ *        γa = 0°, positive angles face east.
+ *      - The ground coverage ratio (GCR) is the collector width divided by
+ *        the horizontal distance between the axes of adjacent rows.
+ *      - The cross-axis slope βc is the slope of the ground in the plane
+ *        perpendicular to the axes, positive if the ground falls away in the
+ *        direction that positive rotations face. skytrack_setupRow()
+ *        calculates it from the slope and azimuth of the ground.
+ *
+ *  If the Sun's direction, projected onto the plane perpendicular to the axis,
+ *  is at angle θT from the collectors' normal at zero rotation, then θT is the
+ *  ideal (true-tracking) rotation angle. When the Sun is low, rows tracking the
+ *  Sun shade their neighbours. Backtracking turns each row back, away from the
+ *  Sun, just far enough that no shading occurs:
+ *
+ *      θ = θT − sign(θT)·acos(d·|cos(θT − βc)|), where d = 1 / (GCR·cos βc)
+ *
+ *  whenever d·|cos(θT − βc)| < 1. This is the method of K. Anderson and M.
+ *  Mikofski, "Slope-Aware Backtracking for Single-Axis Trackers", NREL
+ *  Technical Report NREL/TP-5K00-76626 (2020), which extends that of
+ *  W. Marion and A. Dobos, "Rotation Angle for the Optimum Tracking of
+ *  One-Axis Trackers", NREL/TP-6A20-58891 (2013), to sloping ground. (As in
+ *  pvlib, the magnitude of the cosine is taken, for the case |θT − βc| > 90°
+ *  that can arise with a tilted axis or a low Sun over sloping ground.)
+ *
+ *  The shaded fraction is 1 − d·|cos(θT − βc)| / cos(θ − θT), limited to the
+ *  range 0 to 1. It is zero when a backtracking row is not at its rotation
+ *  limit, so it is mainly of interest for rows that do not backtrack, and for
+ *  rows that have reached their limit early or late in the day.
+ *
+ *  These calculations assume that the rows are long (so that shading of their
+ *  ends can be ignored) and are laid out evenly on a plane.
+ *  skytrack_anglesBatch() does the same work for many rows, with the one
+ *  vector for the Sun's position shared among them, so there is no
+ *  per-row call to the routines that calculate the Sun's position.
+ */
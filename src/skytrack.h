@@ -0,0 +1,108 @@
+#ifndef SKYTRACK_H
+#define SKYTRACK_H
+/*============================================================================*/
+/*! \file
+ * \brief
+ * skytrack.h - rotation angles and row-to-row shading of single-axis trackers
+ *
+ * \author  David Hoadley
+ *
+ * \details
+ *          Routines to find, for rows of single-axis solar trackers, the
+ *          rotation angle that points the collectors most nearly at the Sun
+ *          (true tracking), the angle that avoids one row shading the next
+ *          (backtracking), and the fraction of each row's width that is in the
+ *          shadow of the row in front of it.
+ *
+ *          The geometry of each row (the azimuth and tilt of its axis, the
+ *          ground coverage ratio and the slope of the ground) is set up once
+ *          by skytrack_setupRow(). Then, each time around the main loop, the
+ *          Sun's topocentric direction vector (from sky_siteTirsToTopo() or
+ *          sun_nrelTopocentric()) is used for every row, with
+ *          skytrack_angles() or skytrack_anglesBatch(). See
+ *          \ref page-single-axis (at the end of skytrack.c) for the geometry
+ *          and the sign conventions.
+ *
+ *==============================================================================
+ */
+/*
+ * Copyright (c) 2020, David Hoadley <vcrumble@westnet.com.au>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "sky.h"
+
+/*
+ * Global #defines and typedefs
+ */
+/*!     The geometry of one row of single-axis trackers, as set up by
+        skytrack_setupRow() */
+typedef struct {
+    V3D_Vector  crossV;         /*!< Horizontal unit vector, perpendicular to
+                                     the axis, towards which a positive
+                                     rotation turns the collectors */
+    V3D_Vector  normalV;        /*!< Unit normal of the collectors at zero
+                                     rotation */
+    double      crossSlope_rad; //!< Slope of the ground across the rows (βc)
+    double      axesDistance;   /*!< Distance between the axes of adjacent
+                                     rows, in units of the collector width */
+    double      maxAngle_rad;   //!< Limit of rotation either way (radian)
+    bool        backtrack;      //!< Whether the row backtracks
+} SkyTrack_Row;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Global functions available to be called by other modules
+ */
+void skytrack_setupRow(double       axisAzimuth_deg,
+                       double       axisTilt_deg,
+                       double       groundCoverage,
+                       double       slopeAzimuth_deg,
+                       double       slope_deg,
+                       double       maxAngle_deg,
+                       bool         backtrack,
+                       SkyTrack_Row *row);
+void skytrack_angles(const V3D_Vector   *sunTopoV,
+                     const SkyTrack_Row *row,
+                     double             *ideal_rad,
+                     double             *rotation_rad,
+                     double             *shadedFraction);
+void skytrack_anglesBatch(int                count,
+                          const SkyTrack_Row rows[],
+                          const V3D_Vector   *sunTopoV,
+                          double             ideal_rad[],
+                          double             rotation_rad[],
+                          double             shadedFraction[]);
+
+/*
+ * Global variables accessible by other modules
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SKYTRACK_H */
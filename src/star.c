@@ -329,11 +329,38 @@ GLOBAL void star_getApparent(double j2kTT_cy, Sky_TrueEquatorial *pos)
     skyfast_backgroundUpdate() functions in a tracking application.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 {
+    star_getApparentOf(&currentObject, j2kTT_cy, pos);
+}
+
+
+
+GLOBAL void star_getApparentOf(const void         *catalogPosn,
+                               double             j2kTT_cy,
+                               Sky_TrueEquatorial *pos)
+/*! Calculate the position of a specified star (or other object outside the
+    solar system) as a unit vector and a distance, in apparent coordinates.
+    This is the same as star_getApparent(), except that the star is specified
+    by the caller instead of by star_setCurrentObject().
+ \param[in]  catalogPosn  Catalogue position of the star. This is a pointer to
+                          a struct of type Star_CatalogPosn, passed as a
+                          generic pointer so that this function can be passed
+                          to skyfast_ctxInitObject().
+ \param[in]  j2kTT_cy     Julian centuries since J2000.0, TT timescale
+ \param[out] pos          Timestamped structure containing position data in
+                          apparent coordinates and the equation of the
+                          equinoxes.
+
+    Use this function with skyfast_ctxInitObject() to track several stars at
+    once, one context per star.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    const Star_CatalogPosn *c = (const Star_CatalogPosn *)catalogPosn;
     Sky1_Nut1980    nut;
 
+    REQUIRE_NOT_NULL(catalogPosn);
     REQUIRE_NOT_NULL(pos);
 
-    if (currentObject.cSys == INTERMEDIATE) {
+    if (c->cSys == INTERMEDIATE) {
         pos->eqEq_rad = 0.0;
 
     } else {
@@ -344,8 +371,7 @@ GLOBAL void star_getApparent(double j2kTT_cy, Sky_TrueEquatorial *pos)
         pos->eqEq_rad = nut.eqEq_rad;
     }
 
-    star_catalogToApp(&currentObject, j2kTT_cy, &nut,
-                      &pos->appCirsV, &pos->distance_au);
+    star_catalogToApp(c, j2kTT_cy, &nut, &pos->appCirsV, &pos->distance_au);
 
     /* Now set the timestamp*/
     pos->timestamp_cy = j2kTT_cy;
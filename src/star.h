@@ -134,6 +134,9 @@ void star_catalogToApp(const Star_CatalogPosn *c,
                        V3D_Vector *appV,
                        double     *dist_au);
 void star_getApparent(double j2kTT_cy, Sky_TrueEquatorial *pos);
+void star_getApparentOf(const void         *catalogPosn,
+                        double             j2kTT_cy,
+                        Sky_TrueEquatorial *pos);
 void star_getTopocentric(double             j2kUtc_d,
                          const Sky_DeltaTs  *deltas,
                          const Sky_SiteProp *site,
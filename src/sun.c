@@ -38,7 +38,7 @@
 
 /* ANSI includes etc. */
 #include <float.h>
-#include "instead-of-math.h"            /* for normalize() */
+#include "instead-of-math.h"            /* for sincos() & normalize() */
 
 /* Local and project includes */
 #include "sun.h"
@@ -52,11 +52,26 @@
  */
 DEFINE_THIS_FILE;                       // For use by REQUIRE() - assertions.
 
+/*      Unrefracted elevation of the Sun's centre at rise and set: -50′, from a
+        refraction of 34′ at the horizon and a semi-diameter of 16′ */
+#define SUN_RISESET_EL_RAD      (-50.0 / 60.0 * DEG2RAD)
+#define SUN_SEMIDIAMETER_RAD    (16.0 / 60.0 * DEG2RAD)
+
+/*      Limits on the iterations of sun_riseSetMask() after the first
+        estimate */
+#define MASK_ITERATIONS         10
+#define MASK_TOLERANCE_d        (0.1 / 86400.0)
+
 /*      Constants from NREL SPA algorithm */
 #define L_COUNT 6
 #define B_COUNT 2
 #define R_COUNT 5
 
+/* Maximum number of times evaluated together by the series functions. Each
+   term of the series is applied to all of the times before moving on to the
+   next term, so the inner loops run over contiguous arrays of this length. */
+#define SUN_BATCH_LANES 8
+
 typedef struct {
     double a;       // term A in (A * cos(B + C * t)). (called TERM_A in SPA)
     double cb;      // term B in (A * cos(B + C * t)). (called TERM_B in SPA)
@@ -67,9 +82,32 @@ typedef struct {
 /*
  * Prototypes for local functions (not called from other modules).
  */
-LOCAL double sunLongitude(double t_ka);
-LOCAL double sunLatitude(double t_ka);
-LOCAL double sunDistance(double t_ka);
+LOCAL void sunLongitude(int          count,
+                        const double t_ka[],
+                        const int    terms[],
+                        double lambda_rad[]);
+LOCAL void sunLatitude(int          count,
+                       const double t_ka[],
+                       const int    terms[],
+                       double beta_rad[]);
+LOCAL void sunDistance(int          count,
+                       const double t_ka[],
+                       const int    terms[],
+                       double dist_au[]);
+LOCAL double seriesPolynomial(int count, const double sum[], double t_ka);
+LOCAL void sweepSeries(int             seriesCount,
+                       const SunSeries *const st[],
+                       const int       subcount[],
+                       Sun_Sweep *sweep,
+                       int       *term,
+                       double    sum[]);
+LOCAL void sweepReseed(Sun_Sweep *sweep);
+LOCAL void nutationAndObliquity(double j2kTT_cy, Sky0_Nut1980 *nut);
+LOCAL void eclipticToApparent(double             lambda_rad,
+                              double             beta_rad,
+                              double             dist_au,
+                              const Sky0_Nut1980 *nut,
+                              V3D_Vector *appV);
 LOCAL double solarNoonApprox(double             noonGuess_d,
                              const Sky_DeltaTs  *deltas,
                              const Sky_SiteProp *site,
@@ -78,7 +116,9 @@ LOCAL double riseSetApprox(double             risesetGuess_d,
                            bool               getSunrise,
                            const Sky_DeltaTs  *deltas,
                            const Sky_SiteProp *site,
-                           Sky_SiteHorizon *topo);
+                           const Sky_HorizonMask *mask,
+                           Sky_SiteHorizon *topo,
+                           bool               *found);
 
 /*
  * Global variables accessible by other modules 
@@ -88,7 +128,296 @@ LOCAL double riseSetApprox(double             risesetGuess_d,
 /*
  * Local variables (not accessed by other modules)
  */
-/*      (none) */
+/*      Data tables from NREL SPA algorithm */
+/*          Periodic terms for the Sun's ecliptic longitude */
+LOCAL const SunSeries l0[] = {
+    {175347046.0, 0, 0},
+    {  3341656.0, 4.6692568, 6283.07585},
+    {    34894.0, 4.6261,   12566.1517 },
+    {3497.0, 2.7441,  5753.3849},
+    {3418.0, 2.8289,     3.5231},
+    {3136.0, 3.6277, 77713.7715},
+    {2676.0, 4.4181,  7860.4194},
+    {2343.0, 6.1352,  3930.2097},
+    {1324.0, 0.7425, 11506.7698},
+    {1273.0, 2.0371,   529.691 },
+    {1199.0, 1.1096,  1577.3435},
+    {990, 5.233,  5884.927},
+    {902, 2.045,    26.298},
+    {857, 3.508,   398.149},
+    {780, 1.179,  5223.694},
+    {753, 2.533,  5507.553},
+    {505, 4.583, 18849.228},
+    {492, 4.205,   775.523},
+    {357, 2.92,      0.067},
+    {317, 5.849, 11790.629},
+    {284, 1.899,   796.298},
+    {271, 0.315, 10977.079},
+    {243, 0.345,  5486.778},
+    {206, 4.806,  2544.314},
+    {205, 1.869,  5573.143},
+    {202, 2.458,  6069.777},
+    {156, 0.833,   213.299},
+    {132, 3.411,  2942.463},
+    {126, 1.083,    20.775},
+    {115, 0.645,     0.98 },
+    {103, 0.636,  4694.003},
+    {102, 0.976, 15720.839},
+    {102, 4.267,     7.114},
+    { 99, 6.21,   2146.17},
+    { 98, 0.68,    155.42},
+    { 86, 5.98, 161000.69},
+    { 85, 1.3,    6275.96},
+    { 85, 3.67,  71430.7 },
+    { 80, 1.81,  17260.15},
+    { 79, 3.04,  12036.46},
+    { 75, 1.76,   5088.63},
+    { 74, 3.5,    3154.69},
+    { 74, 4.68,    801.82},
+    { 70, 0.83,   9437.76},
+    { 62, 3.98,   8827.39},
+    { 61, 1.82,   7084.9 },
+    { 57, 2.78,   6286.6 },
+    { 56, 4.39,  14143.5 },
+    { 56, 3.47,   6279.55},
+    { 52, 0.19,  12139.55},
+    { 52, 1.33,   1748.02},
+    { 51, 0.28,   5856.48},
+    { 49, 0.49,   1194.45},
+    { 41, 5.37,   8429.24},
+    { 41, 2.4,   19651.05},
+    { 39, 6.17,  10447.39},
+    { 37, 6.04,  10213.29},
+    { 37, 2.57,   1059.38},
+    { 36, 1.71,   2352.87},
+    { 36, 1.78,   6812.77},
+    { 33, 0.59,  17789.85},
+    { 30, 0.44,  83996.85},
+    { 30, 2.74,   1349.87},
+    { 25, 3.16,   4690.48}
+};
+LOCAL const SunSeries l1[] = {
+    {628331966747.0, 0,     0},
+    {206059.0, 2.678235, 6283.07585},
+    {4303.0,   2.6351,  12566.1517},
+    {425.0,    1.59,        3.523},
+    {119.0,    5.796,      26.298},
+    {109.0,    2.966,    1577.344},
+    {93, 2.59, 18849.23},
+    {72, 1.14,   529.69},
+    {68, 1.87,   398.15},
+    {67, 4.41,  5507.55},
+    {59, 2.89,  5223.69},
+    {56, 2.17,   155.42},
+    {45, 0.4,    796.3 },
+    {36, 0.47,   775.52},
+    {29, 2.65,     7.11},
+    {21, 5.34,     0.98},
+    {19, 1.85,  5486.78},
+    {19, 4.97,   213.3 },
+    {17, 2.99,  6275.96},
+    {16, 0.03,  2544.31},
+    {16, 1.43,  2146.17},
+    {15, 1.21, 10977.08},
+    {12, 2.83,  1748.02},
+    {12, 3.26,  5088.63},
+    {12, 5.27,  1194.45},
+    {12, 2.08,  4694   },
+    {11, 0.77,   553.57},
+    {10, 1.3,   6286.6 },
+    {10, 4.24,  1349.87},
+    { 9, 2.7,    242.73},
+    { 9, 5.64,   951.72},
+    { 8, 5.3,   2352.87},
+    { 6, 2.65,  9437.76},
+    { 6, 4.67,  4690.48}
+};
+LOCAL const SunSeries l2[] = {
+    {52919.0, 0,         0},
+    { 8720.0, 1.0721, 6283.0758},
+    {  309.0, 0.867, 12566.152},
+    {27, 0.05,    3.52 },
+    {16, 5.19,    26.3 },
+    {16, 3.68,   155.42},
+    {10, 0.76, 18849.23},
+    { 9, 2.06, 77713.77},
+    { 7, 0.83,   775.52},
+    { 5, 4.66,  1577.34},
+    { 4, 1.03,     7.11},
+    { 4, 3.44,  5573.14},
+    { 3, 5.14,   796.3 },
+    { 3, 6.05,  5507.55},
+    { 3, 1.19,   242.73},
+    { 3, 6.12,   529.69},
+    { 3, 0.31,   398.15},
+    { 3, 2.28,   553.57},
+    { 2, 4.38,  5223.69},
+    { 2, 3.75,     0.98}
+};
+LOCAL const SunSeries l3[] = {
+    {289.0, 5.844, 6283.076},
+    {35, 0,        0},
+    {17, 5.49, 12566.15},
+    { 3, 5.2,    155.42},
+    { 1, 4.72,     3.52},
+    { 1, 5.3,  18849.23},
+    { 1, 5.97,   242.73}
+};
+LOCAL const SunSeries l4[] = {
+    {114.0, 3.142, 0},
+    {8, 4.13,  6283.08},
+    {1, 3.84, 12566.15}
+};
+LOCAL const SunSeries l5[] = {
+    {1, 3.14, 0}
+};
+/*          Allow access to l0..l5 as if they form a single array lt[][] */
+LOCAL const SunSeries *const lt[L_COUNT] = { l0, l1, l2, l3, l4, l5 };
+LOCAL const int lSubcount[L_COUNT] = { ARRAY_SIZE(l0),
+                                       ARRAY_SIZE(l1),
+                                       ARRAY_SIZE(l2),
+                                       ARRAY_SIZE(l3),
+                                       ARRAY_SIZE(l4),
+                                       ARRAY_SIZE(l5)};
+
+/*          Periodic terms for the Sun's ecliptic latitude */
+LOCAL const SunSeries b0[] = {
+    {280.0, 3.199, 84334.662},
+    {102.0, 5.422, 5507.553},
+    { 80.0, 3.88,  5223.69},
+    { 44.0, 3.7,   2352.87},
+    { 32.0, 4.0,   1577.34}
+};
+LOCAL const SunSeries b1[] = {
+    {9.0, 3.9,  5507.55},
+    {6.0, 1.73, 5223.69}
+};
+/*          Allow access to b0..b1 as if they form a single array bt[][] */
+LOCAL const SunSeries *const bt[B_COUNT] = { b0, b1 };
+LOCAL const int bSubcount[B_COUNT] = { ARRAY_SIZE(b0),
+                                       ARRAY_SIZE(b1) };
+
+/*          Periodic terms for the Earth - Sun distance */
+LOCAL const SunSeries r0[] = {
+    {100013989.0, 0.0, 0.0},
+    {1670700.0, 3.0984635, 6283.07585},
+    {13956.0,   3.05525,  12566.1517},
+    {3084.0, 5.1985, 77713.7715},
+    {1628.0, 1.1739, 5753.3849},
+    {1576.0, 2.8469, 7860.4194},
+    { 925.0, 5.453, 11506.77},
+    { 542.0, 4.564,  3930.21},
+    { 472.0, 3.661,  5884.927},
+    { 346.0, 0.964,  5507.553},
+    { 329.0, 5.9,    5223.694},
+    { 307.0, 0.299,  5573.143},
+    { 243.0, 4.273, 11790.629},
+    { 212.0, 5.847,  1577.344},
+    { 186.0, 5.022, 10977.079},
+    { 175.0, 3.012, 18849.228},
+    { 110.0, 5.055,  5486.778},
+    {  98.0, 0.89,   6069.78},
+    {  86.0, 5.69,  15720.84},
+    {  86.0, 1.27, 161000.69},
+    {  65.0, 0.27,  17260.15},
+    {  63.0, 0.92,    529.69},
+    {  57.0, 2.01,  83996.85},
+    {  56.0, 5.24,  71430.7},
+    {  49.0, 3.25,   2544.31},
+    {  47.0, 2.58,    775.52},
+    {  45.0, 5.54,   9437.76},
+    {  43.0, 6.01,   6275.96},
+    {  39.0, 5.36,   4694.0},
+    {  38.0, 2.39,   8827.39},
+    {  37.0, 0.83,  19651.05},
+    {  37.0, 4.9,   12139.55},
+    {  36.0, 1.67,  12036.46},
+    {  35.0, 1.84,   2942.46},
+    {  33.0, 0.24,   7084.9},
+    {  32.0, 0.18,   5088.63},
+    {  32.0, 1.78,    398.15},
+    {  28.0, 1.21,   6286.6},
+    {  28.0, 1.9,    6279.55},
+    {  26.0, 4.59,  10447.39}
+};
+LOCAL const SunSeries r1[] = {
+    {103019.0, 1.10749, 6283.07585},
+    {  1721.0, 1.0644, 12566.1517},
+    {702.0, 3.142,    0.0 },
+    { 32.0, 1.02, 18849.23},
+    { 31.0, 2.84,  5507.55},
+    { 25.0, 1.32,  5223.69},
+    { 18.0, 1.42,  1577.34},
+    { 10.0, 5.91, 10977.08},
+    {  9.0, 1.42,  6275.96},
+    {  9.0, 0.27,  5486.78}
+};
+LOCAL const SunSeries r2[] = {
+    {4359.0, 5.7846, 6283.0758},
+    { 124.0, 5.579, 12566.152},
+    {  12.0, 3.14,      0.0 },
+    {   9.0, 3.63,  77713.77},
+    {   6.0, 1.87,   5573.14},
+    {   3.0, 5.47,  18849.23}
+};
+LOCAL const SunSeries r3[] = {
+    {145.0, 4.273, 6283.076},
+    {  7.0, 3.92, 12566.15 }
+};
+LOCAL const SunSeries r4[] = {
+    {4.0, 2.56, 6283.08}
+};
+/*          Allow access to r0..r4 as if they form a single array rt[][] */
+LOCAL const SunSeries *const rt[R_COUNT] = { r0, r1, r2, r3, r4 };
+LOCAL const int rSubcount[R_COUNT] = { ARRAY_SIZE(r0),
+                                       ARRAY_SIZE(r1),
+                                       ARRAY_SIZE(r2),
+                                       ARRAY_SIZE(r3),
+                                       ARRAY_SIZE(r4)};
+
+/*          Number of rows of each table used at each precision level (see
+            sun_nrelApp2()). At levels 1 to 4, the terms omitted are those
+            whose amplitude, multiplied by the power of t_ka that applies to
+            them at t_ka = 0.1 (i.e. 1900 or 2100), is less than 50, 100, 500
+            and 2000 units of the 8th decimal place respectively. The tables
+            are sorted by amplitude, so the terms used are always the first
+            rows of each table. */
+LOCAL const int lTerms[][L_COUNT] = {
+    { ARRAY_SIZE(l0), ARRAY_SIZE(l1), ARRAY_SIZE(l2),
+      ARRAY_SIZE(l3), ARRAY_SIZE(l4), ARRAY_SIZE(l5) },
+    { 52, 3, 2, 0, 0, 0 },
+    { 33, 3, 1, 0, 0, 0 },
+    { 17, 2, 1, 0, 0, 0 },
+    {  8, 2, 0, 0, 0, 0 }
+};
+LOCAL const int bTerms[][B_COUNT] = {
+    { ARRAY_SIZE(b0), ARRAY_SIZE(b1) },
+    { 3, 0 },
+    { 2, 0 },
+    { 0, 0 },
+    { 0, 0 }
+};
+LOCAL const int rTerms[][R_COUNT] = {
+    { ARRAY_SIZE(r0), ARRAY_SIZE(r1), ARRAY_SIZE(r2),
+      ARRAY_SIZE(r3), ARRAY_SIZE(r4) },
+    { 24, 3, 0, 0, 0 },
+    { 17, 2, 0, 0, 0 },
+    {  8, 1, 0, 0, 0 },
+    {  4, 1, 0, 0, 0 }
+};
+static_assert((ARRAY_SIZE(lTerms) == SUN_PRECISION_LEVELS)
+              && (ARRAY_SIZE(bTerms) == SUN_PRECISION_LEVELS)
+              && (ARRAY_SIZE(rTerms) == SUN_PRECISION_LEVELS),
+              "precision tables must have SUN_PRECISION_LEVELS rows");
+
+/*          Precision level set by sun_setPrecision() */
+LOCAL int sunPrecision = 0;
+
+static_assert(ARRAY_SIZE(l0) + ARRAY_SIZE(l1) + ARRAY_SIZE(l2) + ARRAY_SIZE(l3)
+              + ARRAY_SIZE(l4) + ARRAY_SIZE(l5) + ARRAY_SIZE(b0) + ARRAY_SIZE(b1)
+              + ARRAY_SIZE(r0) + ARRAY_SIZE(r1) + ARRAY_SIZE(r2) + ARRAY_SIZE(r3)
+              + ARRAY_SIZE(r4) == SUN_SERIES_TERM_COUNT,
+              "SUN_SERIES_TERM_COUNT does not match the series tables");
 
 
 /*
@@ -145,7 +474,33 @@ GLOBAL void sun_aaApparentApprox(double n,
 
 
 
+GLOBAL void sun_setPrecision(int precision)
+/*! Stores the selected precision level in internal storage for later use by
+    sun_nrelApparent(), sun_nrelApparentBatch() and sun_nrelTopocentric() (and
+    so by the functions that call them, such as sun_riseSet() and
+    skyfast_init() when passed sun_nrelApparent()).
+ \param[in]  precision  Precision level, as for sun_nrelApp2(). 0 (full
+                        precision) is the default. Values outside the range
+                        [0, 4] will be clamped to the range.
+
+ \par When to call this function
+    At program initialisation time, if full precision (about 1 arcsecond) is
+    more than you need. For example, a heliostat field needing about 10
+    arcseconds can use level 3, which evaluates the Sun's position series about
+    5 times faster. See \ref page-sun-precision.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    if (precision < 0) { precision = 0; }
+    if (precision >= SUN_PRECISION_LEVELS) {
+        precision = SUN_PRECISION_LEVELS - 1;
+    }
+    sunPrecision = precision;
+}
+
+
+
 GLOBAL void sun_nrelApp2(double             t_cy,
+                         int                precision,
                          const Sky0_Nut1980 *nut,
                          V3D_Vector *appV,
                          double     *dist_au)
@@ -155,6 +510,16 @@ GLOBAL void sun_nrelApp2(double             t_cy,
     than the approximate algorithm from the _Astronomical Almanac_ implemented
     by the routine sun_aaApparentApprox().
  \param[in]  t_cy     Julian centuries since J2000.0, TT timescale
+ \param[in]  precision  How much precision do you want?
+                      Valid range [0, 4]. Values outside this range will be
+                      clamped to the range. The errors listed are the largest
+                      differences from the full series found between 1900 and
+                      2100 (see \ref page-sun-precision).
+                    - 0 = full precision, use full 195-term series
+                    - 1 = 87-term series, errors up to 0.7 arcseconds
+                    - 2 = 58-term series, errors up to 1.8 arcseconds
+                    - 3 = 29-term series, errors up to 4.6 arcseconds
+                    - 4 = 15-term series, errors up to 15 arcseconds
  \param[in]  nut      Nutation terms and obliquity of the ecliptic, as returned
                       by functions sky0_nutationSpa() and sky0_epsilonSpa().
 
@@ -177,33 +542,24 @@ GLOBAL void sun_nrelApp2(double             t_cy,
     double      t_ka;       // Millennia since J2000.0, TT timescale (J2KM)
     double      lambda_rad; // Sun longitude
     double      beta_rad;   // Sun latitude
-    V3D_Matrix  epsM;       // Rotation by obliquity of ecliptic
-    V3D_Vector  eclipV;     // Sun position in rectangular ecliptic coordinates
 
+    REQUIRE_NOT_NULL(nut);
     REQUIRE_NOT_NULL(appV);
     REQUIRE_NOT_NULL(dist_au);
 
+    if (precision < 0) { precision = 0; }
+    if (precision >= SUN_PRECISION_LEVELS) {
+        precision = SUN_PRECISION_LEVELS - 1;
+    }
     t_ka = t_cy / 10.0;
 
     /* Calculate Sun longitude, latitude and distance from tables (steps 3.2 and
        3.3 of the algorithm in the SPA document). */
-    *dist_au = sunDistance(t_ka);
-    beta_rad = sunLatitude(t_ka);
-    lambda_rad = sunLongitude(t_ka);
-
-    /* Calculate the apparent longitude (in ecliptic coordinates), using the
-       nutation in longitude and the light-time aberration correction. (The
-       apparent longitude is the Sun's position 499 seconds earlier than the
-       geometric position, because it took light that much time to reach Earth.)
-       This is steps 3.6 and 3.7 of the SPA algorithm. */
-    lambda_rad += nut->dPsi_rad - arcsecToRad(20.4898) / *dist_au;
-
-    /* Convert to rectangular coordinates */
-    v3d_polarToRect(&eclipV, lambda_rad, beta_rad);
+    sunDistance(1, &t_ka, rTerms[precision], dist_au);
+    sunLatitude(1, &t_ka, bTerms[precision], &beta_rad);
+    sunLongitude(1, &t_ka, lTerms[precision], &lambda_rad);
 
-    /* Rotate from ecliptic to equatorial coordinates */
-    v3d_createRotationMatrix(&epsM, Xaxis, -(nut->eps0_rad + nut->dEps_rad));
-    v3d_multMxV(appV, &epsM, &eclipV);
+    eclipticToApparent(lambda_rad, beta_rad, *dist_au, nut, appV);
 }
 
 
@@ -255,7 +611,8 @@ GLOBAL void sun_nrelApparent(double j2kTT_cy, Sky_TrueEquatorial *pos)
     pos->eqEq_rad = nut.eqEq_rad;
 
     /* Calculate sun apparent position */
-    sun_nrelApp2(j2kTT_cy, &nut, &pos->appCirsV, &pos->distance_au);
+    sun_nrelApp2(j2kTT_cy, sunPrecision, &nut, &pos->appCirsV,
+                 &pos->distance_au);
 
     /* Now set the timestamp*/
     pos->timestamp_cy = j2kTT_cy;
@@ -263,6 +620,240 @@ GLOBAL void sun_nrelApparent(double j2kTT_cy, Sky_TrueEquatorial *pos)
 
 
 
+GLOBAL void sun_nrelApparentBatch(int                count,
+                                  const double       j2kTT_cy[],
+                                  Sky_TrueEquatorial pos[])
+/*! Calculate the Sun's position at each of an array of times, as a unit vector
+    and a distance, in apparent coordinates. The results are the same as you
+    would get by calling sun_nrelApparent() once for each time, but the Sun's
+    longitude, latitude and distance series are evaluated for a block of times
+    at once.
+ \param[in]  count      Number of times in array \a j2kTT_cy
+ \param[in]  j2kTT_cy   Array of times: Julian centuries since J2000.0, TT
+                        timescale. The times need not be in any order, nor
+                        evenly spaced.
+ \param[out] pos        Array of \a count timestamped structures containing
+                        position data and the equation of the equinoxes, one
+                        for each element of \a j2kTT_cy
+
+ \par When to call this function
+    Call this function when you want the Sun's apparent position at many times
+    and you have the times available all at once, such as when generating an
+    ephemeris or fitting interpolating polynomials. For a single time, call
+    sun_nrelApparent() instead.
+
+ \par Speed
+    The series terms are applied to a block of up to 8 times before moving on to
+    the next term, so each term's coefficients are loaded once per block rather
+    than once per time, and the innermost loop is a simple loop over a
+    contiguous array. That loop is written so that the compiler can
+    auto-vectorise it. No processor-specific intrinsics are used, so the code
+    remains portable. With GCC on x86-64 Linux, compiling this file with
+    \c -O3 \c -ffast-math (and \c -mavx2 or \c -march=native) allows the
+    compiler to call glibc's vector cos() routines, which evaluate 4 (AVX2) or 8
+    (AVX-512) cosines at once. Without such options, the code still runs, with
+    a smaller speed improvement.
+ \par
+    Nutation is still calculated separately for each time, by
+    sky0_nutationSpa().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    Sky0_Nut1980   nut;
+    double         t_ka[SUN_BATCH_LANES];       // Millennia since J2000.0, TT
+    double         lambda_rad[SUN_BATCH_LANES]; // Sun longitude
+    double         beta_rad[SUN_BATCH_LANES];   // Sun latitude
+    double         dist_au[SUN_BATCH_LANES];    // Sun distance
+    int            blockStart;
+    int            blockCount;
+    int            k;
+
+    REQUIRE(count >= 0);
+    REQUIRE((count == 0) || (j2kTT_cy != NULL));
+    REQUIRE((count == 0) || (pos != NULL));
+
+    for (blockStart = 0; blockStart < count; blockStart += SUN_BATCH_LANES) {
+        blockCount = count - blockStart;
+        if (blockCount > SUN_BATCH_LANES) {
+            blockCount = SUN_BATCH_LANES;
+        }
+
+        /* Calculate Sun longitude, latitude and distance from tables for the
+           whole block of times */
+        for (k = 0; k < blockCount; k++) {
+            t_ka[k] = j2kTT_cy[blockStart + k] / 10.0;
+        }
+        sunDistance(blockCount, t_ka, rTerms[sunPrecision], dist_au);
+        sunLatitude(blockCount, t_ka, bTerms[sunPrecision], beta_rad);
+        sunLongitude(blockCount, t_ka, lTerms[sunPrecision], lambda_rad);
+
+        /* Then complete each position individually, exactly as done by
+           sun_nrelApparent() */
+        for (k = 0; k < blockCount; k++) {
+            sky0_nutationSpa(j2kTT_cy[blockStart + k], &nut);
+            sky0_epsilonSpa(j2kTT_cy[blockStart + k], &nut);
+            pos[blockStart + k].eqEq_rad = nut.eqEq_rad;
+            eclipticToApparent(lambda_rad[k], beta_rad[k], dist_au[k], &nut,
+                               &pos[blockStart + k].appCirsV);
+            pos[blockStart + k].distance_au = dist_au[k];
+            pos[blockStart + k].timestamp_cy = j2kTT_cy[blockStart + k];
+        }
+    }
+}
+
+
+
+GLOBAL void sun_sweepInit(double    startTT_cy,
+                          double    step_d,
+                          int       reseedInterval,
+                          Sun_Sweep *sweep)
+/*! Prepare to calculate the Sun's apparent position at a series of equally
+    spaced times, by successive calls to sun_sweepNext().
+ \param[in]  startTT_cy     Time of the first sample: Julian centuries since
+                            J2000.0, TT timescale
+ \param[in]  step_d         Interval between samples (days). May be negative.
+ \param[in]  reseedInterval Number of samples between full recalculations of
+                            the series phases and of the nutation (must be
+                            1 or greater). A value equivalent to one hour (e.g.
+                            3600 for a one-second step) is suitable.
+ \param[out] sweep          Working storage, to be passed to sun_sweepNext()
+
+ \par How it works
+    Each of the periodic terms of the NREL SPA series has the form
+    A cos(B + C t). When t advances by a fixed step, the phase B + C t advances
+    by the fixed angle C × step. So instead of calling cos() for every term at
+    every sample, sun_sweepNext() keeps the cosine and sine of each phase, and
+    rotates that pair by the (precalculated) cosine and sine of the step angle.
+    This replaces 195 cos() calls per sample with a few multiplications and
+    additions per term.
+ \par
+    Rounding errors gradually accumulate in the rotated pairs, so every
+    \a reseedInterval samples the phases are recalculated from scratch. The
+    nutation (which changes very slowly) is fully calculated only at those same
+    times, and linearly interpolated in between.
+ \par
+    With a one hour reseed interval, results agree with those of
+    sun_nrelApparent() to within about 2e-5 arcseconds. The difference comes
+    almost entirely from interpolating the nutation, so it grows with the
+    square of the reseed interval (to about 0.006 arcseconds for one day).
+    Evaluation is about seven times faster than calling sun_nrelApparent().
+
+ \par When to call this function
+    Call this function, followed by repeated calls to sun_sweepNext(), when you
+    need the Sun's position at many regularly spaced times - for example, every
+    second for a day, in a simulation. For irregularly spaced times, call
+    sun_nrelApparentBatch() instead.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  step_ka;        // step between samples (millennia)
+    int     i, j;
+    int     n;
+
+    REQUIRE_NOT_NULL(sweep);
+    REQUIRE(reseedInterval >= 1);
+
+    sweep->start_cy = startTT_cy;
+    sweep->step_cy = step_d / JUL_CENT;
+    sweep->sampleNum = 0;
+    sweep->reseedInterval = reseedInterval;
+
+    /* Calculate the rotation to be applied to each term's phase per step */
+    step_ka = sweep->step_cy / 10.0;
+    n = 0;
+    for (i = 0; i < L_COUNT; i++) {
+        for (j = 0; j < lSubcount[i]; j++, n++) {
+            sincos(lt[i][j].cct * step_ka, &sweep->sinStep[n],
+                   &sweep->cosStep[n]);
+        }
+    }
+    for (i = 0; i < B_COUNT; i++) {
+        for (j = 0; j < bSubcount[i]; j++, n++) {
+            sincos(bt[i][j].cct * step_ka, &sweep->sinStep[n],
+                   &sweep->cosStep[n]);
+        }
+    }
+    for (i = 0; i < R_COUNT; i++) {
+        for (j = 0; j < rSubcount[i]; j++, n++) {
+            sincos(rt[i][j].cct * step_ka, &sweep->sinStep[n],
+                   &sweep->cosStep[n]);
+        }
+    }
+    ENSURE(n == SUN_SERIES_TERM_COUNT);
+
+    /* Make sure that the phases are calculated on the first call to
+       sun_sweepNext() */
+    nutationAndObliquity(startTT_cy, &sweep->nutEnd);
+    sweep->sinceReseed = reseedInterval;
+}
+
+
+
+GLOBAL void sun_sweepNext(Sun_Sweep *sweep, Sky_TrueEquatorial *pos)
+/*! Calculate the Sun's apparent position at the next time in a series of
+    equally spaced times, as set up by sun_sweepInit().
+ \param[in,out] sweep  Working storage, as initialised by sun_sweepInit().
+                       It is updated ready for the following sample.
+ \param[out]    pos    Timestamped structure containing position data and the
+                       equation of the equinoxes. For the nth call to this
+                       function since sun_sweepInit() (counting from zero), the
+                       timestamp is \a startTT_cy + n × \a step_d (converted to
+                       centuries).
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double       t_cy;      // Julian centuries since J2000.0, TT timescale
+    double       t_ka;      // Millennia since J2000.0, TT timescale (J2KM)
+    double       frac;      // fraction of the way between reseeds
+    double       lSum[L_COUNT];
+    double       bSum[B_COUNT];
+    double       rSum[R_COUNT];
+    double       lambda_rad; // Sun longitude
+    double       beta_rad;   // Sun latitude
+    Sky0_Nut1980 nut;
+    int          n;
+
+    REQUIRE_NOT_NULL(sweep);
+    REQUIRE_NOT_NULL(pos);
+
+    if (sweep->sinceReseed >= sweep->reseedInterval) {
+        sweepReseed(sweep);
+    }
+    t_cy = sweep->start_cy + (double)sweep->sampleNum * sweep->step_cy;
+    t_ka = t_cy / 10.0;
+
+    /* Interpolate the nutation between the values at the reseed times */
+    frac = (double)sweep->sinceReseed / (double)sweep->reseedInterval;
+    nut.dPsi_rad = sweep->nutStart.dPsi_rad
+                   + frac * (sweep->nutEnd.dPsi_rad - sweep->nutStart.dPsi_rad);
+    nut.dEps_rad = sweep->nutStart.dEps_rad
+                   + frac * (sweep->nutEnd.dEps_rad - sweep->nutStart.dEps_rad);
+    nut.eps0_rad = sweep->nutStart.eps0_rad
+                   + frac * (sweep->nutEnd.eps0_rad - sweep->nutStart.eps0_rad);
+    nut.eqEq_rad = sweep->nutStart.eqEq_rad
+                   + frac * (sweep->nutEnd.eqEq_rad - sweep->nutStart.eqEq_rad);
+
+    /* Sum the series terms, advancing each term's phase ready for the next
+       sample */
+    n = 0;
+    sweepSeries(L_COUNT, lt, lSubcount, sweep, &n, lSum);
+    sweepSeries(B_COUNT, bt, bSubcount, sweep, &n, bSum);
+    sweepSeries(R_COUNT, rt, rSubcount, sweep, &n, rSum);
+
+    /* Convert Earth heliocentric coordinates to Sun geocentric coordinates, as
+       done in sunLongitude(), sunLatitude() and sunDistance() */
+    lambda_rad = normalize(seriesPolynomial(L_COUNT, lSum, t_ka) + PI, TWOPI);
+    beta_rad = -seriesPolynomial(B_COUNT, bSum, t_ka);
+    pos->distance_au = seriesPolynomial(R_COUNT, rSum, t_ka);
+
+    eclipticToApparent(lambda_rad, beta_rad, pos->distance_au, &nut,
+                       &pos->appCirsV);
+    pos->eqEq_rad = nut.eqEq_rad;
+    pos->timestamp_cy = t_cy;
+
+    sweep->sampleNum++;
+    sweep->sinceReseed++;
+}
+
+
+
 GLOBAL void sun_nrelTopocentric(double             j2kUtc_d,
                                 const Sky_DeltaTs  *deltas,
                                 const Sky_SiteProp *site,
@@ -430,19 +1021,127 @@ GLOBAL double sun_riseSet(int                year,
                                        18, 0, 0.0, site->timeZone_d * 24.0);
     }
 
-    estimate_d = riseSetApprox(estimate_d, getSunrise, deltas, &st, &topo1);
+    estimate_d = riseSetApprox(estimate_d, getSunrise, deltas, &st,
+                               NULL, &topo1, NULL);
     if (estimate_d == 0.0) {
         /* Sun does not rise (or set) at the specified latitude on the requested
            day. Don't try another iteration. */
         return estimate_d;
     }
-    estimate_d = riseSetApprox(estimate_d, getSunrise, deltas, &st, &topo1);
+    estimate_d = riseSetApprox(estimate_d, getSunrise, deltas, &st,
+                               NULL, &topo1, NULL);
 
     if (topo != NULL) {
         *topo = topo1;
     }
     return estimate_d;  
 }
+
+
+
+GLOBAL double sun_riseSetMask(int                   year,
+                              int                   month,
+                              int                   day,
+                              bool                  getSunrise,
+                              const Sky_DeltaTs     *deltas,
+                              const Sky_SiteProp    *site,
+                              const Sky_HorizonMask *mask,
+                              Sky_SiteHorizon       *topo)
+/*! Routine to calculate the time at which the Sun's upper limb appears above
+    (or disappears below) the local horizon - terrain, buildings etc. - on the
+    day specified by \a year, \a month and \a day. This is the same as
+    sun_riseSet(), except that the horizon is described by a horizon mask,
+    rather than being flat.
+ \returns                Sunrise (or sunset) time, as for sun_riseSet(), or 0.0
+                         if the Sun does not rise above (or set below) the
+                         local horizon on that day
+ \param[in] year, month, day
+                         Date for which sunrise or sunset time is desired
+ \param[in]  getSunrise  If true, get sunrise time. If false, get sunset time
+ \param[in]  deltas      Delta T values, as for sun_riseSet()
+ \param[in]  site        Properties of the observing site, as for sun_riseSet()
+ \param[in]  mask        Horizon mask for the site, as set up by
+                         sky_setHorizonMask() or skysites_loadHorizon(). If
+                         NULL, the horizon is flat, and the result is
+                         practically the same as that of sun_riseSet().
+ \param[out] topo        \b Optional. Topocentric position of the Sun at rise
+                         or set, as for sun_riseSet(). May be NULL.
+
+    This starts with the sunrise (or sunset) over a flat horizon, and then
+    iterates, each time looking up the elevation of the horizon at the Sun's
+    azimuth, and finding when the Sun reaches that elevation. The refraction is
+    allowed for as described in sky_horizonRiseSetEl_rad(). The iterations are
+    speeded up with the secant method, and each costs one call to
+    sun_nrelTopocentric(), so this typically takes five to eight of those calls
+    in all, rather than the hundreds needed to find the time by sampling the
+    Sun's position through the day.
+
+ \note
+    If the local horizon has peaks and gaps, the Sun may appear and disappear
+    more than once. This routine finds the time at which the Sun clears the
+    horizon near where it would rise (or set) over a flat horizon. Use
+    sky_siteIsVisible() to check the Sun's visibility at other times.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    Sky_SiteHorizon topo1;      // Sun apparent position
+    Sky_SiteProp    st;         // copy of site details, without refraction
+    double          t0_d, t1_d; // Two latest estimates of the time
+    double          r0_d, r1_d; // Correction riseSetApprox() gives to each
+    double          next_d;     // Improved estimate from riseSetApprox()
+    bool            found;      // Sun rises (or sets) at all
+    int             i;
+
+    REQUIRE_NOT_NULL(deltas);
+    REQUIRE_NOT_NULL(site);
+
+    /* Unrefracted positions, as for sun_riseSet() */
+    st = *site;
+    st.refracPT = 0.0;
+
+    if (getSunrise) {
+        t1_d = sky_calTimeToJ2kd(year, month, day,
+                                 6, 0, 0.0, site->timeZone_d * 24.0);
+    } else {
+        t1_d = sky_calTimeToJ2kd(year, month, day,
+                                 18, 0, 0.0, site->timeZone_d * 24.0);
+    }
+    /* First estimate, over a flat horizon */
+    t1_d = riseSetApprox(t1_d, getSunrise, deltas, &st, NULL, &topo1, &found);
+    if (!found || (mask == NULL)) {
+        /* No rise (or set), or flat horizon: we already have the answer */
+        if (topo != NULL) {
+            *topo = topo1;
+        }
+        return t1_d;
+    }
+
+    /* Then refine, with the horizon at the Sun's azimuth, using the secant
+       method to find where the correction riseSetApprox() gives is zero */
+    t0_d = t1_d;
+    r0_d = 0.0;
+    for (i = 0; i < MASK_ITERATIONS; i++) {
+        next_d = riseSetApprox(t1_d, getSunrise, deltas, &st, mask, &topo1,
+                               &found);
+        if (!found) {
+            t1_d = 0.0;                 // Sun does not clear the horizon
+            break;
+        }
+        r1_d = next_d - t1_d;
+        if (fabs(r1_d) < MASK_TOLERANCE_d) {
+            t1_d = next_d;
+            break;
+        }
+        next_d = sky_horizonRiseSetStep_d(t0_d, r0_d, t1_d, r1_d);
+        t0_d = t1_d;
+        r0_d = r1_d;
+        t1_d = next_d;
+    }
+
+    if (topo != NULL) {
+        *topo = topo1;
+    }
+    return t1_d;
+}
                             
 
 /*
@@ -452,379 +1151,355 @@ GLOBAL double sun_riseSet(int                year,
  *
  *------------------------------------------------------------------------------
  */
-LOCAL double sunLongitude(double t_ka)
+LOCAL void sunLongitude(int          count,
+                        const double t_ka[],
+                        const int    terms[],
+                        double lambda_rad[])
 /* This routine performs steps 3.2.1 to 3.2.4, 3.2.6, 3.3.1 and 3.3.2 of the
-   algorithm outlined in the SPA document
- Returns - Sun geocentric longitude (radian) (geometric)
+   algorithm outlined in the SPA document, for up to SUN_BATCH_LANES times.
  Inputs
-    t_ka - Julian ephemeris millennium, millennia since J2000.0, TT timescale
+    count      - number of times in array t_ka (1 to SUN_BATCH_LANES)
+    t_ka       - Julian ephemeris millennium, millennia since J2000.0, TT
+                 timescale, for each time
+    terms      - number of rows of each of the tables l0 - l5 to use (an entry
+                 of lTerms[])
+ Outputs
+    lambda_rad - Sun geocentric longitude (radian) (geometric), for each time
 
    Earth heliocentric longitude terms are stored in array L_TERMS.
    There are 6 intermediate terms to obtain (L0 -- L5), and each
    one is obtained by calculating
             L[i] = sum_over_rows_j( A[j] * cos(B[j] + C[j]*j_ka) )
    For L0, there are 64 rows j, for L1 there are 34 (etc - value
-   is stored in lSubcount[i])
+   is stored in lSubcount[i]; fewer are used at reduced precision)
         Having obtained L0 -- L5, the longitude is obtained from
             (L0 + L1*j_ka + L2*j_ka^2 + ... + L5*j_ka^5) / 10^8
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 {
-    /* Periodic terms for the Sun's ecliptic longitude */
-    static const SunSeries l0[] = {
-        {175347046.0, 0, 0},
-        {  3341656.0, 4.6692568, 6283.07585},
-        {    34894.0, 4.6261,   12566.1517 },
-        {3497.0, 2.7441,  5753.3849},
-        {3418.0, 2.8289,     3.5231},
-        {3136.0, 3.6277, 77713.7715},
-        {2676.0, 4.4181,  7860.4194},
-        {2343.0, 6.1352,  3930.2097},
-        {1324.0, 0.7425, 11506.7698},
-        {1273.0, 2.0371,   529.691 },
-        {1199.0, 1.1096,  1577.3435},
-        {990, 5.233,  5884.927},
-        {902, 2.045,    26.298},
-        {857, 3.508,   398.149},
-        {780, 1.179,  5223.694},
-        {753, 2.533,  5507.553},
-        {505, 4.583, 18849.228},
-        {492, 4.205,   775.523},
-        {357, 2.92,      0.067},
-        {317, 5.849, 11790.629},
-        {284, 1.899,   796.298},
-        {271, 0.315, 10977.079},
-        {243, 0.345,  5486.778},
-        {206, 4.806,  2544.314},
-        {205, 1.869,  5573.143},
-        {202, 2.458,  6069.777},
-        {156, 0.833,   213.299},
-        {132, 3.411,  2942.463},
-        {126, 1.083,    20.775},
-        {115, 0.645,     0.98 },
-        {103, 0.636,  4694.003},
-        {102, 0.976, 15720.839},
-        {102, 4.267,     7.114},
-        { 99, 6.21,   2146.17},
-        { 98, 0.68,    155.42},
-        { 86, 5.98, 161000.69},
-        { 85, 1.3,    6275.96},
-        { 85, 3.67,  71430.7 },
-        { 80, 1.81,  17260.15},
-        { 79, 3.04,  12036.46},
-        { 75, 1.76,   5088.63},
-        { 74, 3.5,    3154.69},
-        { 74, 4.68,    801.82},
-        { 70, 0.83,   9437.76},
-        { 62, 3.98,   8827.39},
-        { 61, 1.82,   7084.9 },
-        { 57, 2.78,   6286.6 },
-        { 56, 4.39,  14143.5 },
-        { 56, 3.47,   6279.55},
-        { 52, 0.19,  12139.55},
-        { 52, 1.33,   1748.02},
-        { 51, 0.28,   5856.48},
-        { 49, 0.49,   1194.45},
-        { 41, 5.37,   8429.24},
-        { 41, 2.4,   19651.05},
-        { 39, 6.17,  10447.39},
-        { 37, 6.04,  10213.29},
-        { 37, 2.57,   1059.38},
-        { 36, 1.71,   2352.87},
-        { 36, 1.78,   6812.77},
-        { 33, 0.59,  17789.85},
-        { 30, 0.44,  83996.85},
-        { 30, 2.74,   1349.87},
-        { 25, 3.16,   4690.48}
-    };
-    static const SunSeries l1[] = {
-        {628331966747.0, 0,     0},
-        {206059.0, 2.678235, 6283.07585},
-        {4303.0,   2.6351,  12566.1517},
-        {425.0,    1.59,        3.523},
-        {119.0,    5.796,      26.298},
-        {109.0,    2.966,    1577.344},
-        {93, 2.59, 18849.23},
-        {72, 1.14,   529.69},
-        {68, 1.87,   398.15},
-        {67, 4.41,  5507.55},
-        {59, 2.89,  5223.69},
-        {56, 2.17,   155.42},
-        {45, 0.4,    796.3 },
-        {36, 0.47,   775.52},
-        {29, 2.65,     7.11},
-        {21, 5.34,     0.98},
-        {19, 1.85,  5486.78},
-        {19, 4.97,   213.3 },
-        {17, 2.99,  6275.96},
-        {16, 0.03,  2544.31},
-        {16, 1.43,  2146.17},
-        {15, 1.21, 10977.08},
-        {12, 2.83,  1748.02},
-        {12, 3.26,  5088.63},
-        {12, 5.27,  1194.45},
-        {12, 2.08,  4694   },
-        {11, 0.77,   553.57},
-        {10, 1.3,   6286.6 },
-        {10, 4.24,  1349.87},
-        { 9, 2.7,    242.73},
-        { 9, 5.64,   951.72},
-        { 8, 5.3,   2352.87},
-        { 6, 2.65,  9437.76},
-        { 6, 4.67,  4690.48}
-    };
-    static const SunSeries l2[] = {
-        {52919.0, 0,         0},
-        { 8720.0, 1.0721, 6283.0758},
-        {  309.0, 0.867, 12566.152},
-        {27, 0.05,    3.52 },
-        {16, 5.19,    26.3 },
-        {16, 3.68,   155.42},
-        {10, 0.76, 18849.23},
-        { 9, 2.06, 77713.77},
-        { 7, 0.83,   775.52},
-        { 5, 4.66,  1577.34},
-        { 4, 1.03,     7.11},
-        { 4, 3.44,  5573.14},
-        { 3, 5.14,   796.3 },
-        { 3, 6.05,  5507.55},
-        { 3, 1.19,   242.73},
-        { 3, 6.12,   529.69},
-        { 3, 0.31,   398.15},
-        { 3, 2.28,   553.57},
-        { 2, 4.38,  5223.69},
-        { 2, 3.75,     0.98}
-    };
-    static const SunSeries l3[] = {
-        {289.0, 5.844, 6283.076},
-        {35, 0,        0},
-        {17, 5.49, 12566.15},
-        { 3, 5.2,    155.42},
-        { 1, 4.72,     3.52},
-        { 1, 5.3,  18849.23},
-        { 1, 5.97,   242.73}
-    };
-    static const SunSeries l4[] = {
-        {114.0, 3.142, 0},
-        {8, 4.13,  6283.08},
-        {1, 3.84, 12566.15}
-    };
-    static const SunSeries l5[] = {
-        {1, 3.14, 0}
-    };
-    /* Allow access to l0..l5 as if they form a single array lt[][] */
-    static const SunSeries *lt[L_COUNT] = { l0, l1, l2, l3, l4, l5 };
-    static const int lSubcount[L_COUNT] = { ARRAY_SIZE(l0),
-                                            ARRAY_SIZE(l1),
-                                            ARRAY_SIZE(l2),
-                                            ARRAY_SIZE(l3),
-                                            ARRAY_SIZE(l4),
-                                            ARRAY_SIZE(l5)};
-
-    double sum[L_COUNT];
-    int    i, j;
+    double sum[L_COUNT][SUN_BATCH_LANES];
+    int    i, j, k;
+    double a, cb, cct;
     double earthSum;
     double tPower;
 
+    REQUIRE((count > 0) && (count <= SUN_BATCH_LANES));
+
     /* Calculate the Earth heliocentric longitude (radian) */
     for (i = 0; i < L_COUNT; i++) {
-        sum[i] = 0.0;
-        for (j = 0; j < lSubcount[i]; j++) {
-            sum[i] += lt[i][j].a * cos(lt[i][j].cb + lt[i][j].cct * t_ka);
+        for (k = 0; k < count; k++) {
+            sum[i][k] = 0.0;
+        }
+        for (j = 0; j < terms[i]; j++) {
+            a = lt[i][j].a;
+            cb = lt[i][j].cb;
+            cct = lt[i][j].cct;
+            for (k = 0; k < count; k++) {
+                sum[i][k] += a * cos(cb + cct * t_ka[k]);
+            }
         }
     }
 
-    earthSum = 0.0;
-    tPower = 1.0;
-    for (i = 0; i < L_COUNT; i++) {
-        /* replace  earthSum +=  sum[i] * pow(t_ka, i); with faster code */
-        earthSum +=  sum[i] * tPower;
-        tPower *= t_ka;
+    for (k = 0; k < count; k++) {
+        earthSum = 0.0;
+        tPower = 1.0;
+        for (i = 0; i < L_COUNT; i++) {
+            /* replace  earthSum +=  sum[i] * pow(t_ka, i); with faster code */
+            earthSum +=  sum[i][k] * tPower;
+            tPower *= t_ka[k];
+        }
+        earthSum /= 1.0e8;
+
+        /* Convert Earth heliocentric longitude to Sun geocentric longitude
+           (radian) and force into the range 0 to TwoPi */
+        earthSum += PI;
+
+        lambda_rad[k] = normalize(earthSum, TWOPI);
     }
-    earthSum /= 1.0e8;
-    
-    /* Convert Earth heliocentric longitude to Sun geocentric longitude (radian)
-       and force into the range 0 to TwoPi */
-    earthSum += PI;
-    
-    return normalize(earthSum, TWOPI);
 }
 
 
 
-LOCAL double sunLatitude(double t_ka)
+LOCAL void sunLatitude(int          count,
+                       const double t_ka[],
+                       const int    terms[],
+                       double beta_rad[])
 /* This routine performs steps 3.2.7 and 3.3.3 of the algorithm outlined
-   in the SPA document
- Returns - Sun geocentric latitude (radian)
+   in the SPA document, for up to SUN_BATCH_LANES times.
  Inputs
-    t_ka - Julian ephemeris millennium, millennia since J2000.0, TT timescale
+    count    - number of times in array t_ka (1 to SUN_BATCH_LANES)
+    t_ka     - Julian ephemeris millennium, millennia since J2000.0, TT
+               timescale, for each time
+    terms    - number of rows of each of the tables b0 - b1 to use (an entry
+               of bTerms[])
+ Outputs
+    beta_rad - Sun geocentric latitude (radian), for each time
 
    Earth heliocentric latitude terms are stored in array B_TERMS.
    There are 2 intermediate terms to obtain (B0 -- B1), and each
    one is obtained by calculating
             B[i] = sum_over_rows_j( A[j] * cos(B[j] + C[j]*j_ka) )
    For B0, there are 5 rows j, for B1 there are 2 (value
-   is stored in bSubcount(i))
+   is stored in bSubcount(i); fewer are used at reduced precision)
         Having obtained B0 -- B1, the latitude is obtained from
             (B0 + L1*j_ka) / 10^8
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 {
-    /* Periodic terms for the Sun's ecliptic latitude */
-    static const SunSeries b0[] = {
-        {280.0, 3.199, 84334.662},
-        {102.0, 5.422, 5507.553},
-        { 80.0, 3.88,  5223.69},
-        { 44.0, 3.7,   2352.87},
-        { 32.0, 4.0,   1577.34}
-    };
-    static const SunSeries b1[] = {
-        {9.0, 3.9,  5507.55},
-        {6.0, 1.73, 5223.69}
-    };
-    /* Allow access to b0..b1 as if they form a single array bt[][] */
-    static const SunSeries *bt[B_COUNT] = { b0, b1 };
-    static const int bSubcount[B_COUNT] = { ARRAY_SIZE(b0),
-                                            ARRAY_SIZE(b1) };
-
-    double sum[B_COUNT];
-    int    i, j;
+    double sum[B_COUNT][SUN_BATCH_LANES];
+    int    i, j, k;
+    double a, cb, cct;
     double earthSum;
 
+    REQUIRE((count > 0) && (count <= SUN_BATCH_LANES));
+
     /* Calculate the Earth heliocentric latitude (radian) */
     for (i = 0; i < B_COUNT; i++) {
-        sum[i] = 0.0;
-        for (j = 0; j < bSubcount[i]; j++) {
-            sum[i] += bt[i][j].a * cos(bt[i][j].cb + bt[i][j].cct * t_ka);
+        for (k = 0; k < count; k++) {
+            sum[i][k] = 0.0;
+        }
+        for (j = 0; j < terms[i]; j++) {
+            a = bt[i][j].a;
+            cb = bt[i][j].cb;
+            cct = bt[i][j].cct;
+            for (k = 0; k < count; k++) {
+                sum[i][k] += a * cos(cb + cct * t_ka[k]);
+            }
         }
     }
 
-    earthSum = sum[0] + sum[1] * t_ka;
-    earthSum /= 1.0e8;
+    for (k = 0; k < count; k++) {
+        earthSum = sum[0][k] + sum[1][k] * t_ka[k];
+        earthSum /= 1.0e8;
 
-    /* Convert Earth heliocentric latitude to Sun geocentric latitude (radian)*/
-    earthSum = -earthSum;
-    
-    return earthSum;
+        /* Convert Earth heliocentric latitude to Sun geocentric latitude
+           (radian) */
+        beta_rad[k] = -earthSum;
+    }
 }
 
 
 
-LOCAL double sunDistance(double t_ka)
+LOCAL void sunDistance(int          count,
+                       const double t_ka[],
+                       const int    terms[],
+                       double dist_au[])
 /* This routine performs step 3.2.8 of the algorithm outlined in the SPA
-   document.
- Returns - distance to the sun (astronomical units)
+   document, for up to SUN_BATCH_LANES times.
  Inputs
-    t_ka - Julian ephemeris millennium, millennia since J2000.0, TT timescale
+    count   - number of times in array t_ka (1 to SUN_BATCH_LANES)
+    t_ka    - Julian ephemeris millennium, millennia since J2000.0, TT
+              timescale, for each time
+    terms   - number of rows of each of the tables r0 - r4 to use (an entry
+              of rTerms[])
+ Outputs
+    dist_au - distance to the sun (astronomical units), for each time
 
    Earth heliocentric distance terms are stored in array R_TERMS.
    There are 5 intermediate terms to obtain (R0 -- R4), and each
    one is obtained by calculating
             R[i] = sum_over_rows_j( A[j] * cos(B[j] + C[j]*j_ka) )
    For R0, there are 40 rows j, for R1 there are 10 (etc - value
-   is stored in rSubcount(i))
+   is stored in rSubcount(i); fewer are used at reduced precision)
         Having obtained R0 -- R4, the distance is obtained from
             (R0 + R1*j_ka + R2*j_ka^2 + ... + R4*j_ka^4) / 10^8
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 {
-    /* Periodic terms for the Earth - Sun distance */
-    static const SunSeries r0[] = {
-        {100013989.0, 0.0, 0.0},
-        {1670700.0, 3.0984635, 6283.07585},
-        {13956.0,   3.05525,  12566.1517},
-        {3084.0, 5.1985, 77713.7715},
-        {1628.0, 1.1739, 5753.3849},
-        {1576.0, 2.8469, 7860.4194},
-        { 925.0, 5.453, 11506.77},
-        { 542.0, 4.564,  3930.21},
-        { 472.0, 3.661,  5884.927},
-        { 346.0, 0.964,  5507.553},
-        { 329.0, 5.9,    5223.694},
-        { 307.0, 0.299,  5573.143},
-        { 243.0, 4.273, 11790.629},
-        { 212.0, 5.847,  1577.344},
-        { 186.0, 5.022, 10977.079},
-        { 175.0, 3.012, 18849.228},
-        { 110.0, 5.055,  5486.778},
-        {  98.0, 0.89,   6069.78},
-        {  86.0, 5.69,  15720.84},
-        {  86.0, 1.27, 161000.69},
-        {  65.0, 0.27,  17260.15},
-        {  63.0, 0.92,    529.69},
-        {  57.0, 2.01,  83996.85},
-        {  56.0, 5.24,  71430.7},
-        {  49.0, 3.25,   2544.31},
-        {  47.0, 2.58,    775.52},
-        {  45.0, 5.54,   9437.76},
-        {  43.0, 6.01,   6275.96},
-        {  39.0, 5.36,   4694.0},
-        {  38.0, 2.39,   8827.39},
-        {  37.0, 0.83,  19651.05},
-        {  37.0, 4.9,   12139.55},
-        {  36.0, 1.67,  12036.46},
-        {  35.0, 1.84,   2942.46},
-        {  33.0, 0.24,   7084.9},
-        {  32.0, 0.18,   5088.63},
-        {  32.0, 1.78,    398.15},
-        {  28.0, 1.21,   6286.6},
-        {  28.0, 1.9,    6279.55},
-        {  26.0, 4.59,  10447.39}
-    };
-    static const SunSeries r1[] = {
-        {103019.0, 1.10749, 6283.07585},
-        {  1721.0, 1.0644, 12566.1517},
-        {702.0, 3.142,    0.0 },
-        { 32.0, 1.02, 18849.23},
-        { 31.0, 2.84,  5507.55},
-        { 25.0, 1.32,  5223.69},
-        { 18.0, 1.42,  1577.34},
-        { 10.0, 5.91, 10977.08},
-        {  9.0, 1.42,  6275.96},
-        {  9.0, 0.27,  5486.78}
-    };
-    static const SunSeries r2[] = {
-        {4359.0, 5.7846, 6283.0758},
-        { 124.0, 5.579, 12566.152},
-        {  12.0, 3.14,      0.0 },
-        {   9.0, 3.63,  77713.77},
-        {   6.0, 1.87,   5573.14},
-        {   3.0, 5.47,  18849.23}
-    };
-    static const SunSeries r3[] = {
-        {145.0, 4.273, 6283.076},
-        {  7.0, 3.92, 12566.15 }
-    };
-    static const SunSeries r4[] = {
-        {4.0, 2.56, 6283.08}
-    };
-    /* Allow access to r0..r4 as if they form a single array rt[][] */
-    static const SunSeries *rt[R_COUNT] = { r0, r1, r2, r3, r4 };
-    static const int rSubcount[R_COUNT] = { ARRAY_SIZE(r0),
-                                            ARRAY_SIZE(r1),
-                                            ARRAY_SIZE(r2),
-                                            ARRAY_SIZE(r3),
-                                            ARRAY_SIZE(r4)};
-
-    double sum[R_COUNT];
-    int    i, j;
+    double sum[R_COUNT][SUN_BATCH_LANES];
+    int    i, j, k;
+    double a, cb, cct;
     double earthSum;
     double tPower;
 
+    REQUIRE((count > 0) && (count <= SUN_BATCH_LANES));
+
     for (i = 0; i < R_COUNT; i++) {
-        sum[i] = 0.0;
-        for (j = 0; j < rSubcount[i]; j++) {
-            sum[i] += rt[i][j].a * cos(rt[i][j].cb + rt[i][j].cct * t_ka);
+        for (k = 0; k < count; k++) {
+            sum[i][k] = 0.0;
+        }
+        for (j = 0; j < terms[i]; j++) {
+            a = rt[i][j].a;
+            cb = rt[i][j].cb;
+            cct = rt[i][j].cct;
+            for (k = 0; k < count; k++) {
+                sum[i][k] += a * cos(cb + cct * t_ka[k]);
+            }
         }
     }
-    
+
+    for (k = 0; k < count; k++) {
+        earthSum = 0.0;
+        tPower = 1.0;
+        for (i = 0; i < R_COUNT; i++) {
+            /* replace  earthSum +=  sum[i] * pow(t_ka, i); with faster code */
+            earthSum +=  sum[i][k] * tPower;
+            tPower *= t_ka[k];
+        }
+        dist_au[k] = earthSum / 1.0e8;
+    }
+}
+
+
+
+LOCAL double seriesPolynomial(int count, const double sum[], double t_ka)
+/* Combine the sums of the intermediate series terms into a single value, in
+   the same way as the last part of sunLongitude(), sunLatitude() and
+   sunDistance().
+ Returns - (sum[0] + sum[1]*t_ka + sum[2]*t_ka^2 + ...) / 10^8
+ Inputs
+    count - number of elements in sum[]
+    sum   - intermediate sums L0, L1 ... (or B0, B1 or R0, R1 ...)
+    t_ka  - Julian ephemeris millennium, millennia since J2000.0, TT timescale
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    int    i;
+    double earthSum;
+    double tPower;
+
     earthSum = 0.0;
     tPower = 1.0;
-    for (i = 0; i < R_COUNT; i++) {
-        /* replace  earthSum +=  sum[i] * pow(t_ka, i); with faster code */
+    for (i = 0; i < count; i++) {
         earthSum +=  sum[i] * tPower;
         tPower *= t_ka;
     }
-    earthSum /= 1.0e8;
+    return earthSum / 1.0e8;
+}
 
-    return earthSum;
+
+
+LOCAL void sweepSeries(int             seriesCount,
+                       const SunSeries *const st[],
+                       const int       subcount[],
+                       Sun_Sweep *sweep,
+                       int       *term,
+                       double    sum[])
+/* Sum the intermediate series terms using the phases stored in sweep, and
+   then advance those phases by one step.
+ Inputs
+    seriesCount - number of intermediate series (e.g. L_COUNT)
+    st          - the series tables (e.g. lt)
+    subcount    - number of rows in each of those tables (e.g. lSubcount)
+ Outputs
+    sum         - the intermediate sums (e.g. L0 - L5)
+ In/Out
+    sweep       - working storage. Its phases are advanced by one step.
+    term        - index in sweep of the first term of these series. Updated to
+                  the index of the first term of the following series.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    int    i, j;
+    int    n;
+    double c, s;
+
+    n = *term;
+    for (i = 0; i < seriesCount; i++) {
+        sum[i] = 0.0;
+        for (j = 0; j < subcount[i]; j++, n++) {
+            c = sweep->cosPhase[n];
+            s = sweep->sinPhase[n];
+            sum[i] += st[i][j].a * c;
+            /* Rotate by the step angle: cos(x + d) and sin(x + d) */
+            sweep->cosPhase[n] = c * sweep->cosStep[n] - s * sweep->sinStep[n];
+            sweep->sinPhase[n] = s * sweep->cosStep[n] + c * sweep->sinStep[n];
+        }
+    }
+    *term = n;
+}
+
+
+
+LOCAL void sweepReseed(Sun_Sweep *sweep)
+/* Recalculate the phases of every series term from scratch, for the time of
+   the next sample, and calculate the nutation at the next reseed time.
+ In/Out
+    sweep - working storage for the sweep
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    double  t_cy;
+    double  t_ka;
+    int     i, j;
+    int     n;
+
+    t_cy = sweep->start_cy + (double)sweep->sampleNum * sweep->step_cy;
+    t_ka = t_cy / 10.0;
+    n = 0;
+    for (i = 0; i < L_COUNT; i++) {
+        for (j = 0; j < lSubcount[i]; j++, n++) {
+            sincos(lt[i][j].cb + lt[i][j].cct * t_ka, &sweep->sinPhase[n],
+                   &sweep->cosPhase[n]);
+        }
+    }
+    for (i = 0; i < B_COUNT; i++) {
+        for (j = 0; j < bSubcount[i]; j++, n++) {
+            sincos(bt[i][j].cb + bt[i][j].cct * t_ka, &sweep->sinPhase[n],
+                   &sweep->cosPhase[n]);
+        }
+    }
+    for (i = 0; i < R_COUNT; i++) {
+        for (j = 0; j < rSubcount[i]; j++, n++) {
+            sincos(rt[i][j].cb + rt[i][j].cct * t_ka, &sweep->sinPhase[n],
+                   &sweep->cosPhase[n]);
+        }
+    }
+
+    /* The nutation previously calculated for the next reseed time applies
+       now. Calculate the nutation for the following reseed time. */
+    sweep->nutStart = sweep->nutEnd;
+    nutationAndObliquity(sweep->start_cy
+                         + (double)(sweep->sampleNum + sweep->reseedInterval)
+                           * sweep->step_cy,
+                         &sweep->nutEnd);
+    sweep->sinceReseed = 0;
+}
+
+
+
+LOCAL void nutationAndObliquity(double j2kTT_cy, Sky0_Nut1980 *nut)
+/* Calculate nutation and the obliquity of the ecliptic (steps 3.4 and 3.5 of
+   the algorithm in the SPA document), as done in sun_nrelApparent()
+ Inputs
+    j2kTT_cy - Julian centuries since J2000.0, TT timescale
+ Outputs
+    nut      - nutation angles, obliquity and the equation of the equinoxes
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    sky0_nutationSpa(j2kTT_cy, nut);
+    sky0_epsilonSpa(j2kTT_cy, nut);
+}
+
+
+
+LOCAL void eclipticToApparent(double             lambda_rad,
+                              double             beta_rad,
+                              double             dist_au,
+                              const Sky0_Nut1980 *nut,
+                              V3D_Vector *appV)
+/* This routine performs steps 3.6 and 3.7 of the algorithm outlined in the SPA
+   document, and then converts the result to rectangular equatorial
+   coordinates.
+ Inputs
+    lambda_rad - Sun geocentric longitude (radian) (geometric)
+    beta_rad   - Sun geocentric latitude (radian)
+    dist_au    - distance to the sun (astronomical units)
+    nut        - nutation terms and obliquity of the ecliptic
+ Outputs
+    appV       - position vector of Sun in apparent coordinates (unit vector)
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+{
+    V3D_Matrix  epsM;       // Rotation by obliquity of ecliptic
+    V3D_Vector  eclipV;     // Sun position in rectangular ecliptic coordinates
+
+    /* Calculate the apparent longitude (in ecliptic coordinates), using the
+       nutation in longitude and the light-time aberration correction. (The
+       apparent longitude is the Sun's position 499 seconds earlier than the
+       geometric position, because it took light that much time to reach Earth.)
+       This is steps 3.6 and 3.7 of the SPA algorithm. */
+    lambda_rad += nut->dPsi_rad - arcsecToRad(20.4898) / dist_au;
+
+    /* Convert to rectangular coordinates */
+    v3d_polarToRect(&eclipV, lambda_rad, beta_rad);
+
+    /* Rotate from ecliptic to equatorial coordinates */
+    v3d_createRotationMatrix(&epsM, Xaxis, -(nut->eps0_rad + nut->dEps_rad));
+    v3d_multMxV(appV, &epsM, &eclipV);
 }
 
 
@@ -872,7 +1547,9 @@ LOCAL double riseSetApprox(double             risesetGuess_d,
                            bool               getSunrise,
                            const Sky_DeltaTs  *deltas,
                            const Sky_SiteProp *site,
-                           Sky_SiteHorizon *topo)
+                           const Sky_HorizonMask *mask,
+                           Sky_SiteHorizon *topo,
+                           bool               *found)
 /* Routine to calculate the time of Sun rise or set for the day specified by
    risesetGuess_d. The result returned is an approximate value, whose accuracy
    depends upon how close risesetGuess_d is to true Sun rise or set time.
@@ -893,12 +1570,17 @@ LOCAL double riseSetApprox(double             risesetGuess_d,
                       site->refracPT will be set to 0.0 before calling this
                       routine, in order to calculate an unrefracted position of
                       the Sun (as per note below).
+    mask            - horizon mask, or NULL for the usual flat horizon (with
+                      the Sun's centre at -50 arcminutes, unrefracted)
  Output
     topo            - Topocentric position of Sun at rise or set
+    found           - If not NULL, set to false if the sun does not rise (or
+                      set) on this date, or to true if it does
 
    Sunrise and set calculations assume a standard refraction at the horizon of
    34 arcminutes, and a sun semi-diameter of 16 arcminutes. So the calculation
-   is based on the time at which the UNREFRACTED Sun position is at -50 arcmin.
+   is based on the time at which the UNREFRACTED Sun position is at -50 arcmin
+   (unless there is a horizon mask).
  * 
  * TODO
  *  This routine uses the equation 
@@ -913,16 +1595,26 @@ LOCAL double riseSetApprox(double             risesetGuess_d,
     double          ha2_rad;    // Hour angle of Sun at horizon (radian)
     double          cosHa2;     // Cos(Hour Angle) at horizon
     double          riseSetApprox_d;// Improved estimate of rise or set time
+    double          targetEl_rad;// Unrefracted elevation at rise or set (rad)
 
     sun_nrelTopocentric(risesetGuess_d, deltas, site, topo);
     sky_siteAzElToHaDec(&topo->rectV, site, &ha1_rad, &dec_rad);
+    if (mask == NULL) {
+        targetEl_rad = SUN_RISESET_EL_RAD;
+    } else {
+        targetEl_rad = sky_horizonRiseSetEl_rad(mask, topo->azimuth_rad,
+                                                SUN_SEMIDIAMETER_RAD);
+    }
     
     /* assuming Dec remains constant over the period, find out where dec circle
-       intersects the Elevation = -50 arcminute circle */
-    cosHa2 = (sin(degToRad(-50.0/60.0)) - sin(site->astLat_rad) * sin(dec_rad))
+       intersects the Elevation = targetEl_rad (usually -50 arcminute) circle */
+    cosHa2 = (sin(targetEl_rad) - sin(site->astLat_rad) * sin(dec_rad))
              / (cos(site->astLat_rad) * cos(dec_rad));
     /* If there is no intersection, the Sun either doesn't rise or doesn't set
        on this day at this latitude.  */
+    if (found != NULL) {
+        *found = !((cosHa2 > 1.0) || (cosHa2 < -1.0));
+    }
     if (cosHa2 > 1.0) {
         /* Sun does not rise */
         riseSetApprox_d = 0.0;
@@ -944,3 +1636,32 @@ LOCAL double riseSetApprox(double             risesetGuess_d,
 }
 
 /*- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+/*! \page page-sun-precision Precision levels for the Sun's position
+ *  Function sun_nrelApp2() takes a \a precision argument which selects how
+ *  many terms of the NREL SPA series for the Sun's longitude, latitude and
+ *  distance are used, in the same way as the \a precision argument of
+ *  sky1_nutationIAU1980(). Function sun_setPrecision() selects the level used
+ *  by sun_nrelApparent(), sun_nrelApparentBatch() and sun_nrelTopocentric().
+ *
+ *  The following table shows the largest differences from the full series
+ *  found at 400 000 equally spaced times between 1900 and 2100, and the time
+ *  taken by each call, on a modern desktop processor. The full series is
+ *  itself only accurate to about 1 arcsecond.
+ *
+ *  Precision | Terms | Max direction error | Max distance error | sun_nrelApp2() | sun_nrelApparent()
+ *  :--------:|------:|--------------------:|-------------------:|---------------:|------------------:
+ *  0         | 195   | 0                   | 0                  | 3.6 µs         | 6.5 µs
+ *  1         | 87    | 0.65″               | 4e-6 AU            | 2.0 µs         | 3.7 µs
+ *  2         | 58    | 1.8″                | 7e-6 AU            | 0.9 µs         | 2.7 µs
+ *  3         | 29    | 4.6″                | 3e-5 AU            | 0.6 µs         | 2.7 µs
+ *  4         | 15    | 15″                 | 5e-5 AU            | 0.5 µs         | 2.5 µs
+ *
+ *  So for an application needing about 10 arcseconds, such as a heliostat
+ *  field, level 3 evaluates the Sun's series about 6 times faster than the full
+ *  series. Function sun_nrelApparent() also calculates the nutation (using
+ *  sky0_nutationSpa(), which always uses its full series), and that takes
+ *  about 2 µs, so sun_nrelApparent() itself becomes between 2 and 3 times
+ *  faster. If you need many positions, consider also the skyfast, skycheb or
+ *  sun_sweepInit() routines, which are faster again. (The sun_sweepInit() and
+ *  sun_sweepNext() routines always use the full series.)
+ */
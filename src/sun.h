@@ -58,6 +58,32 @@
 /*
  * Global #defines and typedefs
  */
+/*      Total number of periodic terms in the NREL SPA series for the Sun's
+        longitude (L0 - L5), latitude (B0 - B1) and distance (R0 - R4) */
+#define SUN_SERIES_TERM_COUNT 195
+
+/*      Number of precision levels accepted by sun_nrelApp2() and
+        sun_setPrecision() (0 = full series, up to this value minus 1) */
+#define SUN_PRECISION_LEVELS 5
+
+/*! Working storage for evaluating the Sun's position at a series of equally
+    spaced times, using functions sun_sweepInit() and sun_sweepNext(). The
+    caller must provide one of these structures, but should treat its contents
+    as private to those functions. */
+typedef struct {
+    double       start_cy;       //!< Time of first sample (J2000 cy, TT)
+    double       step_cy;        //!< Interval between samples (centuries)
+    long         sampleNum;      //!< Number of the next sample (0 = first)
+    int          reseedInterval; //!< Samples between recalculations of phases
+    int          sinceReseed;    //!< Samples since phases last recalculated
+    Sky0_Nut1980 nutStart;       //!< Nutation at the last recalculation
+    Sky0_Nut1980 nutEnd;         //!< Nutation at the next recalculation
+    double       cosPhase[SUN_SERIES_TERM_COUNT]; //!< cos(B + C*t) per term
+    double       sinPhase[SUN_SERIES_TERM_COUNT]; //!< sin(B + C*t) per term
+    double       cosStep[SUN_SERIES_TERM_COUNT];  //!< cos(C*step) per term
+    double       sinStep[SUN_SERIES_TERM_COUNT];  //!< sin(C*step) per term
+} Sun_Sweep;
+
 
 
 /*
@@ -71,11 +97,21 @@ void sun_aaApparentApprox(double n,
                           V3D_Vector *appV,
                           double     *dist_au);
 
+void sun_setPrecision(int precision);
 void sun_nrelApp2(double             t_cy,
+                  int                precision,
                   const Sky0_Nut1980 *nut,
                   V3D_Vector *appV,
                   double     *dist_au);
 void sun_nrelApparent(double j2kTT_cy, Sky_TrueEquatorial *pos);
+void sun_nrelApparentBatch(int                count,
+                           const double       j2kTT_cy[],
+                           Sky_TrueEquatorial pos[]);
+void sun_sweepInit(double    startTT_cy,
+                   double    step_d,
+                   int       reseedInterval,
+                   Sun_Sweep *sweep);
+void sun_sweepNext(Sun_Sweep *sweep, Sky_TrueEquatorial *pos);
 void sun_nrelTopocentric(double             j2kUtc_d,
                          const Sky_DeltaTs  *deltas,
                          const Sky_SiteProp *site,
@@ -94,6 +130,14 @@ double sun_riseSet(int                year,
                    const Sky_DeltaTs  *deltas,
                    const Sky_SiteProp *site,
                    Sky_SiteHorizon *topo);
+double sun_riseSetMask(int                   year,
+                       int                   month,
+                       int                   day,
+                       bool                  getSunrise,
+                       const Sky_DeltaTs     *deltas,
+                       const Sky_SiteProp    *site,
+                       const Sky_HorizonMask *mask,
+                       Sky_SiteHorizon       *topo);
 
 /*
  * Global variables accessible by other modules